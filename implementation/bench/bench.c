@@ -0,0 +1,683 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include <cionom.h>
+
+#include <genmemory.h>
+#include <genstring.h>
+#include <genlog.h>
+
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <stdio.h>
+#include <time.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+// Iteration counts are doubled until a measurement takes at least this long, in nanoseconds
+#ifndef CIO_BENCH_MINIMUM_TIME
+#define CIO_BENCH_MINIMUM_TIME 100000000
+#endif
+
+// Each benchmark is measured this many times and the median reported
+#ifndef CIO_BENCH_REPEATS
+#define CIO_BENCH_REPEATS 5
+#endif
+
+#define CIO_BENCH_STACK_LENGTH 4096
+
+// The number of statements in the body of generated benchmark routines
+#define CIO_BENCH_BODY_LENGTH 64
+
+// The number of routines branched through by the recursion benchmarks
+// Routine indices must stay below the reserved encoding `0x7F`, which leaves room for `?`, `copy=` and `bench`
+#define CIO_BENCH_RECURSION_DEPTH (CIO_OPERAND_MAX - 3)
+
+// The number of modules in the bundle loaded by the load benchmark
+#define CIO_BENCH_MODULES 64
+
+// The number of literal parameters to each call in the push benchmark
+#define CIO_BENCH_PUSHES 15
+
+// The length of the generated source tokenized by the tokenizer benchmarks
+#define CIO_BENCH_SOURCE_LENGTH (16 * 1024 * 1024)
+
+// The number of routines in the program emitted by the emission benchmark, the most a module can address
+#define CIO_BENCH_EMIT_ROUTINES (CIO_OPERAND_MAX - 1)
+
+// The number of calls in each routine of the program emitted by the emission benchmark
+#define CIO_BENCH_EMIT_CALLS 1024
+
+typedef struct {
+    cio_vm_t vm;
+    // The routine each iteration calls
+    cio_callable_t* routine;
+    // A parameter to pass to `routine`, if nonzero
+    gen_size_t parameter;
+
+    unsigned char* bytecode;
+    gen_size_t bytecode_length;
+
+    char* source;
+    cio_token_t* tokens;
+    gen_size_t tokens_length;
+
+    cio_program_t program;
+} cio_bench_state_t;
+
+typedef struct {
+    const char* name;
+    // What a single operation is
+    const char* unit;
+    // The number of operations per iteration
+    gen_size_t operations;
+
+    gen_error_t* (*prepare)(cio_bench_state_t* const restrict state);
+    gen_error_t* (*run)(cio_bench_state_t* const restrict state, const gen_size_t iterations);
+    gen_error_t* (*finish)(cio_bench_state_t* const restrict state);
+} cio_bench_t;
+
+static gen_size_t cio_bench_now(void) {
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (gen_size_t) now.tv_sec * 1000000000 + (gen_size_t) now.tv_nsec;
+}
+
+#define CIO_BENCH_APPEND(out, out_length, format, ...) \
+    do { \
+        gen_size_t formatted_length = 0; \
+        error = gen_string_format(GEN_STRING_NO_BOUNDS, GEN_NULL, &formatted_length, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        error = gen_memory_reallocate_zeroed((void**) out, *out ? *out_length + 1 : 0, *out_length + formatted_length + 1, sizeof(char)); \
+        if(error) return error; \
+        error = gen_string_format(formatted_length + 1, &(*out)[*out_length], GEN_NULL, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        *out_length += formatted_length; \
+    } while(0)
+
+static gen_error_t* cio_bench_compile(const char* const restrict source, const gen_size_t source_length, unsigned char** const restrict out_bytecode, gen_size_t* const restrict out_bytecode_length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_compile, GEN_FILE_NAME);
+    if(error) return error;
+
+    static const char source_file[] = "bench.cio";
+    const cio_warning_settings_t warning_settings = {0};
+
+    cio_token_t* tokens = GEN_NULL;
+    gen_size_t tokens_length = 0;
+    error = cio_tokenize(source, source_length, &tokens, &tokens_length);
+    if(error) return error;
+
+    cio_program_t program = {.arena = gen_true};
+    error = cio_parse(tokens, tokens_length, &program, source, source_length, source_file, sizeof(source_file) - 1, &warning_settings);
+    if(error) return error;
+
+    error = cio_module_emit(&program, out_bytecode, out_bytecode_length, source, source_length, source_file, sizeof(source_file) - 1, &warning_settings);
+    if(error) return error;
+
+    error = cio_program_free(&program);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &tokens);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+// Compiles `header`, followed by `count` repetitions of `statement` and the end of the routine `header` opens
+static gen_error_t* cio_bench_compile_repeated(const char* const restrict header, const char* const restrict statement, const gen_size_t count, unsigned char** const restrict out_bytecode, gen_size_t* const restrict out_bytecode_length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_compile_repeated, GEN_FILE_NAME);
+    if(error) return error;
+
+    char* source = GEN_NULL;
+    gen_size_t source_length = 0;
+
+    CIO_BENCH_APPEND(&source, &source_length, "%t", header);
+    for(gen_size_t i = 0; i < count; ++i) CIO_BENCH_APPEND(&source, &source_length, "    %t\n", statement);
+    CIO_BENCH_APPEND(&source, &source_length, ":\n");
+
+    error = cio_bench_compile(source, source_length, out_bytecode, out_bytecode_length);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &source);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+// Sets up a VM over the state's bytecode to call the routine `bench`
+static gen_error_t* cio_bench_initialize(cio_bench_state_t* const restrict state, const cio_vm_settings_t* const restrict settings) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_initialize, GEN_FILE_NAME);
+    if(error) return error;
+
+    const cio_warning_settings_t warning_settings = {0};
+    error = cio_vm_initialize(state->bytecode, state->bytecode_length, CIO_BENCH_STACK_LENGTH, gen_true, &state->vm, gen_false, &warning_settings, settings);
+    if(error) return error;
+
+    error = cio_vm_push_frame(&state->vm);
+    if(error) return error;
+    error = cio_vm_push(&state->vm);
+    if(error) return error;
+
+    error = cio_vm_get_identifier(&state->vm, "bench", &state->routine, gen_false);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_call(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_call, GEN_FILE_NAME);
+    if(error) return error;
+
+    cio_vm_t* const vm = &state->vm;
+    const cio_frame_t* const frame = &vm->frames[0];
+
+    for(gen_size_t i = 0; i < iterations; ++i) {
+        // The parameter is placed where the callee's frame will begin
+        if(state->parameter) vm->stack[frame->base + frame->height] = state->parameter;
+
+        vm->current_bytecode = state->routine->bytecode_index;
+        error = cio_vm_dispatch_call(vm, state->routine->routine_index, state->parameter ? 1 : 0);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_finish(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_finish, GEN_FILE_NAME);
+    if(error) return error;
+
+    if(state->vm.image) {
+        error = cio_vm_free(&state->vm);
+        if(error) return error;
+    }
+
+    if(state->bytecode) {
+        error = gen_memory_free((void**) &state->bytecode);
+        if(error) return error;
+    }
+
+    if(state->source) {
+        error = gen_memory_free((void**) &state->source);
+        if(error) return error;
+    }
+
+    if(state->tokens) {
+        error = gen_memory_free((void**) &state->tokens);
+        if(error) return error;
+    }
+
+    if(state->program.routines) {
+        error = cio_program_free(&state->program);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+// Statements executed by the interpreter without leaving the dispatch loop
+static gen_error_t* cio_bench_prepare_dispatch(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_dispatch, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_compile_repeated("copy= 2\n\nbench 0\n:\n", "copy= 0 1", CIO_BENCH_BODY_LENGTH, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    return cio_bench_initialize(state, GEN_NULL);
+}
+
+// Calls to external routines through the extlib rather than as intrinsics
+static gen_error_t* cio_bench_prepare_extlib(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_extlib, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_compile_repeated("copy= 2\n\nbench 0\n:\n", "copy= 0 1", CIO_BENCH_BODY_LENGTH, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    const cio_vm_settings_t settings = {.no_intrinsics = gen_true};
+    return cio_bench_initialize(state, &settings);
+}
+
+static gen_error_t* cio_bench_prepare_call(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_call, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_compile_repeated("nop 0\n:\n:\n\nbench 0\n:\n", "nop", CIO_BENCH_BODY_LENGTH, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    return cio_bench_initialize(state, GEN_NULL);
+}
+
+static gen_error_t* cio_bench_prepare_call_trampoline(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_call_trampoline, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_compile_repeated("nop 0\n:\n:\n\nbench 0\n:\n", "nop", CIO_BENCH_BODY_LENGTH, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    const cio_vm_settings_t settings = {.trampoline = gen_true};
+    return cio_bench_initialize(state, &settings);
+}
+
+static gen_error_t* cio_bench_prepare_push(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_push, GEN_FILE_NAME);
+    if(error) return error;
+
+    char* statement = GEN_NULL;
+    gen_size_t statement_length = 0;
+    CIO_BENCH_APPEND(&statement, &statement_length, "sink");
+    for(gen_size_t i = 0; i < CIO_BENCH_PUSHES; ++i) CIO_BENCH_APPEND(&statement, &statement_length, " %uz", i);
+
+    error = cio_bench_compile_repeated("sink 15\n:\n:\n\nbench 0\n:\n", statement, CIO_BENCH_BODY_LENGTH / 4, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &statement);
+    if(error) return error;
+
+    return cio_bench_initialize(state, GEN_NULL);
+}
+
+// A chain of routines which each branch to the next with `?`
+static gen_error_t* cio_bench_compile_branch_chain(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_compile_branch_chain, GEN_FILE_NAME);
+    if(error) return error;
+
+    char* source = GEN_NULL;
+    gen_size_t source_length = 0;
+
+    // `?` and `copy=` are routines 0 and 1, so the routine at each depth is 2 more than it
+    CIO_BENCH_APPEND(&source, &source_length, "? 3\ncopy= 2\n\n");
+    for(gen_size_t i = 0; i < CIO_BENCH_RECURSION_DEPTH; ++i) {
+        CIO_BENCH_APPEND(&source, &source_length, "depth%uz 0\n:\n    copy= 0 1\n", i);
+        if(i + 1 < CIO_BENCH_RECURSION_DEPTH) CIO_BENCH_APPEND(&source, &source_length, "    ? %uz %uz 0\n", i + 3, i + 3);
+        CIO_BENCH_APPEND(&source, &source_length, ":\n\n");
+    }
+    CIO_BENCH_APPEND(&source, &source_length, "bench 0\n:\n    depth0\n:\n");
+
+    error = cio_bench_compile(source, source_length, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &source);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_prepare_branch(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_branch, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_compile_branch_chain(state);
+    if(error) return error;
+
+    return cio_bench_initialize(state, GEN_NULL);
+}
+
+static gen_error_t* cio_bench_prepare_branch_trampoline(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_branch_trampoline, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_compile_branch_chain(state);
+    if(error) return error;
+
+    const cio_vm_settings_t settings = {.trampoline = gen_true};
+    return cio_bench_initialize(state, &settings);
+}
+
+static gen_error_t* cio_bench_prepare_callv(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_callv, GEN_FILE_NAME);
+    if(error) return error;
+
+    // `nop` is routine 2
+    error = cio_bench_compile_repeated("callv 1\ncopy= 2\n\nnop 0\n:\n:\n\nbench 0\n:\n    copy= 0 2\n", "callv 0", CIO_BENCH_BODY_LENGTH, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    return cio_bench_initialize(state, GEN_NULL);
+}
+
+static gen_error_t* cio_bench_prepare_rcall(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_rcall, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_compile_repeated("rcall* 1\n\nnop 0\n:\n:\n\nbench 1\n:\n", "rcall* 0", CIO_BENCH_BODY_LENGTH, &state->bytecode, &state->bytecode_length);
+    if(error) return error;
+
+    static const char symbol[] = "nop";
+    state->parameter = (gen_size_t) symbol;
+
+    return cio_bench_initialize(state, GEN_NULL);
+}
+
+// A bundle of modules which each call into the next
+static gen_error_t* cio_bench_prepare_load(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_load, GEN_FILE_NAME);
+    if(error) return error;
+
+    for(gen_size_t i = 0; i < CIO_BENCH_MODULES; ++i) {
+        char* source = GEN_NULL;
+        gen_size_t source_length = 0;
+
+        if(i + 1 < CIO_BENCH_MODULES) CIO_BENCH_APPEND(&source, &source_length, "module%uz 0\n\nmodule%uz 0\n:\n    module%uz\n:\n", i + 1, i, i + 1);
+        else CIO_BENCH_APPEND(&source, &source_length, "copy= 2\n\nmodule%uz 0\n:\n    copy= 0 1\n:\n", i);
+        if(!i) CIO_BENCH_APPEND(&source, &source_length, "\nbench 0\n:\n    module0\n:\n");
+
+        unsigned char* bytecode = GEN_NULL;
+        gen_size_t bytecode_length = 0;
+        error = cio_bench_compile(source, source_length, &bytecode, &bytecode_length);
+        if(error) return error;
+
+        error = gen_memory_reallocate_zeroed((void**) &state->bytecode, state->bytecode_length, state->bytecode_length + bytecode_length, sizeof(unsigned char));
+        if(error) return error;
+
+        error = gen_memory_copy(&state->bytecode[state->bytecode_length], bytecode_length, bytecode, bytecode_length, bytecode_length);
+        if(error) return error;
+        state->bytecode_length += bytecode_length;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &source);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_run_load(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_run_load, GEN_FILE_NAME);
+    if(error) return error;
+
+    const cio_warning_settings_t warning_settings = {0};
+    for(gen_size_t i = 0; i < iterations; ++i) {
+        cio_vm_t vm = {0};
+        error = cio_vm_initialize(state->bytecode, state->bytecode_length, CIO_BENCH_STACK_LENGTH, gen_true, &vm, gen_false, &warning_settings, GEN_NULL);
+        if(error) return error;
+
+        error = cio_vm_free(&vm);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+// Clones of a VM which has already run its program
+static gen_error_t* cio_bench_prepare_clone(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_clone, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_prepare_dispatch(state);
+    if(error) return error;
+
+    return cio_bench_call(state, 1);
+}
+
+static gen_error_t* cio_bench_run_clone(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_run_clone, GEN_FILE_NAME);
+    if(error) return error;
+
+    for(gen_size_t i = 0; i < iterations; ++i) {
+        cio_vm_t clone = {0};
+        error = cio_vm_clone(&state->vm, &clone);
+        if(error) return error;
+
+        error = cio_vm_free(&clone);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+// A large source resembling generated code, padded with whitespace to exactly `CIO_BENCH_SOURCE_LENGTH` bytes
+static gen_error_t* cio_bench_prepare_tokenize(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_tokenize, GEN_FILE_NAME);
+    if(error) return error;
+
+    gen_size_t source_length = 0;
+    for(gen_size_t i = 0; source_length < CIO_BENCH_SOURCE_LENGTH; ++i) {
+        const gen_size_t routine_offset = source_length;
+        CIO_BENCH_APPEND(&state->source, &source_length, "generated_routine_%uz 2\n:\n    copy= 0 1\n    generated_routine_%uz 127 %uz\n    ? 3 4 0\n:\n\n", i, i / 2, i % 100);
+
+        if(source_length > CIO_BENCH_SOURCE_LENGTH) {
+            error = gen_memory_set(&state->source[routine_offset], source_length - routine_offset, '\n');
+            if(error) return error;
+        }
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_prepare_parse(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_parse, GEN_FILE_NAME);
+    if(error) return error;
+
+    error = cio_bench_prepare_tokenize(state);
+    if(error) return error;
+
+    return cio_tokenize(state->source, CIO_BENCH_SOURCE_LENGTH, &state->tokens, &state->tokens_length);
+}
+
+static gen_error_t* cio_bench_parse(cio_bench_state_t* const restrict state, const gen_size_t iterations, const gen_bool_t arena) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_parse, GEN_FILE_NAME);
+    if(error) return error;
+
+    static const char source_file[] = "bench.cio";
+    const cio_warning_settings_t warning_settings = {0};
+
+    for(gen_size_t i = 0; i < iterations; ++i) {
+        cio_program_t program = {.arena = arena};
+        error = cio_parse(state->tokens, state->tokens_length, &program, state->source, CIO_BENCH_SOURCE_LENGTH, source_file, sizeof(source_file) - 1, &warning_settings);
+        if(error) return error;
+
+        error = cio_program_free(&program);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_run_parse(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_run_parse, GEN_FILE_NAME);
+    if(error) return error;
+
+    return cio_bench_parse(state, iterations, gen_false);
+}
+
+static gen_error_t* cio_bench_run_parse_arena(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_run_parse_arena, GEN_FILE_NAME);
+    if(error) return error;
+
+    return cio_bench_parse(state, iterations, gen_true);
+}
+
+// A program of as many routines as a module can address, each calling the others round-robin
+static gen_error_t* cio_bench_prepare_emit(cio_bench_state_t* const restrict state) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_prepare_emit, GEN_FILE_NAME);
+    if(error) return error;
+
+    static const char source_file[] = "bench.cio";
+    const cio_warning_settings_t warning_settings = {0};
+
+    gen_size_t source_length = 0;
+    for(gen_size_t i = 0; i < CIO_BENCH_EMIT_ROUTINES; ++i) {
+        CIO_BENCH_APPEND(&state->source, &source_length, "generated_routine_%uz 2\n:\n", i);
+        for(gen_size_t j = 0; j < CIO_BENCH_EMIT_CALLS; ++j) CIO_BENCH_APPEND(&state->source, &source_length, "    generated_routine_%uz 1 %uz\n", (i + j) % CIO_BENCH_EMIT_ROUTINES, j % 100);
+        CIO_BENCH_APPEND(&state->source, &source_length, ":\n\n");
+    }
+
+    error = cio_tokenize(state->source, source_length, &state->tokens, &state->tokens_length);
+    if(error) return error;
+
+    state->program.arena = gen_true;
+    return cio_parse(state->tokens, state->tokens_length, &state->program, state->source, source_length, source_file, sizeof(source_file) - 1, &warning_settings);
+}
+
+static gen_error_t* cio_bench_run_emit(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_run_emit, GEN_FILE_NAME);
+    if(error) return error;
+
+    static const char source_file[] = "bench.cio";
+    const cio_warning_settings_t warning_settings = {0};
+
+    gen_size_t source_length = 0;
+    error = gen_string_length(state->source, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &source_length);
+    if(error) return error;
+
+    for(gen_size_t i = 0; i < iterations; ++i) {
+        unsigned char* bytecode = GEN_NULL;
+        gen_size_t bytecode_length = 0;
+        error = cio_module_emit(&state->program, &bytecode, &bytecode_length, state->source, source_length, source_file, sizeof(source_file) - 1, &warning_settings);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_run_tokenize(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_run_tokenize, GEN_FILE_NAME);
+    if(error) return error;
+
+    for(gen_size_t i = 0; i < iterations; ++i) {
+        cio_token_t* tokens = GEN_NULL;
+        gen_size_t tokens_length = 0;
+        error = cio_tokenize(state->source, CIO_BENCH_SOURCE_LENGTH, &tokens, &tokens_length);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &tokens);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_bench_run_tokenize_packed(cio_bench_state_t* const restrict state, const gen_size_t iterations) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_run_tokenize_packed, GEN_FILE_NAME);
+    if(error) return error;
+
+    for(gen_size_t i = 0; i < iterations; ++i) {
+        cio_packed_token_t* tokens = GEN_NULL;
+        gen_size_t tokens_length = 0;
+        error = cio_tokenize_packed(state->source, CIO_BENCH_SOURCE_LENGTH, &tokens, &tokens_length);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &tokens);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static const cio_bench_t cio_bench_benchmarks[] = {
+    {"dispatch", "statement", CIO_BENCH_BODY_LENGTH, cio_bench_prepare_dispatch, cio_bench_call, cio_bench_finish},
+    {"push", "push", (CIO_BENCH_BODY_LENGTH / 4) * CIO_BENCH_PUSHES, cio_bench_prepare_push, cio_bench_call, cio_bench_finish},
+    {"call", "call", CIO_BENCH_BODY_LENGTH, cio_bench_prepare_call, cio_bench_call, cio_bench_finish},
+    {"call_trampoline", "call", CIO_BENCH_BODY_LENGTH, cio_bench_prepare_call_trampoline, cio_bench_call, cio_bench_finish},
+    {"branch_recursion", "branch", CIO_BENCH_RECURSION_DEPTH - 1, cio_bench_prepare_branch, cio_bench_call, cio_bench_finish},
+    {"branch_recursion_trampoline", "branch", CIO_BENCH_RECURSION_DEPTH - 1, cio_bench_prepare_branch_trampoline, cio_bench_call, cio_bench_finish},
+    {"callv", "call", CIO_BENCH_BODY_LENGTH, cio_bench_prepare_callv, cio_bench_call, cio_bench_finish},
+    {"rcall", "call", CIO_BENCH_BODY_LENGTH, cio_bench_prepare_rcall, cio_bench_call, cio_bench_finish},
+    {"extlib_call", "call", CIO_BENCH_BODY_LENGTH, cio_bench_prepare_extlib, cio_bench_call, cio_bench_finish},
+    {"bundle_load", "load", 1, cio_bench_prepare_load, cio_bench_run_load, cio_bench_finish},
+    {"clone", "clone", 1, cio_bench_prepare_clone, cio_bench_run_clone, cio_bench_finish},
+    {"tokenize", "byte", CIO_BENCH_SOURCE_LENGTH, cio_bench_prepare_tokenize, cio_bench_run_tokenize, cio_bench_finish},
+    {"tokenize_packed", "byte", CIO_BENCH_SOURCE_LENGTH, cio_bench_prepare_tokenize, cio_bench_run_tokenize_packed, cio_bench_finish},
+    {"parse", "byte", CIO_BENCH_SOURCE_LENGTH, cio_bench_prepare_parse, cio_bench_run_parse, cio_bench_finish},
+    {"parse_arena", "byte", CIO_BENCH_SOURCE_LENGTH, cio_bench_prepare_parse, cio_bench_run_parse_arena, cio_bench_finish},
+    {"emit", "call", CIO_BENCH_EMIT_ROUTINES * CIO_BENCH_EMIT_CALLS, cio_bench_prepare_emit, cio_bench_run_emit, cio_bench_finish}
+};
+
+// Finds an iteration count which runs for at least `CIO_BENCH_MINIMUM_TIME`, then takes the median of several runs of it
+static gen_error_t* cio_bench_measure(const cio_bench_t* const restrict bench, gen_size_t* const restrict out_iterations, gen_size_t* const restrict out_elapsed) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_bench_measure, GEN_FILE_NAME);
+    if(error) return error;
+
+    cio_bench_state_t state = {0};
+    error = bench->prepare(&state);
+    if(error) return error;
+
+    // Warm up caches and any lazily initialized extlib state
+    error = bench->run(&state, 1);
+    if(error) return error;
+
+    gen_size_t iterations = 1;
+    while(gen_true) {
+        const gen_size_t start = cio_bench_now();
+        error = bench->run(&state, iterations);
+        if(error) return error;
+
+        if(cio_bench_now() - start >= CIO_BENCH_MINIMUM_TIME) break;
+        iterations *= 2;
+    }
+
+    gen_size_t elapsed[CIO_BENCH_REPEATS] = {0};
+    for(gen_size_t i = 0; i < CIO_BENCH_REPEATS; ++i) {
+        const gen_size_t start = cio_bench_now();
+        error = bench->run(&state, iterations);
+        if(error) return error;
+        const gen_size_t time = cio_bench_now() - start;
+
+        gen_size_t j = i;
+        for(; j && elapsed[j - 1] > time; --j) elapsed[j] = elapsed[j - 1];
+        elapsed[j] = time;
+    }
+
+    error = bench->finish(&state);
+    if(error) return error;
+
+    *out_iterations = iterations;
+    *out_elapsed = elapsed[CIO_BENCH_REPEATS / 2];
+
+    return GEN_NULL;
+}
+
+static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict* const restrict argv) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) gen_main, GEN_FILE_NAME);
+    if(error) return error;
+
+    // Benchmarks may be selected by name, otherwise all are run
+    printf("{\n    \"benchmarks\": [");
+
+    gen_bool_t first = gen_true;
+    for(gen_size_t i = 0; i < sizeof(cio_bench_benchmarks) / sizeof(cio_bench_benchmarks[0]); ++i) {
+        const cio_bench_t* const bench = &cio_bench_benchmarks[i];
+
+        gen_bool_t selected = argc < 2;
+        for(gen_size_t j = 1; j < argc && !selected; ++j) {
+            error = gen_string_compare(argv[j], GEN_STRING_NO_BOUNDS, bench->name, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &selected);
+            if(error) return error;
+        }
+        if(!selected) continue;
+
+        gen_size_t iterations = 0;
+        gen_size_t elapsed = 0;
+        error = cio_bench_measure(bench, &iterations, &elapsed);
+        if(error) return error;
+
+        const double operations = (double) iterations * (double) bench->operations;
+        const double ns_per_op = (double) elapsed / operations;
+
+        printf("%s\n        {\"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %zu, \"operations\": %.0f, \"ns_per_op\": %.3f, \"ops_per_s\": %.0f}", first ? "" : ",", bench->name, bench->unit, (size_t) iterations, operations, ns_per_op, 1e9 / ns_per_op);
+        fflush(stdout);
+        first = gen_false;
+    }
+
+    printf("\n    ]\n}\n");
+
+    return GEN_NULL;
+}
+
+int main(const int argc, const char* const* const argv) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) main, GEN_FILE_NAME);
+	if(error) {
+        gen_error_print("cionom-bench", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+
+    error = gen_main((gen_size_t) argc, argv);
+    if(error) {
+        gen_error_print("cionom-bench", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
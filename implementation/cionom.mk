@@ -17,26 +17,30 @@ CIONOM_LIB_CFLAGS = $(GEN_CORE_CFLAGS) -I$(CIONOM_DIR)/implementation/cionom/inc
 CIONOM_LIB_LFLAGS = $(GEN_CORE_LFLAGS) -lcionom
 CIONOM_LIB_LIBDIRS = $(GEN_CORE_LIBDIRS) $(CIONOM_DIR)/lib
 
-CIONOM_DIAGNOSTIC_CFLAGS = $(GEN_CORE_DIAGNOSTIC_CFLAGS) -Wno-gnu-binary-literal -Wno-c++-compat -Wno-gnu-empty-struct
+CIONOM_DIAGNOSTIC_CFLAGS = $(GEN_CORE_DIAGNOSTIC_CFLAGS) -Wno-gnu-binary-literal -Wno-c++-compat -Wno-gnu-empty-struct -Wno-gnu-label-as-value
+
+# Execution statistics cost the interpreter a few percent, so are only counted in builds made with `CIONOM_STATS=1`
+CIONOM_STATS ?= 0
+CIONOM_STATS_CFLAGS = -DCIO_VM_STATS=$(CIONOM_STATS)
 
 $(CIONOM_DIR)/lib:
 	@$(ECHO) "$(ACTION_PREFIX)$(MKDIR) $@$(ACTION_SUFFIX)"
 	-@$(MKDIR) $@
 
-$(CIONOM_LIB): CFLAGS = $(GEN_CORE_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_COMMON_CFLAGS)
+$(CIONOM_LIB): CFLAGS = $(GEN_CORE_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_STATS_CFLAGS) $(CIONOM_COMMON_CFLAGS)
 $(CIONOM_LIB): LFLAGS = $(GEN_CORE_LFLAGS) $(CIONOM_COMMON_LFLAGS)
 $(CIONOM_LIB): LIBDIRS = $(CIONOM_LIB_LIBDIRS)
 $(CIONOM_LIB): SANITIZERS = $(CIONOM_SANITIZERS)
 $(CIONOM_LIB): $(CIONOM_LIB_OBJECTS) $(GEN_CORE_LIB) | $(CIONOM_DIR)/lib
 
-$(CIONOM_EXEC): CFLAGS = $(CIONOM_LIB_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_COMMON_CFLAGS) -DCIO_CLI_VERSION="\"@$(shell $(GIT) rev-parse --short HEAD)\""
+$(CIONOM_EXEC): CFLAGS = $(CIONOM_LIB_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_STATS_CFLAGS) $(CIONOM_COMMON_CFLAGS) -DCIO_CLI_VERSION="\"@$(shell $(GIT) rev-parse --short HEAD)\""
 $(CIONOM_EXEC): LFLAGS = $(CIONOM_LIB_LFLAGS) $(CIONOM_COMMON_LFLAGS)
 $(CIONOM_EXEC): LIBDIRS = $(CIONOM_LIB_LIBDIRS)
 $(CIONOM_EXEC): SANITIZERS = $(CIONOM_SANITIZERS)
 $(CIONOM_EXEC): $(CIONOM_EXEC_OBJECTS) $(CIONOM_LIB) $(CIONOM_EXTERNAL)
 
-$(CIONOM_EXTERNAL): CFLAGS = $(CIONOM_LIB_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_COMMON_CFLAGS)
-$(CIONOM_EXTERNAL): LFLAGS = $(CIONOM_LIB_LFLAGS) $(CIONOM_COMMON_LFLAGS)
+$(CIONOM_EXTERNAL): CFLAGS = $(CIONOM_LIB_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_STATS_CFLAGS) $(CIONOM_COMMON_CFLAGS)
+$(CIONOM_EXTERNAL): LFLAGS = $(CIONOM_LIB_LFLAGS) $(CIONOM_COMMON_LFLAGS) -lpthread
 $(CIONOM_EXTERNAL): LIBDIRS = $(CIONOM_LIB_LIBDIRS)
 $(CIONOM_EXTERNAL): SANITIZERS = $(CIONOM_SANITIZERS)
 $(CIONOM_EXTERNAL): $(CIONOM_EXTERNAL_OBJECTS) $(CIONOM_LIB)
@@ -53,12 +57,47 @@ test_cionom: $(CIONOM_TEST_EXEC)
 	@$(ECHO) "$(ACTION_PREFIX)$(CIONOM_TEST_EXEC)$(ACTION_SUFFIX)"
 	@$(CIONOM_TEST_EXEC)
 
-$(CIONOM_TEST_EXEC): CFLAGS = $(GEN_TESTS_CFLAGS) -DGEN_TESTS_NAME=\"cionom-test\" $(CIONOM_LIB_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_COMMON_CFLAGS) -DCIO_CLI_VERSION="\"@$(shell $(GIT) rev-parse --short HEAD)\""
+$(CIONOM_TEST_EXEC): CFLAGS = $(GEN_TESTS_CFLAGS) -DGEN_TESTS_NAME=\"cionom-test\" $(CIONOM_LIB_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_STATS_CFLAGS) $(CIONOM_COMMON_CFLAGS) -DCIO_CLI_VERSION="\"@$(shell $(GIT) rev-parse --short HEAD)\""
 $(CIONOM_TEST_EXEC): LFLAGS = $(GEN_TESTS_LFLAGS) $(CIONOM_LIB_LFLAGS) $(CIONOM_COMMON_LFLAGS) -lcionom-external
 $(CIONOM_TEST_EXEC): LIBDIRS = $(CIONOM_LIB_LIBDIRS) $(GEN_TESTS_LIBDIRS)
 $(CIONOM_TEST_EXEC): SANITIZERS = $(CIONOM_SANITIZERS)
 $(CIONOM_TEST_EXEC): $(CIONOM_TEST_OBJECTS) $(CIONOM_EXTERNAL) $(CIONOM_LIB) $(GEN_TESTS_LIB)
 
+CIONOM_BENCH_SOURCES = $(wildcard $(CIONOM_DIR)/implementation/bench/*.c)
+CIONOM_BENCH_OBJECTS = $(CIONOM_BENCH_SOURCES:.c=$(OBJECT_SUFFIX))
+CIONOM_BENCH_EXEC = $(CIONOM_DIR)/implementation/bench/cionom_bench$(EXECUTABLE_SUFFIX)
+
+.PHONY: bench_cionom
+bench_cionom: $(CIONOM_BENCH_EXEC)
+	@$(ECHO) "$(ACTION_PREFIX)$(CIONOM_BENCH_EXEC)$(ACTION_SUFFIX)"
+	@$(CIONOM_BENCH_EXEC)
+
+# Benchmarks are built without sanitizers so that timings reflect the library as shipped
+$(CIONOM_BENCH_EXEC): CFLAGS = $(CIONOM_LIB_CFLAGS) $(CIONOM_DIAGNOSTIC_CFLAGS) $(CIONOM_STATS_CFLAGS) $(CIONOM_COMMON_CFLAGS)
+$(CIONOM_BENCH_EXEC): LFLAGS = $(CIONOM_LIB_LFLAGS) $(CIONOM_COMMON_LFLAGS) -lcionom-external
+$(CIONOM_BENCH_EXEC): LIBDIRS = $(CIONOM_LIB_LIBDIRS)
+$(CIONOM_BENCH_EXEC): $(CIONOM_BENCH_OBJECTS) $(CIONOM_EXTERNAL) $(CIONOM_LIB)
+
+CIONOM_PARITY_DIR = $(CIONOM_DIR)/implementation/test/parity
+CIONOM_PARITY_INPUT = 12 30\nhello\n42\n
+
+# Runs each Rosetta example through the interpreter and through the C backend, and fails if their output or exit status differ
+# Programs run from within the output directory so that files they create are kept there
+# The examples are listed with `find` rather than `wildcard` as their names contain spaces, and those which are still empty are skipped
+.PHONY: parity_cionom
+parity_cionom: $(CIONOM_EXEC) $(CIONOM_EXTERNAL) $(CIONOM_LIB)
+	-@$(MKDIR) $(CIONOM_PARITY_DIR)
+	@find $(CIONOM_DIR)/examples/rosetta -name '*.cio' -size +0 | sort | while IFS= read -r source; do \
+		name="$(abspath $(CIONOM_PARITY_DIR))/$$(basename "$$source" .cio | tr ' +' '__')"; \
+		$(ECHO) "$(ACTION_PREFIX)$$source$(ACTION_SUFFIX)"; \
+		$(CIONOM_EXEC) --emit-bytecode="$$name.ibc" "$$source" > /dev/null || exit 1; \
+		$(CIONOM_EXEC) --emit-c="$$name.c" "$$name.ibc" > /dev/null || exit 1; \
+		$(CC) $(CIONOM_LIB_CFLAGS) -o "$$name$(EXECUTABLE_SUFFIX)" "$$name.c" $(addprefix -L,$(CIONOM_LIB_LIBDIRS)) $(CIONOM_LIB_LFLAGS) -lcionom-external || exit 1; \
+		(cd $(CIONOM_PARITY_DIR) && printf '$(CIONOM_PARITY_INPUT)' | $(abspath $(CIONOM_EXEC)) --execute-bundle "$$name.ibc" > "$$name.interpreted" 2> /dev/null; echo "exit $$?" >> "$$name.interpreted"); \
+		(cd $(CIONOM_PARITY_DIR) && printf '$(CIONOM_PARITY_INPUT)' | "$$name$(EXECUTABLE_SUFFIX)" > "$$name.compiled" 2> /dev/null; echo "exit $$?" >> "$$name.compiled"); \
+		diff "$$name.interpreted" "$$name.compiled" || exit 1; \
+	done
+
 .PHONY: clean_cionom
 clean_cionom:
 	@$(ECHO) "$(ACTION_PREFIX)"
@@ -70,4 +109,7 @@ clean_cionom:
 	-$(RM) $(CIONOM_EXTERNAL)
 	-$(RM) $(CIONOM_TEST_OBJECTS)
 	-$(RM) $(CIONOM_TEST_EXEC)
+	-$(RM) $(CIONOM_BENCH_OBJECTS)
+	-$(RM) $(CIONOM_BENCH_EXEC)
+	-$(RM) $(CIONOM_PARITY_DIR)/*
 	@$(ECHO) "$(ACTION_SUFFIX)"
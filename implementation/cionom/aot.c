@@ -0,0 +1,394 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/cionom.h"
+
+#include <genmemory.h>
+#include <genstring.h>
+
+extern gen_error_t* cio_vm_internal_translatable(const cio_vm_t* const restrict vm, const cio_bytecode_t* const restrict module, const gen_size_t offset, gen_bool_t* const restrict out_translatable);
+
+// Support code for generated programs
+// Frames are manipulated exactly as the interpreter would so that external routines see the same VM state
+// Generated programs always run with the default VM settings
+static const char cio_vm_internal_emit_c_prelude[] =
+    "// Generated by `cionom-cli --emit-c` - do not edit\n"
+    "\n"
+    "#include <cionom.h>\n"
+    "\n"
+    "typedef struct {\n"
+    "    cio_routine_function_t function;\n"
+    "    cio_fast_routine_function_t fast;\n"
+    "} cio_aot_binding_t;\n"
+    "\n"
+    "static gen_error_t* cio_aot_stack_overflow(void) {\n"
+    "    return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, \"Stack overflow\");\n"
+    "}\n"
+    "\n"
+    "static gen_error_t* cio_aot_frames_exhausted(void) {\n"
+    "    return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, \"No unused frames available to push\");\n"
+    "}\n"
+    "\n"
+    "static inline void cio_aot_mark_high_water(cio_vm_t* const restrict vm, const cio_frame_t* const restrict frame, const gen_size_t height) {\n"
+    "    if(frame->base + height > vm->stack_high_water) vm->stack_high_water = frame->base + height;\n"
+    "}\n"
+    "\n"
+    "static inline gen_error_t* cio_aot_call(cio_vm_t* const restrict vm, cio_frame_t* const restrict frame, gen_size_t* const restrict height, const gen_size_t argc, const gen_size_t offset, const gen_size_t bytecode_index, const gen_size_t target_offset, const cio_routine_function_t function, const cio_fast_routine_function_t fast, const gen_bool_t wrap) {\n"
+    "    cio_aot_mark_high_water(vm, frame, *height);\n"
+    "    if(vm->frames_used >= vm->frames_length) return cio_aot_frames_exhausted();\n"
+    "\n"
+    "    frame->height = *height - argc;\n"
+    "    frame->execution_offset = offset;\n"
+    "\n"
+    "    // Frames are counted once written, as the sampler may read them at any point\n"
+    "    cio_frame_t* const callee = &vm->frames[vm->frames_used];\n"
+    "    callee->base = frame->base + frame->height;\n"
+    "    callee->height = argc;\n"
+    "    callee->execution_offset = target_offset;\n"
+    "    callee->bytecode_index = bytecode_index;\n"
+    "    __atomic_signal_fence(__ATOMIC_SEQ_CST);\n"
+    "    ++vm->frames_used;\n"
+    "    vm->current_bytecode = bytecode_index;\n"
+    "\n"
+    "    if(fast) {\n"
+    "        const cio_status_t status = fast(vm, &vm->stack[callee->base], &vm->stack[frame->base], frame);\n"
+    "        if(status) {\n"
+    "            gen_error_t* const error = cio_vm_raise_status(vm, status);\n"
+    "            if(error) return error;\n"
+    "        }\n"
+    "    }\n"
+    "    else {\n"
+    "        gen_error_t* const error = wrap && vm->external_lib_call_wrapper ? vm->external_lib_call_wrapper(vm, function) : function(vm);\n"
+    "        if(error) return error;\n"
+    "    }\n"
+    "\n"
+    "    // The routine may have replaced its own frame (e.g. `callv`)\n"
+    "    --vm->frames_used;\n"
+    "    __atomic_signal_fence(__ATOMIC_SEQ_CST);\n"
+    "    vm->frames[vm->frames_used] = (cio_frame_t) {0};\n"
+    "    vm->current_bytecode = frame->bytecode_index;\n"
+    "\n"
+    "    *height = frame->height;\n"
+    "    return GEN_NULL;\n"
+    "}\n"
+    "\n"
+    "static inline gen_error_t* cio_aot_intrinsic(cio_vm_t* const restrict vm, const cio_frame_t* const restrict frame, gen_size_t* const restrict height, const gen_size_t argc) {\n"
+    "    if(vm->frames_used >= vm->frames_length) return cio_aot_frames_exhausted();\n"
+    "\n"
+    "    cio_aot_mark_high_water(vm, frame, *height);\n"
+    "    *height -= argc;\n"
+    "    return GEN_NULL;\n"
+    "}\n"
+    "\n"
+    "static inline void cio_aot_return(cio_vm_t* const restrict vm, cio_frame_t* const restrict frame, const gen_size_t height, const gen_size_t offset) {\n"
+    "    cio_aot_mark_high_water(vm, frame, height);\n"
+    "    frame->height = height;\n"
+    "    frame->execution_offset = offset;\n"
+    "}\n";
+
+static const char cio_vm_internal_emit_c_main[] =
+    "static gen_error_t* cio_aot_main(void) {\n"
+    "    static cio_vm_t vm = {0};\n"
+    "    static const cio_warning_settings_t warning_settings = {0};\n"
+    "    gen_error_t* error = cio_vm_initialize(cio_aot_bytecode, sizeof(cio_aot_bytecode), CIO_AOT_STACK_LENGTH, gen_true, &vm, gen_false, &warning_settings, GEN_NULL);\n"
+    "    if(error) return error;\n"
+    "\n"
+    "    // Routines which are only reachable through the interpreter (e.g. via `callv`) still see the generated and linked routines\n"
+    "    for(gen_size_t i = 0; i < vm.callables_length; ++i) {\n"
+    "        if(cio_aot_bindings[i].function) vm.dispatch[i].function = cio_aot_bindings[i].function;\n"
+    "        if(cio_aot_bindings[i].fast) vm.dispatch[i].fast = cio_aot_bindings[i].fast;\n"
+    "    }\n"
+    "\n"
+    "    error = cio_vm_push_frame(&vm);\n"
+    "    if(error) return error;\n"
+    "    error = cio_vm_push(&vm);\n"
+    "    if(error) return error;\n"
+    "\n"
+    "    cio_callable_t* callable = GEN_NULL;\n"
+    "    error = cio_vm_get_identifier(&vm, CIO_AOT_ENTRY_ROUTINE, &callable, gen_false);\n"
+    "    if(error) return error;\n"
+    "\n"
+    "    vm.current_bytecode = callable->bytecode_index;\n"
+    "    return cio_vm_dispatch_call(&vm, callable->routine_index, 0);\n"
+    "}\n"
+    "\n"
+    "int main(void) {\n"
+    "    gen_error_t* const error = cio_aot_main();\n"
+    "    if(error) {\n"
+    "        gen_error_print(\"cionom\", error, GEN_ERROR_SEVERITY_FATAL);\n"
+    "        gen_error_abort();\n"
+    "    }\n"
+    "\n"
+    "    return 0;\n"
+    "}\n";
+
+// Core routines which are executed inline, as the interpreter's intrinsics are
+typedef enum {
+    CIO_VM_INTERNAL_EMIT_C_INTRINSIC_NONE,
+    CIO_VM_INTERNAL_EMIT_C_INTRINSIC_ADD,
+    CIO_VM_INTERNAL_EMIT_C_INTRINSIC_SUBTRACT,
+    CIO_VM_INTERNAL_EMIT_C_INTRINSIC_COPY,
+    CIO_VM_INTERNAL_EMIT_C_INTRINSIC_COPY_VARIABLE,
+    CIO_VM_INTERNAL_EMIT_C_INTRINSIC_STORE_CHAR
+} cio_vm_internal_emit_c_intrinsic_t;
+
+static gen_error_t* cio_vm_internal_emit_c_append(char** const restrict out_source, gen_size_t* const restrict out_source_length, const char* const restrict text, const gen_size_t text_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_emit_c_append, GEN_FILE_NAME);
+	if(error) return error;
+
+    error = gen_memory_reallocate_zeroed((void**) out_source, *out_source ? *out_source_length + 1 : 0, *out_source_length + text_length + 1, sizeof(char));
+    if(error) return error;
+
+    error = gen_memory_copy(&(*out_source)[*out_source_length], text_length + 1, text, text_length, text_length);
+    if(error) return error;
+    *out_source_length += text_length;
+
+    return GEN_NULL;
+}
+
+static void cio_vm_internal_emit_c_cleanup_mangled(char** mangled) {
+    if(!*mangled) return;
+
+    gen_error_t* error = gen_memory_free((void**) mangled);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+static void cio_vm_internal_emit_c_cleanup_translated(gen_bool_t** translated) {
+    if(!*translated) return;
+
+    gen_error_t* error = gen_memory_free((void**) translated);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+#define CIO_VM_INTERNAL_EMIT_C_APPEND(format, ...) \
+    do { \
+        gen_size_t formatted_length = 0; \
+        error = gen_string_format(GEN_STRING_NO_BOUNDS, GEN_NULL, &formatted_length, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        error = gen_memory_reallocate_zeroed((void**) out_source, *out_source ? *out_source_length + 1 : 0, *out_source_length + formatted_length + 1, sizeof(char)); \
+        if(error) return error; \
+        error = gen_string_format(formatted_length + 1, &(*out_source)[*out_source_length], GEN_NULL, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        *out_source_length += formatted_length; \
+    } while(0)
+
+static gen_error_t* cio_vm_internal_emit_c_intrinsic(const cio_callable_t* const restrict callable, const gen_size_t argc, cio_vm_internal_emit_c_intrinsic_t* const restrict out_intrinsic) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_emit_c_intrinsic, GEN_FILE_NAME);
+	if(error) return error;
+
+    static const char* const identifiers[] = {
+        [CIO_VM_INTERNAL_EMIT_C_INTRINSIC_ADD] = "+",
+        [CIO_VM_INTERNAL_EMIT_C_INTRINSIC_SUBTRACT] = "-",
+        [CIO_VM_INTERNAL_EMIT_C_INTRINSIC_COPY] = "copy=",
+        [CIO_VM_INTERNAL_EMIT_C_INTRINSIC_COPY_VARIABLE] = "copy=v",
+        [CIO_VM_INTERNAL_EMIT_C_INTRINSIC_STORE_CHAR] = "copy*[+]=c"
+    };
+
+    *out_intrinsic = CIO_VM_INTERNAL_EMIT_C_INTRINSIC_NONE;
+    if(callable->offset != CIO_ROUTINE_EXTERNAL) return GEN_NULL;
+
+    for(gen_size_t i = CIO_VM_INTERNAL_EMIT_C_INTRINSIC_ADD; i < sizeof(identifiers) / sizeof(identifiers[0]); ++i) {
+        gen_size_t length = 0;
+        error = gen_string_length(identifiers[i], GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &length);
+        if(error) return error;
+        if(length != callable->identifier_length) continue;
+
+        gen_bool_t equal = gen_false;
+        error = gen_string_compare(identifiers[i], length + 1, callable->identifier, callable->identifier_length + 1, length, &equal);
+        if(error) return error;
+        if(!equal) continue;
+
+        // Calls with unexpected parameter counts are left to the native implementation
+        if(argc != (i == CIO_VM_INTERNAL_EMIT_C_INTRINSIC_STORE_CHAR ? 3 : 2)) return GEN_NULL;
+
+        *out_intrinsic = (cio_vm_internal_emit_c_intrinsic_t) i;
+        return GEN_NULL;
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_vm_internal_emit_c_routine(const cio_vm_t* const restrict vm, const gen_bool_t* const restrict translated, const gen_size_t slot, char** const restrict out_source, gen_size_t* const restrict out_source_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_emit_c_routine, GEN_FILE_NAME);
+	if(error) return error;
+
+    const cio_callable_t* const routine = &vm->callables[slot];
+    const cio_bytecode_t* const module = &vm->bytecode[routine->bytecode_index];
+
+    {
+        GEN_CLEANUP_FUNCTION(cio_vm_internal_emit_c_cleanup_mangled) char* mangled = GEN_NULL;
+        error = cio_mangle_identifier(routine->identifier, &mangled);
+        if(error) return error;
+
+        CIO_VM_INTERNAL_EMIT_C_APPEND("\n// %t\nstatic gen_error_t* cio_aot_routine_%uz(cio_vm_t* const restrict vm) {\n", mangled, slot);
+        CIO_VM_INTERNAL_EMIT_C_APPEND("    cio_frame_t* const frame = &vm->frames[vm->frames_used - 1];\n    gen_size_t* const stack = &vm->stack[frame->base];\n    gen_size_t height = frame->height;\n    gen_error_t* error = GEN_NULL;\n    (void) stack;\n    (void) error;\n");
+    }
+
+    gen_size_t argc = 0;
+    for(gen_size_t i = routine->offset;; ++i) {
+        if(!(module->bytecode[i] >> 7)) {
+            // Runs of pushes are bounds checked once then stored directly
+            gen_size_t run = 0;
+            while(!(module->bytecode[i + run] >> 7)) ++run;
+
+            CIO_VM_INTERNAL_EMIT_C_APPEND("\n    if(frame->base + height + %uz > vm->stack_length) return cio_aot_stack_overflow();\n", run);
+            for(gen_size_t j = 0; j < run; ++j) CIO_VM_INTERNAL_EMIT_C_APPEND("    stack[height + %uz] = %uc;\n", j, (gen_uint8_t) (module->bytecode[i + j] & CIO_OPERAND_MAX));
+            CIO_VM_INTERNAL_EMIT_C_APPEND("    height += %uz;\n", run);
+
+            argc += run;
+            i += run - 1;
+            continue;
+        }
+
+        if((module->bytecode[i] & CIO_OPERAND_MAX) == CIO_OPERAND_MAX) {
+            CIO_VM_INTERNAL_EMIT_C_APPEND("\n    cio_aot_return(vm, frame, height, %uz);\n    return GEN_NULL;\n}\n", i);
+            break;
+        }
+
+        // Subtract 1 for reserve space
+        const gen_size_t callee_argc = argc - 1;
+        const gen_uint8_t* const current = &module->bytecode[i - callee_argc];
+        const gen_size_t target_slot = module->decoded[i].operand;
+        const cio_callable_t* const target = &vm->callables[target_slot];
+        argc = 0;
+
+        GEN_CLEANUP_FUNCTION(cio_vm_internal_emit_c_cleanup_mangled) char* target_mangled = GEN_NULL;
+        error = cio_mangle_identifier(target->identifier, &target_mangled);
+        if(error) return error;
+
+        cio_vm_internal_emit_c_intrinsic_t intrinsic = CIO_VM_INTERNAL_EMIT_C_INTRINSIC_NONE;
+        error = cio_vm_internal_emit_c_intrinsic(target, callee_argc, &intrinsic);
+        if(error) return error;
+
+        if(intrinsic) {
+            CIO_VM_INTERNAL_EMIT_C_APPEND("\n    // %t\n    error = cio_aot_intrinsic(vm, frame, &height, %uz);\n    if(error) return error;\n", target_mangled, callee_argc);
+
+            const gen_uint8_t first = current[0] & CIO_OPERAND_MAX;
+            const gen_uint8_t second = current[1] & CIO_OPERAND_MAX;
+            switch(intrinsic) {
+                case CIO_VM_INTERNAL_EMIT_C_INTRINSIC_ADD: {
+                    CIO_VM_INTERNAL_EMIT_C_APPEND("    stack[height - 1] = stack[%uc] + stack[%uc];\n", first, second);
+                    break;
+                }
+                case CIO_VM_INTERNAL_EMIT_C_INTRINSIC_SUBTRACT: {
+                    CIO_VM_INTERNAL_EMIT_C_APPEND("    stack[height - 1] = stack[%uc] - stack[%uc];\n", first, second);
+                    break;
+                }
+                case CIO_VM_INTERNAL_EMIT_C_INTRINSIC_COPY: {
+                    CIO_VM_INTERNAL_EMIT_C_APPEND("    stack[%uc] = %uc;\n", first, second);
+                    break;
+                }
+                case CIO_VM_INTERNAL_EMIT_C_INTRINSIC_COPY_VARIABLE: {
+                    CIO_VM_INTERNAL_EMIT_C_APPEND("    stack[%uc] = stack[%uc];\n", first, second);
+                    break;
+                }
+                case CIO_VM_INTERNAL_EMIT_C_INTRINSIC_STORE_CHAR: {
+                    CIO_VM_INTERNAL_EMIT_C_APPEND("    ((char*) stack[%uc])[%uc] = (char) %uc;\n", first, second, (gen_uint8_t) (current[2] & CIO_OPERAND_MAX));
+                    break;
+                }
+                case CIO_VM_INTERNAL_EMIT_C_INTRINSIC_NONE: break;
+            }
+        }
+        else if(target->offset == CIO_ROUTINE_EXTERNAL) {
+            CIO_VM_INTERNAL_EMIT_C_APPEND("\n    error = cio_aot_call(vm, frame, &height, %uz, %uz, %uz, CIO_ROUTINE_EXTERNAL, %t, " CIO_FAST_ROUTINE_PREFIX "%t, gen_true);\n    if(error) return error;\n", callee_argc, i, target->bytecode_index, target_mangled, target_mangled);
+        }
+        else {
+            // Routines which could not be translated are interpreted
+            const gen_size_t target_routine = vm->bytecode[target->bytecode_index].callables_offset + target->routine_index;
+            if(translated[target_routine]) CIO_VM_INTERNAL_EMIT_C_APPEND("\n    // %t\n    error = cio_aot_call(vm, frame, &height, %uz, %uz, %uz, %uz, cio_aot_routine_%uz, GEN_NULL, gen_false);\n    if(error) return error;\n", target_mangled, callee_argc, i, target->bytecode_index, target->offset, target_routine);
+            else CIO_VM_INTERNAL_EMIT_C_APPEND("\n    // %t\n    error = cio_aot_call(vm, frame, &height, %uz, %uz, %uz, %uz, vm->dispatch[%uz].function, GEN_NULL, gen_true);\n    if(error) return error;\n", target_mangled, callee_argc, i, target->bytecode_index, target->offset, target_slot);
+        }
+    }
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_emit_c(const cio_vm_t* const restrict vm, const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, const gen_size_t stack_length, const char* const restrict entry_routine, char** const restrict out_source, gen_size_t* const restrict out_source_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_emit_c, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!bytecode) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`bytecode` was `GEN_NULL`");
+	if(!entry_routine) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`entry_routine` was `GEN_NULL`");
+	if(!out_source) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_source` was `GEN_NULL`");
+	if(!out_source_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_source_length` was `GEN_NULL`");
+
+    *out_source = GEN_NULL;
+    *out_source_length = 0;
+
+    error = cio_vm_internal_emit_c_append(out_source, out_source_length, cio_vm_internal_emit_c_prelude, sizeof(cio_vm_internal_emit_c_prelude) - 1);
+    if(error) return error;
+
+    // Routines are translated under the slot of their definition
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_emit_c_cleanup_translated) gen_bool_t* translated = GEN_NULL;
+    if(vm->callables_length) {
+        error = gen_memory_allocate_zeroed((void**) &translated, vm->callables_length, sizeof(gen_bool_t));
+        if(error) return error;
+    }
+
+    CIO_VM_INTERNAL_EMIT_C_APPEND("\n");
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        const cio_callable_t* const callable = &vm->callables[i];
+        const cio_bytecode_t* const module = &vm->bytecode[callable->bytecode_index];
+
+        GEN_CLEANUP_FUNCTION(cio_vm_internal_emit_c_cleanup_mangled) char* mangled = GEN_NULL;
+        error = cio_mangle_identifier(callable->identifier, &mangled);
+        if(error) return error;
+
+        if(callable->offset == CIO_ROUTINE_EXTERNAL) {
+            // The fast calling convention is optional for external libraries so is bound weakly
+            CIO_VM_INTERNAL_EMIT_C_APPEND("extern gen_error_t* %t(cio_vm_t* const restrict vm);\n", mangled);
+            CIO_VM_INTERNAL_EMIT_C_APPEND("extern __attribute__((weak)) cio_status_t " CIO_FAST_ROUTINE_PREFIX "%t(cio_vm_t* const restrict vm, gen_size_t* const current, gen_size_t* const caller, cio_frame_t* const restrict caller_frame);\n", mangled);
+        }
+        else if(module->callables_offset + callable->routine_index == i && callable->offset < module->size) {
+            error = cio_vm_internal_translatable(vm, module, callable->offset, &translated[i]);
+            if(error) return error;
+
+            if(translated[i]) CIO_VM_INTERNAL_EMIT_C_APPEND("static gen_error_t* cio_aot_routine_%uz(cio_vm_t* const restrict vm);\n", i);
+        }
+    }
+
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        if(!translated[i]) continue;
+
+        error = cio_vm_internal_emit_c_routine(vm, translated, i, out_source, out_source_length);
+        if(error) return error;
+    }
+
+    CIO_VM_INTERNAL_EMIT_C_APPEND("\nstatic const cio_aot_binding_t cio_aot_bindings[] = {\n");
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        const cio_callable_t* const callable = &vm->callables[i];
+
+        if(callable->offset == CIO_ROUTINE_EXTERNAL) {
+            GEN_CLEANUP_FUNCTION(cio_vm_internal_emit_c_cleanup_mangled) char* mangled = GEN_NULL;
+            error = cio_mangle_identifier(callable->identifier, &mangled);
+            if(error) return error;
+
+            CIO_VM_INTERNAL_EMIT_C_APPEND("    {%t, " CIO_FAST_ROUTINE_PREFIX "%t},\n", mangled, mangled);
+
+            continue;
+        }
+
+        const gen_size_t routine = vm->bytecode[callable->bytecode_index].callables_offset + callable->routine_index;
+        if(translated[routine]) CIO_VM_INTERNAL_EMIT_C_APPEND("    {cio_aot_routine_%uz, GEN_NULL},\n", routine);
+        else CIO_VM_INTERNAL_EMIT_C_APPEND("    {GEN_NULL, GEN_NULL},\n");
+    }
+    CIO_VM_INTERNAL_EMIT_C_APPEND("};\n\nstatic const unsigned char cio_aot_bytecode[] = {");
+
+    for(gen_size_t i = 0; i < bytecode_length; ++i) CIO_VM_INTERNAL_EMIT_C_APPEND("%t%uc,", i % 16 ? " " : "\n    ", bytecode[i]);
+
+    CIO_VM_INTERNAL_EMIT_C_APPEND("\n};\n\n#define CIO_AOT_STACK_LENGTH %uz\n#define CIO_AOT_ENTRY_ROUTINE \"%t\"\n\n", stack_length, entry_routine);
+
+    error = cio_vm_internal_emit_c_append(out_source, out_source_length, cio_vm_internal_emit_c_main, sizeof(cio_vm_internal_emit_c_main) - 1);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+#undef CIO_VM_INTERNAL_EMIT_C_APPEND
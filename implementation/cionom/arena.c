@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/cionom.h"
+
+#include <genmemory.h>
+
+// Allocations are aligned for pointers and sizes, the strictest requirement of the program representation
+#define CIO_ARENA_INTERNAL_ALIGNMENT sizeof(gen_size_t)
+
+#define CIO_ARENA_INTERNAL_ALIGN(size) (((size) + CIO_ARENA_INTERNAL_ALIGNMENT - 1) & ~(CIO_ARENA_INTERNAL_ALIGNMENT - 1))
+
+// Allocates zeroed storage from an arena, adding a block if the current one is exhausted
+// Used by the parser for arena-backed programs
+extern gen_error_t* cio_arena_internal_allocate(cio_arena_block_t** const restrict arena, const gen_size_t size, void** const restrict out_pointer);
+gen_error_t* cio_arena_internal_allocate(cio_arena_block_t** const restrict arena, const gen_size_t size, void** const restrict out_pointer) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_arena_internal_allocate, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!arena) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`arena` was `GEN_NULL`");
+	if(!out_pointer) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_pointer` was `GEN_NULL`");
+
+    const gen_size_t aligned = CIO_ARENA_INTERNAL_ALIGN(size);
+
+    if(!*arena || (*arena)->capacity - (*arena)->used < aligned) {
+        // Oversized allocations get a block to themselves
+        const gen_size_t capacity = aligned > CIO_ARENA_BLOCK_LENGTH ? aligned : CIO_ARENA_BLOCK_LENGTH;
+
+        cio_arena_block_t* block = GEN_NULL;
+        error = gen_memory_allocate_zeroed((void**) &block, 1, sizeof(cio_arena_block_t) + capacity);
+        if(error) return error;
+
+        block->previous = *arena;
+        block->capacity = capacity;
+        *arena = block;
+    }
+
+    *out_pointer = &(*arena)->storage[(*arena)->used];
+    (*arena)->used += aligned;
+
+    return GEN_NULL;
+}
+
+// Resizes storage previously allocated from an arena
+// The most recent allocation grows in place where its block has room, otherwise the contents are moved
+// Used by the parser for arena-backed programs
+extern gen_error_t* cio_arena_internal_reallocate(cio_arena_block_t** const restrict arena, void** const restrict pointer, const gen_size_t size, const gen_size_t new_size);
+gen_error_t* cio_arena_internal_reallocate(cio_arena_block_t** const restrict arena, void** const restrict pointer, const gen_size_t size, const gen_size_t new_size) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_arena_internal_reallocate, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!arena) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`arena` was `GEN_NULL`");
+	if(!pointer) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`pointer` was `GEN_NULL`");
+
+    if(!*pointer) return cio_arena_internal_allocate(arena, new_size, pointer);
+    if(new_size <= size) return GEN_NULL;
+
+    cio_arena_block_t* const block = *arena;
+    const gen_size_t aligned = CIO_ARENA_INTERNAL_ALIGN(size);
+    const gen_size_t new_aligned = CIO_ARENA_INTERNAL_ALIGN(new_size);
+
+    if(block && (unsigned char*) *pointer + aligned == &block->storage[block->used] && block->capacity - (block->used - aligned) >= new_aligned) {
+        block->used += new_aligned - aligned;
+        return GEN_NULL;
+    }
+
+    void* moved = GEN_NULL;
+    error = cio_arena_internal_allocate(arena, new_size, &moved);
+    if(error) return error;
+
+    error = gen_memory_copy(moved, new_size, *pointer, size, size);
+    if(error) return error;
+
+    *pointer = moved;
+
+    return GEN_NULL;
+}
+
+// Frees every block of an arena
+// Used by `cio_program_free`
+extern gen_error_t* cio_arena_internal_free(cio_arena_block_t** const restrict arena);
+gen_error_t* cio_arena_internal_free(cio_arena_block_t** const restrict arena) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_arena_internal_free, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!arena) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`arena` was `GEN_NULL`");
+
+    while(*arena) {
+        cio_arena_block_t* block = *arena;
+        *arena = block->previous;
+
+        error = gen_memory_free((void**) &block);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
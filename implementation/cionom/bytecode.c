@@ -8,30 +8,158 @@
 
 #include <genlog.h>
 
-static void cio_module_internal_emit_cleanup_offsets(gen_uint32_t** offsets) {
-    if(!*offsets) return;
-
-    gen_error_t* error = gen_memory_free((void**) offsets);
+extern gen_uint64_t cio_internal_hash(const char* const restrict identifier, const gen_size_t length);
+extern gen_error_t* cio_arena_internal_allocate(cio_arena_block_t** const restrict arena, const gen_size_t size, void** const restrict out_pointer);
+extern gen_error_t* cio_arena_internal_reallocate(cio_arena_block_t** const restrict arena, void** const restrict pointer, const gen_size_t size, const gen_size_t new_size);
+extern void cio_tokenize_internal_window(const char* const restrict window, const gen_size_t window_length, const gen_bool_t final, gen_size_t* const restrict offset, cio_token_t* const restrict out_tokens, const gen_size_t tokens_capacity, gen_size_t* const restrict out_tokens_length);
+
+// The minimum number of slots in the routine index
+#define CIO_MODULE_INTERNAL_ROUTINE_INDEX_CAPACITY_MINIMUM 16
+
+typedef struct {
+    const char* identifier;
+    gen_size_t length;
+    gen_uint64_t hash;
+    gen_size_t routine;
+} cio_module_internal_routine_index_entry_t;
+
+// An open-addressed table mapping routine identifiers to their index in the program
+typedef struct {
+    cio_module_internal_routine_index_entry_t* entries;
+    // Always a power of two
+    gen_size_t capacity;
+} cio_module_internal_routine_index_t;
+
+static void cio_module_internal_emit_cleanup_routine_index(cio_module_internal_routine_index_t* routine_index) {
+    if(!routine_index->entries) return;
+
+    gen_error_t* error = gen_memory_free((void**) &routine_index->entries);
     if(error) {
         gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
         gen_error_abort();
     }
 }
 
-static void cio_module_internal_emit_cleanup_code(cio_instruction_t** code) {
-    if(!*code) return;
+static gen_error_t* cio_module_internal_index_routines(const cio_program_t* const restrict program, cio_module_internal_routine_index_t* const restrict out_routine_index) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_index_routines, GEN_FILE_NAME);
+	if(error) return error;
 
-    gen_error_t* error = gen_memory_free((void**) code);
-    if(error) {
-        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
-        gen_error_abort();
+    // Keep the load factor at or below one half
+    gen_size_t capacity = CIO_MODULE_INTERNAL_ROUTINE_INDEX_CAPACITY_MINIMUM;
+    while(capacity < program->routines_length * 2) capacity *= 2;
+
+    error = gen_memory_allocate_zeroed((void**) &out_routine_index->entries, capacity, sizeof(cio_module_internal_routine_index_entry_t));
+    if(error) return error;
+
+    out_routine_index->capacity = capacity;
+
+    for(gen_size_t i = 0; i < program->routines_length; ++i) {
+        const char* const identifier = program->routines[i].identifier;
+
+        gen_size_t length = 0;
+        error = gen_string_length(identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &length);
+        if(error) return error;
+
+        const gen_uint64_t hash = cio_internal_hash(identifier, length);
+
+        // Calls resolve to the first definition of a routine, as the VM resolves external entries to it
+        // Without a definition, the last declaration is taken as the routine's signature
+        gen_bool_t present = gen_false;
+        gen_size_t slot = (gen_size_t) (hash & (capacity - 1));
+        for(; out_routine_index->entries[slot].identifier; slot = (slot + 1) & (capacity - 1)) {
+            const cio_module_internal_routine_index_entry_t* const entry = &out_routine_index->entries[slot];
+            if(entry->hash != hash || entry->length != length) continue;
+
+            error = gen_memory_compare(entry->identifier, length, identifier, length, length, &present);
+            if(error) return error;
+
+            if(present) break;
+        }
+
+        if(present && !program->routines[out_routine_index->entries[slot].routine].external) continue;
+
+        out_routine_index->entries[slot] = (cio_module_internal_routine_index_entry_t) {identifier, length, hash, i};
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_module_internal_find_routine(const cio_module_internal_routine_index_t* const restrict routine_index, const char* const restrict identifier, gen_size_t* const restrict out_routine) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_find_routine, GEN_FILE_NAME);
+	if(error) return error;
+
+    gen_size_t length = 0;
+    error = gen_string_length(identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &length);
+    if(error) return error;
+
+    const gen_uint64_t hash = cio_internal_hash(identifier, length);
+
+    for(gen_size_t slot = (gen_size_t) (hash & (routine_index->capacity - 1)); routine_index->entries[slot].identifier; slot = (slot + 1) & (routine_index->capacity - 1)) {
+        const cio_module_internal_routine_index_entry_t* const entry = &routine_index->entries[slot];
+
+        // Identifiers in arena-backed programs are interned so usually match by address
+        if(entry->identifier == identifier) {
+            *out_routine = entry->routine;
+            return GEN_NULL;
+        }
+
+        if(entry->hash != hash || entry->length != length) continue;
+
+        gen_bool_t equal = gen_false;
+        error = gen_memory_compare(entry->identifier, length, identifier, length, length, &equal);
+        if(error) return error;
+
+        if(equal) {
+            *out_routine = entry->routine;
+            return GEN_NULL;
+        }
+    }
+
+    return GEN_NULL;
+}
+
+// Writes the header for a program's routines into storage sized for it
+static gen_error_t* cio_module_internal_emit_header(const cio_program_t* const restrict program, const gen_uint32_t* const restrict offsets, unsigned char* const restrict out_header) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_emit_header, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_header_t* const header = (cio_header_t*) out_header;
+
+    // Output routine table length
+    header->routine_table_length = (gen_uint8_t) program->routines_length;
+
+    gen_size_t entry_offset = sizeof(cio_header_t);
+    for(gen_size_t i = 0; i < program->routines_length; ++i) {
+        const cio_routine_t* const routine = &program->routines[i];
+
+        // Get the length of the routine identifier
+        gen_size_t identifier_length = 0;
+        error = gen_string_length(routine->identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &identifier_length);
+        if(error) return error;
+
+#ifdef __ANALYZER
+        cio_routine_table_entry_t* entry = malloc(sizeof(cio_routine_table_entry_t));
+#else
+        cio_routine_table_entry_t* entry = (cio_routine_table_entry_t*) &header->routine_table[entry_offset - 1];
+#endif
+
+        // Set routine code offset
+        entry->offset = offsets[i];
+
+        // Copy in routine identifier
+        error = gen_string_copy(entry->name, identifier_length + 1, routine->identifier, identifier_length + 1, identifier_length);
+        if(error) return error;
+
+        entry_offset += sizeof(cio_routine_table_entry_t) + identifier_length + 1;
     }
+
+    return GEN_NULL;
 }
 
-static void cio_module_internal_emit_cleanup_header(cio_header_t** header) {
-    if(!*header) return;
+static void cio_module_internal_emit_cleanup_offsets(gen_uint32_t** offsets) {
+    if(!*offsets) return;
 
-    gen_error_t* error = gen_memory_free((void**) header);
+    gen_error_t* error = gen_memory_free((void**) offsets);
     if(error) {
         gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
         gen_error_abort();
@@ -72,13 +200,19 @@ gen_error_t* cio_module_emit(const cio_program_t* const restrict program, unsign
 	}
 
 	gen_size_t code_size = 0;
-	GEN_CLEANUP_FUNCTION(cio_module_internal_emit_cleanup_code) cio_instruction_t* code = GEN_NULL;
+	gen_size_t header_size = sizeof(cio_header_t);
 
-	// Codegen
+	// Sizing
 	{
 		for(gen_size_t i = 0; i < program->routines_length; ++i) {
 			const cio_routine_t* const routine = &program->routines[i];
 
+            gen_size_t identifier_length = 0;
+            error = gen_string_length(routine->identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &identifier_length);
+            if(error) return error;
+
+            header_size += sizeof(cio_routine_table_entry_t) + identifier_length + 1;
+
 			if(routine->external) {
                 offsets[i] = CIO_ROUTINE_EXTERNAL;
                 continue;
@@ -87,12 +221,50 @@ gen_error_t* cio_module_emit(const cio_program_t* const restrict program, unsign
             // Cache routine offsets for header generation
 			offsets[i] = (gen_uint32_t) code_size;
 
+            // A reserve push, a push per parameter and a call for each call, then a return
+			for(gen_size_t j = 0; j < routine->calls_length; ++j) code_size += routine->calls[j].parameters_length + 2;
+            ++code_size;
+		}
+
+        // TODO: Technically this is the limit for the *start* of a routine
+        //       and the contents of a really long routine can extend beyond
+        //       the external routine limit.
+        //       This also might make more sense as a warning by default as
+        //       we can just continue codegen past this point creating
+        //       unaddressable routines.
+		if(code_size >= CIO_ROUTINE_EXTERNAL) {
+            error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom", "Emitted code section size %uz exceeds maximum of %uz allowed by bytecode format in %t", code_size, (gen_size_t) CIO_ROUTINE_EXTERNAL, source_file);
+            if(error) return error;
+
+            return gen_error_attach_backtrace_formatted(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "Emitted code section size %uz exceeds maximum of %uz allowed by bytecode format in %t", code_size, (gen_size_t) CIO_ROUTINE_EXTERNAL, source_file);
+        }
+	}
+
+	GEN_CLEANUP_FUNCTION(cio_module_internal_emit_cleanup_routine_index) cio_module_internal_routine_index_t routine_index = {0};
+	error = cio_module_internal_index_routines(program, &routine_index);
+	if(error) return error;
+
+	*out_bytecode_length = header_size + code_size;
+	error = gen_memory_allocate_zeroed((void**) out_bytecode, *out_bytecode_length, sizeof(unsigned char));
+	if(error) return error;
+    GEN_CLEANUP_FUNCTION(cio_module_internal_emit_cleanup_bytecode) unsigned char* bytecode_cleanup = *out_bytecode;
+
+	error = cio_module_internal_emit_header(program, offsets, *out_bytecode);
+	if(error) return error;
+
+	// Codegen
+	{
+		cio_instruction_t* const code = (cio_instruction_t*) (*out_bytecode + header_size);
+		code_size = 0;
+
+		for(gen_size_t i = 0; i < program->routines_length; ++i) {
+			const cio_routine_t* const routine = &program->routines[i];
+
+			if(routine->external) continue;
+
 			for(gen_size_t j = 0; j < routine->calls_length; ++j) {
 				const cio_call_t* const call = &routine->calls[j];
 
-                error = gen_memory_reallocate_zeroed((void**) &code, code_size, code_size + call->parameters_length + 2, sizeof(cio_instruction_t));
-                if(error) return error;
-
                 // Emit pushes
                 {
                     code[code_size] = (cio_instruction_t) {0, CIO_PUSH}; // Reserve space
@@ -151,17 +323,8 @@ gen_error_t* cio_module_emit(const cio_program_t* const restrict program, unsign
 				gen_size_t called = GEN_SIZE_MAX;
 
 				// Locate called routine's index
-				for(gen_size_t k = 0; k < program->routines_length; ++k) {
-					gen_bool_t equal = gen_false;
-
-					error = gen_string_compare(call->identifier, GEN_STRING_NO_BOUNDS, program->routines[k].identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &equal);
-					if(error) return error;
-
-					if(equal) {
-						called = k;
-						break;
-					}
-				}
+				error = cio_module_internal_find_routine(&routine_index, call->identifier, &called);
+				if(error) return error;
 
                 // Call to undeclared/undefined routine
 				if(called == GEN_SIZE_MAX) {
@@ -202,81 +365,651 @@ gen_error_t* cio_module_emit(const cio_program_t* const restrict program, unsign
 				code[code_size - 1] = (cio_instruction_t) {(gen_uint8_t) called, CIO_CALL};
 			}
 
-			error = gen_memory_reallocate_zeroed((void**) &code, code_size, code_size + 1, sizeof(unsigned char));
-			if(error) return error;
-
 			// Emit return
 			code[code_size++] = (cio_instruction_t) {CIO_OPERAND_MAX, CIO_RET};
 		}
+	}
 
-        // TODO: Technically this is the limit for the *start* of a routine
-        //       and the contents of a really long routine can extend beyond
-        //       the external routine limit.
-        //       This also might make more sense as a warning by default as
-        //       we can just continue codegen past this point creating
-        //       unaddressable routines.
-		if(code_size >= CIO_ROUTINE_EXTERNAL) {
-            error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom", "Emitted code section size %uz exceeds maximum of %uz allowed by bytecode format in %t", code_size, (gen_size_t) CIO_ROUTINE_EXTERNAL, source_file);
+    bytecode_cleanup = GEN_NULL;
+
+	return GEN_NULL;
+}
+
+// The number of tokens scanned from the source window at a time while streaming
+#define CIO_MODULE_INTERNAL_STREAM_TOKENS 1024
+
+// The number of routines space is initially made for while streaming
+#define CIO_MODULE_INTERNAL_STREAM_ROUTINES_CAPACITY_INITIAL 16
+
+typedef struct {
+    gen_size_t line;
+    gen_size_t column;
+} cio_module_internal_stream_position_t;
+
+typedef struct {
+    cio_stream_reader_t reader;
+    void* reader_data;
+
+    // A window over the source beginning `window_offset` bytes in
+    char* window;
+    gen_size_t window_capacity;
+    gen_size_t window_length;
+    gen_size_t window_offset;
+    // Set once the reader has reached the end of the source
+    gen_bool_t final;
+    // The offset into the window at which tokenization resumes
+    gen_size_t scan_offset;
+
+    // Newlines have been counted up to this offset into the window
+    gen_size_t lines_offset;
+    gen_size_t line;
+    // The offset into the source at which the line `line` begins
+    gen_size_t line_start;
+
+    // Tokens scanned from the window, with offsets into the window
+    cio_token_t* tokens;
+    cio_module_internal_stream_position_t* positions;
+    gen_size_t tokens_length;
+    gen_size_t tokens_index;
+
+    // The most recently consumed token, which is kept in the window across refills
+    cio_token_t current;
+    cio_module_internal_stream_position_t current_position;
+
+    const char* source_file;
+    gen_size_t source_file_length;
+    const cio_warning_settings_t* warning_settings;
+
+    // Holds only routines, with identifiers, parameter counts and whether they are external
+    cio_program_t program;
+    gen_size_t routines_capacity;
+    gen_uint32_t* offsets;
+    gen_size_t code_size;
+    cio_module_internal_routine_index_t routine_index;
+
+    // The identifier of the call being emitted
+    char* call_identifier;
+    gen_size_t call_identifier_capacity;
+
+    cio_stream_writer_t writer;
+    void* writer_data;
+    cio_instruction_t* code;
+    gen_size_t code_length;
+} cio_module_internal_stream_t;
+
+static gen_error_t* cio_module_internal_stream_free(cio_module_internal_stream_t* const restrict stream) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(stream->window) {
+        error = gen_memory_free((void**) &stream->window);
+        if(error) return error;
+    }
+    if(stream->tokens) {
+        error = gen_memory_free((void**) &stream->tokens);
+        if(error) return error;
+    }
+    if(stream->positions) {
+        error = gen_memory_free((void**) &stream->positions);
+        if(error) return error;
+    }
+    if(stream->program.arena_blocks) {
+        error = cio_program_free(&stream->program);
+        if(error) return error;
+    }
+    if(stream->offsets) {
+        error = gen_memory_free((void**) &stream->offsets);
+        if(error) return error;
+    }
+    if(stream->routine_index.entries) {
+        error = gen_memory_free((void**) &stream->routine_index.entries);
+        if(error) return error;
+    }
+    if(stream->call_identifier) {
+        error = gen_memory_free((void**) &stream->call_identifier);
+        if(error) return error;
+    }
+    if(stream->code) {
+        error = gen_memory_free((void**) &stream->code);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static void cio_module_internal_emit_stream_cleanup_stream(cio_module_internal_stream_t* stream) {
+    gen_error_t* error = cio_module_internal_stream_free(stream);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+// Discards the consumed part of the window and reads more of the source into it
+static gen_error_t* cio_module_internal_stream_fill(cio_module_internal_stream_t* const restrict stream) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_fill, GEN_FILE_NAME);
+	if(error) return error;
+
+    for(gen_size_t i = stream->lines_offset; i < stream->scan_offset; ++i) {
+        if(stream->window[i] != '\n') continue;
+
+        ++stream->line;
+        stream->line_start = stream->window_offset + i + 1;
+    }
+
+    // The current token is kept for diagnostics, followed by any token left incomplete at the end of the window
+    const gen_size_t kept = stream->current.length;
+    for(gen_size_t i = 0; i < kept; ++i) stream->window[i] = stream->window[stream->current.offset + i];
+    for(gen_size_t i = stream->scan_offset; i < stream->window_length; ++i) stream->window[kept + i - stream->scan_offset] = stream->window[i];
+
+    // Past the current token, the window maps linearly onto the source
+    stream->window_offset += stream->scan_offset - kept;
+    stream->window_length -= stream->scan_offset - kept;
+    stream->scan_offset = kept;
+    stream->lines_offset = kept;
+    stream->current.offset = 0;
+
+    // Only a single token can fill the window
+    if(stream->window_length == stream->window_capacity) {
+        error = gen_memory_reallocate_zeroed((void**) &stream->window, stream->window_capacity, stream->window_capacity * 2, sizeof(char));
+        if(error) return error;
+
+        stream->window_capacity *= 2;
+    }
+
+    // Short reads are retried so that an incomplete token is only rescanned once the window is full
+    while(stream->window_length < stream->window_capacity) {
+        gen_size_t read = 0;
+        error = stream->reader(stream->reader_data, stream->window_offset + stream->window_length, &stream->window[stream->window_length], stream->window_capacity - stream->window_length, &read);
+        if(error) return error;
+
+        if(!read) {
+            stream->final = gen_true;
+            break;
+        }
+
+        stream->window_length += read;
+    }
+
+    return GEN_NULL;
+}
+
+// Gets the next token without consuming it, or `GEN_NULL` at the end of the source
+static gen_error_t* cio_module_internal_stream_peek(cio_module_internal_stream_t* const restrict stream, const cio_token_t** const restrict out_token) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_peek, GEN_FILE_NAME);
+	if(error) return error;
+
+    while(stream->tokens_index == stream->tokens_length) {
+        if(stream->final && stream->scan_offset == stream->window_length) {
+            *out_token = GEN_NULL;
+            return GEN_NULL;
+        }
+
+        stream->tokens_index = 0;
+        cio_tokenize_internal_window(stream->window, stream->window_length, stream->final, &stream->scan_offset, stream->tokens, CIO_MODULE_INTERNAL_STREAM_TOKENS, &stream->tokens_length);
+
+        if(!stream->tokens_length) {
+            if(stream->final) continue;
+
+            error = cio_module_internal_stream_fill(stream);
             if(error) return error;
 
-            return gen_error_attach_backtrace_formatted(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "Emitted code section size %uz exceeds maximum of %uz allowed by bytecode format in %t", code_size, (gen_size_t) CIO_ROUTINE_EXTERNAL, source_file);
+            continue;
         }
-	}
 
-	gen_size_t header_size = sizeof(cio_header_t);
-	GEN_CLEANUP_FUNCTION(cio_module_internal_emit_cleanup_header) cio_header_t* header = GEN_NULL;
+        for(gen_size_t i = 0; i < stream->tokens_length; ++i) {
+            for(gen_size_t j = stream->lines_offset; j < stream->tokens[i].offset; ++j) {
+                if(stream->window[j] != '\n') continue;
 
-	// Header
-	{
-		error = gen_memory_allocate_zeroed((void**) &header, header_size, 1);
+                ++stream->line;
+                stream->line_start = stream->window_offset + j + 1;
+            }
+            stream->lines_offset = stream->tokens[i].offset;
+
+            stream->positions[i] = (cio_module_internal_stream_position_t) {stream->line, stream->window_offset + stream->tokens[i].offset - stream->line_start + 1};
+        }
+    }
+
+    *out_token = &stream->tokens[stream->tokens_index];
+
+    return GEN_NULL;
+}
+
+// Consumes the next token, which must exist
+static void cio_module_internal_stream_next(cio_module_internal_stream_t* const restrict stream) {
+    stream->current = stream->tokens[stream->tokens_index];
+    stream->current_position = stream->positions[stream->tokens_index];
+    ++stream->tokens_index;
+}
+
+static gen_error_t* cio_module_internal_stream_expect(const cio_module_internal_stream_t* const restrict stream, const cio_token_t* const restrict token, const cio_module_internal_stream_position_t* const restrict position, const cio_token_type_t expected) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_expect, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(token->type != expected) {
+		error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom", "Unexpected token `%tz` in %t:%uz:%uz", &stream->window[token->offset], token->length, stream->source_file, position->line, position->column);
 		if(error) return error;
 
-        // Output routine table length
-		header->routine_table_length = (gen_uint8_t) program->routines_length;
+        return gen_error_attach_backtrace_formatted(GEN_ERROR_BAD_CONTENT, GEN_LINE_NUMBER, "Unexpected token `%tz` in %t:%uz:%uz", &stream->window[token->offset], token->length, stream->source_file, position->line, position->column);
+	}
 
-		for(gen_size_t i = 0; i < program->routines_length; ++i) {
-			const cio_routine_t* const routine = &program->routines[i];
+	return GEN_NULL;
+}
 
-            // Get the length of the routine identifier
-            gen_size_t identifier_length = 0;
-            error = gen_string_length(routine->identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &identifier_length);
+static gen_error_t* cio_module_internal_stream_eof(const cio_module_internal_stream_t* const restrict stream, const cio_module_internal_stream_position_t* const restrict position) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_eof, GEN_FILE_NAME);
+	if(error) return error;
+
+    error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom", "Unexpected EOF in %t:%uz:%uz", stream->source_file, position->line, position->column);
+    if(error) return error;
+
+    return gen_error_attach_backtrace_formatted(GEN_ERROR_BAD_CONTENT, GEN_LINE_NUMBER, "Unexpected EOF in %t:%uz:%uz", stream->source_file, position->line, position->column);
+}
+
+static gen_error_t* cio_module_internal_stream_flush(cio_module_internal_stream_t* const restrict stream) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_flush, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(!stream->code_length) return GEN_NULL;
+
+    error = stream->writer(stream->writer_data, (const unsigned char*) stream->code, stream->code_length);
+    if(error) return error;
+
+    stream->code_length = 0;
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_module_internal_stream_emit(cio_module_internal_stream_t* const restrict stream, const cio_instruction_t instruction) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_emit, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(stream->code_length == CIO_STREAM_BUFFER_LENGTH) {
+        error = cio_module_internal_stream_flush(stream);
+        if(error) return error;
+    }
+
+    stream->code[stream->code_length++] = instruction;
+
+    return GEN_NULL;
+}
+
+// Records a routine from the token `stream->current` on the layout pass
+static gen_error_t* cio_module_internal_stream_declare(cio_module_internal_stream_t* const restrict stream, cio_routine_t** const restrict out_routine) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_declare, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_program_t* const program = &stream->program;
+
+    if(program->routines_length == stream->routines_capacity) {
+        const gen_size_t capacity = stream->routines_capacity ? stream->routines_capacity * 2 : CIO_MODULE_INTERNAL_STREAM_ROUTINES_CAPACITY_INITIAL;
+
+        error = cio_arena_internal_reallocate(&program->arena_blocks, (void**) &program->routines, stream->routines_capacity * sizeof(cio_routine_t), capacity * sizeof(cio_routine_t));
+        if(error) return error;
+
+        error = gen_memory_reallocate_zeroed((void**) &stream->offsets, stream->routines_capacity, capacity, sizeof(gen_uint32_t));
+        if(error) return error;
+
+        stream->routines_capacity = capacity;
+    }
+
+    cio_routine_t* const routine = &program->routines[program->routines_length++];
+
+    // Arena storage is zeroed so the copy is already terminated
+    error = cio_arena_internal_allocate(&program->arena_blocks, stream->current.length + 1, (void**) &routine->identifier);
+    if(error) return error;
+
+    error = gen_memory_copy(routine->identifier, stream->current.length + 1, &stream->window[stream->current.offset], stream->window_length - stream->current.offset, stream->current.length);
+    if(error) return error;
+
+    const cio_warning_settings_t* const warning_settings = stream->warning_settings;
+    if(warning_settings->reserved_identifier) {
+        gen_bool_t entry_point = gen_false;
+        error = gen_string_compare(routine->identifier, GEN_STRING_NO_BOUNDS, "__cionom_entrypoint", sizeof("__cionom_entrypoint"), GEN_STRING_NO_BOUNDS, &entry_point);
+        if(error) return error;
+
+        if(!entry_point) {
+            gen_bool_t contains = gen_false;
+            error = gen_string_contains(routine->identifier, GEN_STRING_NO_BOUNDS, "__cionom", sizeof("__cionom"), GEN_STRING_NO_BOUNDS, &contains, GEN_NULL);
             if(error) return error;
 
-            // Allocate an entry in the routine table
-            error = gen_memory_reallocate_zeroed((void**) &header, header_size, header_size + sizeof(cio_routine_table_entry_t) + identifier_length + 1, 1);
+            if(contains) {
+                error = gen_log_formatted(warning_settings->fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom", "Routine identifier `%t` contained reserved sequence `__cionom` in %t:%uz:%uz [%treserved_identifier]", routine->identifier, stream->source_file, stream->current_position.line, stream->current_position.column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+                if(error) return error;
+
+                if(warning_settings->fatal_warnings) {
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_IN_USE, GEN_LINE_NUMBER, "Routine identifier `%t` contained reserved sequence `__cionom` in %t:%uz:%uz [%treserved_identifier]", routine->identifier, stream->source_file, stream->current_position.line, stream->current_position.column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+                }
+            }
+        }
+    }
+
+    *out_routine = routine;
+
+    return GEN_NULL;
+}
+
+// Begins emitting a call from the token `stream->current`
+static gen_error_t* cio_module_internal_stream_begin_call(cio_module_internal_stream_t* const restrict stream) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_begin_call, GEN_FILE_NAME);
+	if(error) return error;
+
+    // The call's parameters may extend past the window, so its identifier is kept for diagnostics
+    if(stream->current.length + 1 > stream->call_identifier_capacity) {
+        error = gen_memory_reallocate_zeroed((void**) &stream->call_identifier, stream->call_identifier_capacity, stream->current.length + 1, sizeof(char));
+        if(error) return error;
+
+        stream->call_identifier_capacity = stream->current.length + 1;
+    }
+
+    error = gen_memory_copy(stream->call_identifier, stream->call_identifier_capacity, &stream->window[stream->current.offset], stream->window_length - stream->current.offset, stream->current.length);
+    if(error) return error;
+    stream->call_identifier[stream->current.length] = '\0';
+
+    return cio_module_internal_stream_emit(stream, (cio_instruction_t) {0, CIO_PUSH}); // Reserve space
+}
+
+// Emits a parameter to the call begun at `call_position`
+static gen_error_t* cio_module_internal_stream_parameter(cio_module_internal_stream_t* const restrict stream, const cio_module_internal_stream_position_t* const restrict call_position, const gen_size_t call_length, const gen_size_t parameter) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_parameter, GEN_FILE_NAME);
+	if(error) return error;
+
+    const cio_warning_settings_t* const warning_settings = stream->warning_settings;
+
+    if(parameter == CIO_OPERAND_MAX && warning_settings->emit_reserved_encoding) {
+        error = gen_log_formatted(warning_settings->fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom", "Emission for call `%tz` resulted in reserved encoding `push %uc` in %t:%uz:%uz [%temit_reserved_encoding]", stream->call_identifier, call_length, CIO_OPERAND_MAX, stream->source_file, call_position->line, call_position->column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+        if(error) return error;
+
+        if(warning_settings->fatal_warnings) {
+            return gen_error_attach_backtrace_formatted(GEN_ERROR_IN_USE, GEN_LINE_NUMBER, "Emission for call `%tz` resulted in reserved encoding `push %uc` in %t:%uz:%uz [%temit_reserved_encoding]", stream->call_identifier, call_length, CIO_OPERAND_MAX, stream->source_file, call_position->line, call_position->column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+        }
+    }
+
+    if(parameter > CIO_OPERAND_MAX && warning_settings->parameter_overflow) {
+        error = gen_log_formatted(warning_settings->fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom", "Emission for call `%tz` resulted in a value greater than the maximum encodable value `%uc` in %t:%uz:%uz [%tparameter_overflow]", stream->call_identifier, call_length, CIO_OPERAND_MAX, stream->source_file, call_position->line, call_position->column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+        if(error) return error;
+
+        if(warning_settings->fatal_warnings) {
+            return gen_error_attach_backtrace_formatted(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "Emission for call `%tz` resulted in a value greater than the maximum encodable value `%uc` in %t:%uz:%uz [%tparameter_overflow]", stream->call_identifier, call_length, CIO_OPERAND_MAX, stream->source_file, call_position->line, call_position->column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+        }
+    }
+
+    // Emit push for each param
+    return cio_module_internal_stream_emit(stream, (cio_instruction_t) {(gen_uint8_t) parameter, CIO_PUSH});
+}
+
+// Resolves and emits the call begun at `call_position`
+static gen_error_t* cio_module_internal_stream_end_call(cio_module_internal_stream_t* const restrict stream, const cio_module_internal_stream_position_t* const restrict call_position, const gen_size_t call_length, const gen_size_t parameters_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_end_call, GEN_FILE_NAME);
+	if(error) return error;
+
+    const cio_warning_settings_t* const warning_settings = stream->warning_settings;
+    const cio_program_t* const program = &stream->program;
+
+    gen_size_t called = GEN_SIZE_MAX;
+
+    // Locate called routine's index
+    error = cio_module_internal_find_routine(&stream->routine_index, stream->call_identifier, &called);
+    if(error) return error;
+
+    // Call to undeclared/undefined routine
+    if(called == GEN_SIZE_MAX) {
+        error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom", "Call to undeclared or undefined routine `%t` in %tz:%uz:%uz", stream->call_identifier, stream->source_file, stream->source_file_length, call_position->line, call_position->column);
+        if(error) return error;
+
+        return gen_error_attach_backtrace_formatted(GEN_ERROR_NO_SUCH_OBJECT, GEN_LINE_NUMBER, "Call to undeclared or undefined routine `%t` in %tz:%uz:%uz", stream->call_identifier, stream->source_file, stream->source_file_length, call_position->line, call_position->column);
+    }
+
+    if(parameters_length != program->routines[called].parameters && warning_settings->parameter_count_mismatch) {
+        error = gen_log_formatted(warning_settings->fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom", "Call `%tz` to routine `%t` with %uz parameters did not match routine parameter count %uz in %t:%uz:%uz [%tparameter_count_mismatch]", stream->call_identifier, call_length, stream->call_identifier, parameters_length, program->routines[called].parameters, stream->source_file, call_position->line, call_position->column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+        if(error) return error;
+
+        if(warning_settings->fatal_warnings) {
+            return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "Call `%tz` to routine `%t` with %uz parameters did not match routine parameter count %uz in %t:%uz:%uz [%tparameter_count_mismatch]", stream->call_identifier, call_length, stream->call_identifier, parameters_length, program->routines[called].parameters, stream->source_file, call_position->line, call_position->column, warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+        }
+    }
+
+    // Emit call
+    return cio_module_internal_stream_emit(stream, (cio_instruction_t) {(gen_uint8_t) called, CIO_CALL});
+}
+
+// Walks the source following the same structure as `cio_parse`
+// The layout pass records routines and sizes their code, the emission pass writes the code
+static gen_error_t* cio_module_internal_stream_pass(cio_module_internal_stream_t* const restrict stream, const gen_bool_t emit) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_internal_stream_pass, GEN_FILE_NAME);
+	if(error) return error;
+
+    gen_size_t routines_length = 0;
+    const cio_token_t* peeked = GEN_NULL;
+
+    while(gen_true) {
+        error = cio_module_internal_stream_peek(stream, &peeked);
+        if(error) return error;
+        if(!peeked) break;
+
+        cio_module_internal_stream_next(stream);
+
+        error = cio_module_internal_stream_expect(stream, &stream->current, &stream->current_position, CIO_TOKEN_IDENTIFIER);
+        if(error) return error;
+
+        cio_routine_t* routine = GEN_NULL;
+        if(emit) {
+            routine = &stream->program.routines[routines_length];
+        }
+        else {
+            error = cio_module_internal_stream_declare(stream, &routine);
             if(error) return error;
+        }
+        const gen_size_t index = routines_length++;
 
-#ifdef __ANALYZER
-            cio_routine_table_entry_t* entry = malloc(sizeof(cio_routine_table_entry_t));
-#else
-            cio_routine_table_entry_t* entry = (cio_routine_table_entry_t*) &header->routine_table[header_size - 1];
-#endif
+        error = cio_module_internal_stream_peek(stream, &peeked);
+        if(error) return error;
+        if(!peeked) return cio_module_internal_stream_eof(stream, &stream->current_position);
+
+        cio_module_internal_stream_next(stream);
+
+        error = cio_module_internal_stream_expect(stream, &stream->current, &stream->current_position, CIO_TOKEN_NUMBER);
+        if(error) return error;
+
+        gen_size_t parameters = 0;
+        error = gen_string_number(&stream->window[stream->current.offset], stream->window_length - stream->current.offset, stream->current.length, &parameters);
+        if(error) return error;
+
+        if(!emit) routine->parameters = parameters;
+
+        error = cio_module_internal_stream_peek(stream, &peeked);
+        if(error) return error;
+
+        if(!peeked || peeked->type == CIO_TOKEN_IDENTIFIER) {
+            if(!emit) {
+                routine->external = gen_true;
+                stream->offsets[index] = CIO_ROUTINE_EXTERNAL;
+            }
+            continue;
+        }
 
-            // Set routine code offset
-            entry->offset = offsets[i];
+        error = cio_module_internal_stream_expect(stream, peeked, &stream->positions[stream->tokens_index], CIO_TOKEN_BLOCK);
+        if(error) return error;
+
+        const cio_module_internal_stream_position_t parameters_position = stream->current_position;
+        cio_module_internal_stream_next(stream);
+
+        error = cio_module_internal_stream_peek(stream, &peeked);
+        if(error) return error;
+        if(!peeked) return cio_module_internal_stream_eof(stream, &parameters_position);
+
+        // Cache routine offsets for header generation
+        if(!emit) stream->offsets[index] = (gen_uint32_t) stream->code_size;
+
+        cio_module_internal_stream_next(stream);
 
-            // Copy in routine identifier
-            error = gen_string_copy(entry->name, identifier_length + 1, routine->identifier, identifier_length + 1, identifier_length);
+        while(stream->current.type != CIO_TOKEN_BLOCK) {
+            error = cio_module_internal_stream_expect(stream, &stream->current, &stream->current_position, CIO_TOKEN_IDENTIFIER);
             if(error) return error;
 
-            header_size += sizeof(cio_routine_table_entry_t) + identifier_length + 1;
-		}
-	}
+            const cio_module_internal_stream_position_t call_position = stream->current_position;
+            const gen_size_t call_length = stream->current.length;
+            gen_size_t parameters_length = 0;
 
-	*out_bytecode_length = header_size + code_size;
-	error = gen_memory_allocate_zeroed((void**) out_bytecode, *out_bytecode_length, sizeof(unsigned char));
-	if(error) return error;
-    GEN_CLEANUP_FUNCTION(cio_module_internal_emit_cleanup_bytecode) unsigned char* bytecode_cleanup = *out_bytecode;
+            if(emit) {
+                error = cio_module_internal_stream_begin_call(stream);
+                if(error) return error;
+            }
+
+            error = cio_module_internal_stream_peek(stream, &peeked);
+            if(error) return error;
+            if(!peeked) return cio_module_internal_stream_eof(stream, &stream->current_position);
+
+            cio_module_internal_stream_next(stream);
+
+            error = cio_module_internal_stream_peek(stream, &peeked);
+            if(error) return error;
+
+            if(!peeked) {
+                error = cio_module_internal_stream_expect(stream, &stream->current, &stream->current_position, CIO_TOKEN_BLOCK);
+                if(error) return error;
+            }
+            else {
+                while(stream->current.type == CIO_TOKEN_NUMBER) {
+                    ++parameters_length;
+
+                    gen_size_t parameter = 0;
+                    error = gen_string_number(&stream->window[stream->current.offset], stream->window_length - stream->current.offset, stream->current.length, &parameter);
+                    if(error) return error;
+
+                    if(emit) {
+                        error = cio_module_internal_stream_parameter(stream, &call_position, call_length, parameter);
+                        if(error) return error;
+                    }
+
+                    error = cio_module_internal_stream_peek(stream, &peeked);
+                    if(error) return error;
+                    if(!peeked) return cio_module_internal_stream_eof(stream, &stream->current_position);
+
+                    cio_module_internal_stream_next(stream);
+                }
+            }
+
+            if(emit) {
+                error = cio_module_internal_stream_end_call(stream, &call_position, call_length, parameters_length);
+                if(error) return error;
+            }
+            else stream->code_size += parameters_length + 2;
+
+            if(!peeked) break;
+        }
+
+        if(emit) {
+            // Emit return
+            error = cio_module_internal_stream_emit(stream, (cio_instruction_t) {CIO_OPERAND_MAX, CIO_RET});
+            if(error) return error;
+
+            // Write out each routine as its block closes
+            error = cio_module_internal_stream_flush(stream);
+            if(error) return error;
+        }
+        else ++stream->code_size;
+    }
+
+    return GEN_NULL;
+}
 
-	error = gen_memory_copy(*out_bytecode, *out_bytecode_length, header, header_size, header_size);
+// Rewinds a stream to the start of the source for another pass
+static void cio_module_internal_stream_rewind(cio_module_internal_stream_t* const restrict stream) {
+    stream->window_length = 0;
+    stream->window_offset = 0;
+    stream->final = gen_false;
+    stream->scan_offset = 0;
+    stream->lines_offset = 0;
+    stream->line = 1;
+    stream->line_start = 0;
+    stream->tokens_length = 0;
+    stream->tokens_index = 0;
+    stream->current = (cio_token_t) {0};
+}
+
+gen_error_t* cio_module_emit_stream(const cio_stream_reader_t reader, void* const reader_data, const cio_stream_writer_t writer, void* const writer_data, const char* const restrict source_file, const gen_size_t source_file_length, const cio_warning_settings_t* const restrict warning_settings) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_module_emit_stream, GEN_FILE_NAME);
 	if(error) return error;
 
-	if(code) {
-		error = gen_memory_copy(*out_bytecode + header_size, *out_bytecode_length - header_size, code, code_size, code_size);
-		if(error) return error;
-	}
+	if(!reader) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`reader` was `GEN_NULL`");
+	if(!writer) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`writer` was `GEN_NULL`");
+	if(!source_file) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`source_file` was `GEN_NULL`");
+	if(!warning_settings) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`warning_settings` was `GEN_NULL`");
 
-    bytecode_cleanup = GEN_NULL;
+    GEN_CLEANUP_FUNCTION(cio_module_internal_emit_stream_cleanup_stream) cio_module_internal_stream_t stream = {0};
+    stream.reader = reader;
+    stream.reader_data = reader_data;
+    stream.writer = writer;
+    stream.writer_data = writer_data;
+    stream.source_file = source_file;
+    stream.source_file_length = source_file_length;
+    stream.warning_settings = warning_settings;
+    stream.program.arena = gen_true;
 
-	return GEN_NULL;
+    stream.window_capacity = CIO_STREAM_BUFFER_LENGTH;
+    error = gen_memory_allocate_zeroed((void**) &stream.window, stream.window_capacity, sizeof(char));
+    if(error) return error;
+
+    error = gen_memory_allocate_zeroed((void**) &stream.tokens, CIO_MODULE_INTERNAL_STREAM_TOKENS, sizeof(cio_token_t));
+    if(error) return error;
+
+    error = gen_memory_allocate_zeroed((void**) &stream.positions, CIO_MODULE_INTERNAL_STREAM_TOKENS, sizeof(cio_module_internal_stream_position_t));
+    if(error) return error;
+
+    error = gen_memory_allocate_zeroed((void**) &stream.code, CIO_STREAM_BUFFER_LENGTH, sizeof(cio_instruction_t));
+    if(error) return error;
+
+    // Layout
+    cio_module_internal_stream_rewind(&stream);
+    error = cio_module_internal_stream_pass(&stream, gen_false);
+    if(error) return error;
+
+    const cio_program_t* const program = &stream.program;
+
+    if(program->routines_length >= CIO_ROUTINE_EXTERNAL) {
+        error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom", "%uz routines exceeds maximum of %uz allowed by bytecode format in %t", program->routines_length, (gen_size_t) CIO_ROUTINE_EXTERNAL - 1, source_file);
+        if(error) return error;
+
+        return gen_error_attach_backtrace_formatted(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "%uz routines exceeds maximum of %uz allowed by bytecode format in %t", program->routines_length, (gen_size_t) CIO_ROUTINE_EXTERNAL - 1, source_file);
+    }
+
+    if(stream.code_size >= CIO_ROUTINE_EXTERNAL) {
+        error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom", "Emitted code section size %uz exceeds maximum of %uz allowed by bytecode format in %t", stream.code_size, (gen_size_t) CIO_ROUTINE_EXTERNAL, source_file);
+        if(error) return error;
+
+        return gen_error_attach_backtrace_formatted(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "Emitted code section size %uz exceeds maximum of %uz allowed by bytecode format in %t", stream.code_size, (gen_size_t) CIO_ROUTINE_EXTERNAL, source_file);
+    }
+
+    error = cio_module_internal_index_routines(program, &stream.routine_index);
+    if(error) return error;
+
+    // Header
+    {
+        gen_size_t header_size = sizeof(cio_header_t);
+        for(gen_size_t i = 0; i < program->routines_length; ++i) {
+            gen_size_t identifier_length = 0;
+            error = gen_string_length(program->routines[i].identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &identifier_length);
+            if(error) return error;
+
+            header_size += sizeof(cio_routine_table_entry_t) + identifier_length + 1;
+        }
+
+        GEN_CLEANUP_FUNCTION(cio_module_internal_emit_cleanup_bytecode) unsigned char* header = GEN_NULL;
+        error = gen_memory_allocate_zeroed((void**) &header, header_size, sizeof(unsigned char));
+        if(error) return error;
+
+        error = cio_module_internal_emit_header(program, stream.offsets, header);
+        if(error) return error;
+
+        error = writer(writer_data, header, header_size);
+        if(error) return error;
+    }
+
+    // Codegen
+    cio_module_internal_stream_rewind(&stream);
+    error = cio_module_internal_stream_pass(&stream, gen_true);
+    if(error) return error;
+
+    return cio_module_internal_stream_flush(&stream);
 }
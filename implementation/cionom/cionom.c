@@ -39,6 +39,19 @@ gen_error_t* cio_column_from_offset(const gen_size_t offset, gen_size_t* const r
 	return GEN_NULL;
 }
 
+// FNV-1a
+// Used by the parser's interner, the emitter's routine index and the VM's symbol table
+extern gen_uint64_t cio_internal_hash(const char* const restrict identifier, const gen_size_t length);
+gen_uint64_t cio_internal_hash(const char* const restrict identifier, const gen_size_t length) {
+    gen_uint64_t hash = 0xCBF29CE484222325;
+    for(gen_size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char) identifier[i];
+        hash *= 0x100000001B3;
+    }
+
+    return hash;
+}
+
 static const char cio_internal_vm_mangled_grapheme_keys[] = {
 	'+',
 	'-',
@@ -198,3 +211,65 @@ gen_error_t* cio_resolve_external(const char* const restrict identifier, cio_rou
 
 	return GEN_NULL;
 }
+
+// Resolves the symbol of a mangled identifier with a prefix, as used to attach extra definitions to external routines
+static gen_error_t* cio_internal_resolve_external_prefixed(const char* const restrict prefix, const gen_size_t prefix_length, const char* const restrict identifier, void* const restrict out_address, const gen_dynamic_library_handle_t* const restrict lib) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_internal_resolve_external_prefixed, GEN_FILE_NAME);
+	if(error) return error;
+
+	GEN_CLEANUP_FUNCTION(cio_internal_resolve_external_cleanup_mangled) char* mangled = GEN_NULL;
+	error = cio_mangle_identifier(identifier, &mangled);
+	if(error) return error;
+
+    gen_size_t mangled_length = 0;
+    error = gen_string_length(mangled, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &mangled_length);
+	if(error) return error;
+
+    const gen_size_t symbol_length = prefix_length + mangled_length;
+	GEN_CLEANUP_FUNCTION(cio_internal_resolve_external_cleanup_mangled) char* symbol = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &symbol, symbol_length + 1, sizeof(char));
+	if(error) return error;
+
+    error = gen_string_append(symbol, symbol_length + 1, prefix, prefix_length + 1, prefix_length);
+	if(error) return error;
+    error = gen_string_append(symbol, symbol_length + 1, mangled, mangled_length + 1, mangled_length);
+	if(error) return error;
+
+	error = gen_dynamic_library_handle_get_symbol(lib, symbol, symbol_length, out_address);
+	if(error) return error;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_resolve_external_fast(const char* const restrict identifier, cio_fast_routine_function_t* const out_function, const gen_dynamic_library_handle_t* const restrict lib) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_resolve_external_fast, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!identifier) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`identifier` was `GEN_NULL`");
+	if(!out_function) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_function` was `GEN_NULL`");
+
+	error = cio_internal_resolve_external_prefixed(CIO_FAST_ROUTINE_PREFIX, sizeof(CIO_FAST_ROUTINE_PREFIX) - 1, identifier, (void*) out_function, lib);
+	if(error) return error;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_resolve_external_reads_caller(const char* const restrict identifier, gen_bool_t* const restrict out_reads_caller, const gen_dynamic_library_handle_t* const restrict lib) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_resolve_external_reads_caller, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!identifier) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`identifier` was `GEN_NULL`");
+	if(!out_reads_caller) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_reads_caller` was `GEN_NULL`");
+
+    *out_reads_caller = gen_false;
+
+    // Routines without a marker do not read past their caller's frame
+    const gen_bool_t* marker = GEN_NULL;
+	error = cio_internal_resolve_external_prefixed(CIO_READS_CALLER_PREFIX, sizeof(CIO_READS_CALLER_PREFIX) - 1, identifier, (void*) &marker, lib);
+	if(error && error->type == GEN_ERROR_NO_SUCH_OBJECT) return GEN_NULL;
+	if(error) return error;
+
+    *out_reads_caller = *marker;
+
+	return GEN_NULL;
+}
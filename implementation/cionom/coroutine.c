@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/cionom.h"
+
+#include <genmemory.h>
+#include <genlog.h>
+
+extern gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_interpret(cio_vm_t* const restrict vm, const gen_size_t entry_frame, const gen_bool_t resumable);
+
+// Exchanges the execution state of a VM with that of a coroutine
+// Switching into and back out of a coroutine are the same operation
+static void cio_vm_internal_coroutine_switch(cio_vm_t* const restrict vm, cio_coroutine_t* const restrict coroutine) {
+#define CIO_VM_INTERNAL_SWAP(type, field) \
+    do { \
+        type const swapped = vm->field; \
+        vm->field = coroutine->field; \
+        coroutine->field = swapped; \
+    } while(0)
+
+    // A sample taken mid-switch could see the frames of one stack with the length of another
+    if(vm->sampler) __atomic_store_n(&vm->sampler->paused, gen_true, __ATOMIC_SEQ_CST);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+    CIO_VM_INTERNAL_SWAP(gen_size_t*, stack);
+    CIO_VM_INTERNAL_SWAP(gen_size_t, stack_length);
+    CIO_VM_INTERNAL_SWAP(gen_size_t, stack_high_water);
+    CIO_VM_INTERNAL_SWAP(cio_frame_t*, frames);
+    CIO_VM_INTERNAL_SWAP(gen_size_t, frames_used);
+    CIO_VM_INTERNAL_SWAP(gen_size_t, frames_length);
+    CIO_VM_INTERNAL_SWAP(gen_size_t, current_bytecode);
+
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    if(vm->sampler) __atomic_store_n(&vm->sampler->paused, gen_false, __ATOMIC_SEQ_CST);
+
+#undef CIO_VM_INTERNAL_SWAP
+}
+
+// Frees a coroutine's stack segment and the coroutine itself
+static gen_error_t* cio_vm_internal_coroutine_free(cio_coroutine_t** const restrict coroutine) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_coroutine_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if((*coroutine)->stack) {
+        error = gen_memory_free((void**) &(*coroutine)->stack);
+        if(error) return error;
+    }
+    if((*coroutine)->frames) {
+        error = gen_memory_free((void**) &(*coroutine)->frames);
+        if(error) return error;
+    }
+
+    return gen_memory_free((void**) coroutine);
+}
+
+static void cio_vm_internal_coroutine_cleanup(cio_coroutine_t** coroutine) {
+    if(!*coroutine) return;
+
+    gen_error_t* error = cio_vm_internal_coroutine_free(coroutine);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+gen_error_t* cio_vm_start_coroutine(cio_vm_t* const restrict vm, const gen_size_t callable, const gen_size_t* const restrict parameters, const gen_size_t parameters_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_start_coroutine, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!parameters && parameters_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`parameters` was `GEN_NULL`");
+
+    if(!vm->settings.trampoline) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "Coroutines require the `trampoline` VM setting");
+	if(callable >= vm->bytecode[vm->current_bytecode].callables_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_BOUNDS, GEN_LINE_NUMBER, "`callable` was greater than the current module's callables length");
+
+    const gen_size_t stack_length = vm->settings.coroutine_stack_length ? vm->settings.coroutine_stack_length : CIO_COROUTINE_STACK_LENGTH_DEFAULT;
+    if(parameters_length + 1 > stack_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "Stack overflow");
+
+    // Stack segments of finished coroutines are reused - their cells are zeroed on push as the VM's are
+    cio_coroutine_t* coroutine = vm->coroutines_free;
+    if(coroutine) vm->coroutines_free = coroutine->next;
+    else {
+        GEN_CLEANUP_FUNCTION(cio_vm_internal_coroutine_cleanup) cio_coroutine_t* allocated = GEN_NULL;
+        error = gen_memory_allocate_zeroed((void**) &allocated, 1, sizeof(cio_coroutine_t));
+        if(error) return error;
+
+        allocated->stack_length = stack_length;
+        error = gen_memory_allocate_zeroed((void**) &allocated->stack, allocated->stack_length, sizeof(gen_size_t));
+        if(error) return error;
+        allocated->frames_length = stack_length;
+        error = gen_memory_allocate_zeroed((void**) &allocated->frames, allocated->frames_length, sizeof(cio_frame_t));
+        if(error) return error;
+
+        coroutine = allocated;
+        allocated = GEN_NULL;
+    }
+
+    // The parameters are left orphaned above the reserve space for the routine's frame to take
+    coroutine->stack[0] = 0;
+    if(parameters_length) {
+        error = gen_memory_copy(&coroutine->stack[1], (coroutine->stack_length - 1) * sizeof(gen_size_t), parameters, parameters_length * sizeof(gen_size_t), parameters_length * sizeof(gen_size_t));
+        if(error) return error;
+    }
+    if(parameters_length + 1 > coroutine->stack_high_water) coroutine->stack_high_water = parameters_length + 1;
+
+    coroutine->frames[0] = (cio_frame_t) {0, 1, 0, vm->current_bytecode};
+    coroutine->frames_used = 1;
+    coroutine->current_bytecode = vm->current_bytecode;
+    coroutine->routine = callable;
+    coroutine->parameters_length = parameters_length;
+    coroutine->started = gen_false;
+    coroutine->parked = gen_false;
+    coroutine->next = GEN_NULL;
+
+    if(vm->coroutines_last) vm->coroutines_last->next = coroutine;
+    else vm->coroutines = coroutine;
+    vm->coroutines_last = coroutine;
+
+	return GEN_NULL;
+}
+
+// Runs a coroutine until it yields or finishes
+static gen_error_t* cio_vm_internal_coroutine_resume(cio_vm_t* const restrict vm, cio_coroutine_t* const restrict coroutine, gen_bool_t* const restrict out_finished) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_coroutine_resume, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "%t coroutine %p", coroutine->started ? "Resuming" : "Starting", (void*) coroutine);
+
+    cio_vm_internal_coroutine_switch(vm, coroutine);
+    vm->coroutine = coroutine;
+
+    // Calls in the coroutine are counted as time in whatever ran the scheduler, as their frames are not on the profiled call stack
+    cio_profile_t* const profile = vm->profile;
+    vm->profile = GEN_NULL;
+
+    gen_error_t* result = GEN_NULL;
+    if(coroutine->started) result = cio_vm_internal_interpret(vm, 1, gen_true);
+    else {
+        coroutine->started = gen_true;
+
+        const gen_size_t slot = vm->bytecode[vm->current_bytecode].callables_offset + coroutine->routine;
+        const cio_dispatch_t* const target = &vm->dispatch[slot];
+        if(target->function == cio_vm_internal_execute_routine) {
+            // Enter the routine as `op_call` would, so the loop it executes in is the one it can yield to
+            // The frame is written before it is counted, as the sampler may read it at any point
+            cio_frame_t* const callee = &vm->frames[vm->frames_used];
+            callee->base = 1;
+            callee->height = coroutine->parameters_length;
+            callee->execution_offset = target->offset;
+            callee->bytecode_index = target->bytecode_index;
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+            ++vm->frames_used;
+            vm->current_bytecode = target->bytecode_index;
+
+            result = cio_vm_internal_interpret(vm, 1, gen_true);
+        }
+        else {
+            // External routines run to completion
+            result = cio_vm_dispatch_call(vm, coroutine->routine, coroutine->parameters_length);
+            vm->yield_requested = gen_false;
+        }
+    }
+
+    *out_finished = result || !vm->yield_requested;
+    vm->yield_requested = gen_false;
+
+    if(*out_finished && coroutine->parked) {
+        coroutine->parked = gen_false;
+        --vm->coroutines_parked;
+    }
+
+    // Finished (or failed) coroutines have their frames popped to be reused
+    if(*out_finished) {
+        while(vm->frames_used) {
+            error = cio_vm_pop_frame(vm);
+            if(error) return error;
+        }
+    }
+
+    vm->profile = profile;
+    vm->coroutine = GEN_NULL;
+    cio_vm_internal_coroutine_switch(vm, coroutine);
+
+    if(*out_finished) {
+        coroutine->next = vm->coroutines_free;
+        vm->coroutines_free = coroutine;
+    }
+
+    return result;
+}
+
+// Runs each waiting coroutine in turn - those started meanwhile wait until the next round
+static gen_error_t* cio_vm_internal_coroutine_round(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_coroutine_round, GEN_FILE_NAME);
+	if(error) return error;
+
+    const cio_coroutine_t* const last = vm->coroutines_last;
+    gen_bool_t done = !last;
+    while(!done) {
+        cio_coroutine_t* const coroutine = vm->coroutines;
+        done = coroutine == last;
+
+        vm->coroutines = coroutine->next;
+        if(!vm->coroutines) vm->coroutines_last = GEN_NULL;
+        coroutine->next = GEN_NULL;
+
+        gen_bool_t finished = gen_false;
+        error = cio_vm_internal_coroutine_resume(vm, coroutine, &finished);
+        if(error) return error;
+
+        if(!finished && !coroutine->parked) {
+            if(vm->coroutines_last) vm->coroutines_last->next = coroutine;
+            else vm->coroutines = coroutine;
+            vm->coroutines_last = coroutine;
+        }
+    }
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_yield(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_yield, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+
+    // The interpreter suspends the coroutine once control returns to it
+    if(vm->coroutine) {
+        vm->yield_requested = gen_true;
+        return GEN_NULL;
+    }
+
+    return cio_vm_internal_coroutine_round(vm);
+}
+
+gen_error_t* cio_vm_park_coroutine(cio_vm_t* const restrict vm, cio_coroutine_t** const restrict out_coroutine) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_park_coroutine, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!out_coroutine) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_coroutine` was `GEN_NULL`");
+	if(!vm->coroutine) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "No coroutine is running to park");
+
+    // Parked coroutines are suspended as if they had yielded, but are not requeued
+    vm->coroutine->parked = gen_true;
+    ++vm->coroutines_parked;
+    vm->yield_requested = gen_true;
+
+    *out_coroutine = vm->coroutine;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_vm_wake_coroutine(cio_vm_t* const restrict vm, cio_coroutine_t* const restrict coroutine) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_wake_coroutine, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!coroutine) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`coroutine` was `GEN_NULL`");
+	if(!coroutine->parked) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "`coroutine` was not parked");
+
+    coroutine->parked = gen_false;
+    --vm->coroutines_parked;
+
+    coroutine->next = GEN_NULL;
+    if(vm->coroutines_last) vm->coroutines_last->next = coroutine;
+    else vm->coroutines = coroutine;
+    vm->coroutines_last = coroutine;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_vm_run_coroutines(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_run_coroutines, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(vm->coroutine) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "Coroutines cannot be run from within a coroutine");
+
+    while(vm->coroutines || vm->coroutines_parked) {
+        if(!vm->coroutines) {
+            if(!vm->image->external_lib_on_idle) return gen_error_attach_backtrace_formatted(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "%uz coroutines are parked with nothing to wake them", vm->coroutines_parked);
+
+            error = vm->image->external_lib_on_idle(vm);
+            if(error) return error;
+
+            continue;
+        }
+
+        error = cio_vm_internal_coroutine_round(vm);
+        if(error) return error;
+    }
+
+	return GEN_NULL;
+}
+
+// Frees the coroutines of a VM
+// Used by `cio_vm_free`
+extern gen_error_t* cio_vm_internal_coroutines_free(cio_vm_t* const restrict vm);
+gen_error_t* cio_vm_internal_coroutines_free(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_coroutines_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_coroutine_t* const lists[] = {vm->coroutines, vm->coroutines_free};
+    for(gen_size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); ++i) {
+        cio_coroutine_t* coroutine = lists[i];
+        while(coroutine) {
+            cio_coroutine_t* next = coroutine->next;
+
+            error = cio_vm_internal_coroutine_free(&coroutine);
+            if(error) return error;
+
+            coroutine = next;
+        }
+    }
+
+    vm->coroutines = GEN_NULL;
+    vm->coroutines_last = GEN_NULL;
+    vm->coroutines_free = GEN_NULL;
+
+	return GEN_NULL;
+}
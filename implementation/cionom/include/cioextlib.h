@@ -10,6 +10,7 @@
     GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN) \
     GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Wmissing-prototypes")) \
     GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Wreserved-identifier")) \
+    GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Wunused-parameter")) \
 
 /**
  * Ends a block of runtime library definitions.
@@ -33,3 +34,61 @@
         if(error) return error; \
     } while(0)
 
+/**
+ * Gets the symbol of a runtime library routine's fast calling convention.
+ * @note Must agree with `CIO_FAST_ROUTINE_PREFIX`.
+ * @param name the mangled name of the routine.
+ */
+#define CIO_EXTLIB_FAST_NAME(name) __cionom_fast_##name
+
+/**
+ * Gets the symbol marking a runtime library routine as reading its caller's caller's frame.
+ * @note Must agree with `CIO_READS_CALLER_PREFIX`.
+ * @param name the mangled name of the routine.
+ */
+#define CIO_EXTLIB_READS_CALLER_NAME(name) __cionom_reads_caller_##name
+
+/**
+ * Marks a runtime library routine as reading its caller's caller's frame, e.g. through `cio_vm_get_frame`.
+ * Cíonom routines calling it are not entered by tail calls, which would replace the frame it reads.
+ * @param name the mangled name of the routine.
+ */
+#define CIO_EXTLIB_READS_CALLER(name) \
+    extern const gen_bool_t CIO_EXTLIB_READS_CALLER_NAME(name); \
+    const gen_bool_t CIO_EXTLIB_READS_CALLER_NAME(name) = gen_true
+
+/**
+ * Defines a runtime library routine using the fast calling convention.
+ * Also defines the routine's regular `cio_routine_function_t` symbol, which calls through to it.
+ * The routine's body should follow, with `vm`, `current`, `caller` and `caller_frame` in scope, and return a `cio_status_t`.
+ * @param name the mangled name of the routine.
+ */
+#define CIO_EXTLIB_ROUTINE(name) \
+    cio_status_t CIO_EXTLIB_FAST_NAME(name)(cio_vm_t* const restrict vm, gen_size_t* const current, gen_size_t* const caller, cio_frame_t* const restrict caller_frame); \
+    gen_error_t* name(cio_vm_t* const restrict vm) { \
+        GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) name, GEN_FILE_NAME); \
+        if(error) return error; \
+        \
+        if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`"); \
+        \
+        CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0); \
+        CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1); \
+        \
+        return cio_vm_status_error(vm, CIO_EXTLIB_FAST_NAME(name)(vm, current, caller, caller_frame)); \
+    } \
+    cio_status_t CIO_EXTLIB_FAST_NAME(name)(cio_vm_t* const restrict vm, gen_size_t* const current, gen_size_t* const caller, cio_frame_t* const restrict caller_frame)
+
+/**
+ * Raises an error from a routine using the fast calling convention if one occurred.
+ * @param vm the vm pointer the routine is executing in.
+ * @param expression the expression producing the error.
+ */
+#define CIO_EXTLIB_PROPAGATE(vm, expression) \
+    do { \
+        gen_error_t* const cio_extlib_propagated_error = (expression); \
+        if(cio_extlib_propagated_error) { \
+            (vm)->fault = cio_extlib_propagated_error; \
+            return &cio_fault_propagated; \
+        } \
+    } while(0)
+
@@ -107,6 +107,35 @@ typedef struct {
     gen_size_t length;
 } cio_token_t;
 
+/**
+ * The maximum length of a source which may be tokenized into packed tokens.
+ */
+#define CIO_PACKED_TOKEN_OFFSET_MAX GEN_UINT32_MAX
+
+/**
+ * The maximum length of a single packed token.
+ */
+#define CIO_PACKED_TOKEN_LENGTH_MAX 0x3FFFFFFF
+
+/**
+ * A compact source token for large sources.
+ * Carries the same information as `cio_token_t` in a third of the space.
+ */
+typedef struct {
+    /**
+     * The offset into the source buffer at which this token begins.
+     */
+    gen_uint32_t offset;
+    /**
+     * The number of characters in the source which this token occupies.
+     */
+    gen_uint32_t length : 30;
+    /**
+     * The type of this token as a `cio_token_type_t`.
+     */
+    gen_uint32_t type : 2;
+} cio_packed_token_t;
+
 /**
  * A call node in the program representation.
  */
@@ -163,6 +192,33 @@ typedef struct {
     const cio_token_t* token;
 } cio_routine_t;
 
+/**
+ * The default size of a block of arena storage.
+ */
+#define CIO_ARENA_BLOCK_LENGTH (256 * 1024)
+
+/**
+ * A block of bump-allocated storage.
+ */
+typedef struct cio_arena_block_t {
+    /**
+     * The block allocated before this one.
+     */
+    struct cio_arena_block_t* previous;
+    /**
+     * The number of bytes of storage in this block.
+     */
+    gen_size_t capacity;
+    /**
+     * The number of bytes of storage allocated from this block.
+     */
+    gen_size_t used;
+    /**
+     * The block's storage.
+     */
+    unsigned char storage[];
+} cio_arena_block_t;
+
 /**
  * The program representation.
  */
@@ -175,8 +231,45 @@ typedef struct {
      * The program's routines.
      */
     cio_routine_t* routines;
+
+    /**
+     * Whether the program's storage is allocated from an arena.
+     * Set before parsing into an empty program. Routines, calls, parameters and identifiers are then bump-allocated and freed together by `cio_program_free`.
+     * Identifiers are interned, so equal identifiers within an arena-backed program share storage.
+     */
+    gen_bool_t arena;
+    /**
+     * The most recently allocated arena block if `arena` is set.
+     */
+    cio_arena_block_t* arena_blocks;
 } cio_program_t;
 
+/**
+ * The length of the window through which `cio_module_emit_stream` reads source, and of the buffer through which it writes code.
+ * The window only grows past this length to fit longer tokens.
+ */
+#define CIO_STREAM_BUFFER_LENGTH (64 * 1024)
+
+/**
+ * Reads part of a source for `cio_module_emit_stream`.
+ * @param[in] user_data the user data passed alongside the reader.
+ * @param[in] offset the offset into the source at which to begin reading.
+ * @param[out] out_buffer storage for the bytes read.
+ * @param[in] length the maximum number of bytes to read.
+ * @param[out] out_length a pointer to storage for the number of bytes read, which may be fewer than `length`. Zero marks the end of the source.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+typedef gen_error_t* (*cio_stream_reader_t)(void* const restrict user_data, const gen_size_t offset, char* const restrict out_buffer, const gen_size_t length, gen_size_t* const restrict out_length);
+
+/**
+ * Writes the next part of the bytecode emitted by `cio_module_emit_stream`.
+ * @param[in] user_data the user data passed alongside the writer.
+ * @param[in] buffer the bytecode to write.
+ * @param[in] length the length of `buffer`.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+typedef gen_error_t* (*cio_stream_writer_t)(void* const restrict user_data, const unsigned char* const restrict buffer, const gen_size_t length);
+
 typedef struct cio_vm_t cio_vm_t;
 
 /**
@@ -185,116 +278,810 @@ typedef struct cio_vm_t cio_vm_t;
 typedef gen_error_t* (*cio_routine_function_t)(cio_vm_t* const restrict);
 
 /**
- * A call frame in the VM.
+ * Describes the failure of a routine using the fast calling convention.
+ */
+typedef struct {
+    /**
+     * The type of error to raise.
+     */
+    gen_error_type_t type;
+    /**
+     * The context of the error to raise.
+     */
+    const char* context;
+} cio_fault_t;
+
+/**
+ * The result of a routine using the fast calling convention.
+ * `CIO_STATUS_OK` on success, otherwise the fault to raise.
+ */
+typedef const cio_fault_t* cio_status_t;
+
+/**
+ * The status of a routine using the fast calling convention which succeeded.
+ */
+#define CIO_STATUS_OK GEN_NULL
+
+/**
+ * The fault returned by a routine using the fast calling convention to raise the error stored in `cio_vm_t.fault`.
+ */
+extern const cio_fault_t cio_fault_propagated;
+
+typedef struct cio_frame_t cio_frame_t;
+
+/**
+ * The underlying function to be called for a routine using the fast calling convention.
+ * Receives the VM, a pointer to the base of the routine's frame, a pointer to the base of the calling frame and the calling frame itself.
+ */
+typedef cio_status_t (*cio_fast_routine_function_t)(cio_vm_t* const restrict, gen_size_t* const, gen_size_t* const, cio_frame_t* const restrict);
+
+/**
+ * The prefix applied to the mangled identifier of a routine to get the symbol of its fast calling convention.
+ */
+#define CIO_FAST_ROUTINE_PREFIX "__cionom_fast_"
+
+/**
+ * The prefix applied to the mangled identifier of a routine to get the symbol marking it as reading its caller's caller's frame.
+ * The symbol is a `const gen_bool_t`, and routines without one are taken not to.
+ */
+#define CIO_READS_CALLER_PREFIX "__cionom_reads_caller_"
+
+/**
+ * A call frame in the VM.
+ */
+typedef struct cio_frame_t {
+    /**
+     * The offset of the call frame.
+     */
+    gen_size_t base;
+    /**
+     * The height of the call frame.
+     */
+    gen_size_t height;
+    /**
+     * The current point of execution in the bytecode for the call frame.
+     * Will be `CIO_FRAME_BRANCH` for the frame of a branch routine taken inline.
+     */
+    gen_size_t execution_offset;
+    /**
+     * The index of the bytecode module the call frame is executing in.
+     */
+    gen_size_t bytecode_index;
+} cio_frame_t;
+
+/**
+ * Frame execution offset denoting the frame of a branch routine taken inline by the interpreter when trampolining.
+ * The frame is kept beneath the routine branched to so it sees the same frames, but is not executing.
+ * Code walking `cio_vm_t.frames` should skip such frames when looking for executing routines.
+ */
+#define CIO_FRAME_BRANCH GEN_SIZE_MAX
+
+typedef struct {
+    /**
+     * The identifier of this callable.
+     */
+    const char* identifier;
+    /**
+     * The length of the identifier of this callable.
+     */
+    gen_size_t identifier_length;
+    /**
+     * The underlying function to call for this callable.
+     */
+    cio_routine_function_t function;
+    /**
+     * The index of the bytecode module this callable originates from.
+     */
+    gen_size_t bytecode_index;
+    /**
+     * The offset into the bytecode buffer this callable begins at.
+     */
+    gen_size_t offset;
+    /**
+     * The index of this callable.
+     */
+    gen_size_t routine_index;
+} cio_callable_t;
+
+/**
+ * An entry in the VM's identifier hash table.
+ * Indices are stored offset by one into the VM's `callables` table so that zeroed entries are unoccupied.
+ */
+typedef struct {
+    /**
+     * The precomputed hash of the identifier.
+     */
+    gen_uint64_t hash;
+    /**
+     * One plus the index of the first internal callable with this identifier, or 0 if there is none.
+     */
+    gen_size_t internal;
+    /**
+     * One plus the index of the last pure-external callable with this identifier, or 0 if there is none.
+     */
+    gen_size_t external;
+} cio_symbol_t;
+
+typedef struct {
+
+} cio_module_debug_info_t;
+
+typedef enum {
+    CIO_EXTENSION_ID_ELIDE_RESERVE_SPACE = 0,
+    CIO_EXTENSION_ID_CONSTANTS = 2,
+    CIO_EXTENSION_ID_NIL_CALLS = 3,
+    CIO_EXTENSION_ID_BREAKPOINTS = 4,
+    CIO_EXTENSION_ID_DEBUG_INFO = 5,
+    CIO_EXTENSION_ID_ENCODE_STACK_LENGTH = 6
+} cio_extension_id_t;
+
+typedef struct {
+    cio_extension_id_t id;
+    union {
+        struct {} elide_reserve_space;
+        struct {
+            gen_size_t size;
+            gen_uint8_t* data;
+        } constants;
+        struct {
+            gen_size_t nil_call_index;
+            gen_size_t nil_call_frame_index;
+        } nil_calls;
+        struct {} breakpoints;
+        cio_module_debug_info_t debug_info;
+        struct {
+            gen_size_t length;
+        } encode_stack_length;
+    };
+} cio_extension_data_t;
+
+/**
+ * The opcode of a pre-decoded instruction.
+ */
+typedef enum {
+    /**
+     * Push the operand into the current frame.
+     */
+    CIO_DECODED_PUSH,
+    /**
+     * An encoding of `push 0x7F` - processes an extension if the current frame is non-empty, otherwise behaves as `CIO_DECODED_PUSH`.
+     */
+    CIO_DECODED_EXTENSION,
+    /**
+     * Call the routine at the operand slot in the VM's dispatch table.
+     */
+    CIO_DECODED_CALL,
+    /**
+     * Return from the current routine.
+     */
+    CIO_DECODED_RET,
+    /**
+     * A `CIO_DECODED_CALL` directly preceding a return.
+     */
+    CIO_DECODED_TAIL_CALL,
+    /**
+     * A `CIO_DECODED_TAIL_CALL` to the native implementation of `?`.
+     */
+    CIO_DECODED_TAIL_BRANCH,
+    /**
+     * A `CIO_DECODED_TAIL_CALL` to the native implementation of `?+-`.
+     */
+    CIO_DECODED_TAIL_BRANCH_SIGN,
+    /**
+     * A `CIO_DECODED_TAIL_CALL` to the native implementation of `callv`.
+     */
+    CIO_DECODED_TAIL_CALLV,
+    /**
+     * A `CIO_DECODED_PUSH` of the operand which begins a run of 1 push ending in a call, which it goes on to make through the call's own opcode.
+     */
+    CIO_DECODED_PUSH_CALL_1,
+    /**
+     * A `CIO_DECODED_PUSH` of the operand which begins a run of 2 pushes ending in a call, which it goes on to make through the call's own opcode.
+     */
+    CIO_DECODED_PUSH_CALL_2,
+    /**
+     * A `CIO_DECODED_PUSH` of the operand which begins a run of 3 pushes ending in a call, which it goes on to make through the call's own opcode.
+     */
+    CIO_DECODED_PUSH_CALL_3,
+    /**
+     * A `CIO_DECODED_PUSH` of the operand which begins a run of 4 pushes ending in a call, which it goes on to make through the call's own opcode.
+     */
+    CIO_DECODED_PUSH_CALL_4,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `+`, executed inline.
+     */
+    CIO_DECODED_INTRINSIC_ADD,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `-`, executed inline.
+     */
+    CIO_DECODED_INTRINSIC_SUBTRACT,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `copy=`, executed inline.
+     */
+    CIO_DECODED_INTRINSIC_COPY,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `copy=v`, executed inline.
+     */
+    CIO_DECODED_INTRINSIC_COPY_VARIABLE,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `copy*[+]=c`, executed inline.
+     */
+    CIO_DECODED_INTRINSIC_STORE_CHAR,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `?` in a trampolining VM, branched inline.
+     */
+    CIO_DECODED_INTRINSIC_BRANCH,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `?+-` in a trampolining VM, branched inline.
+     */
+    CIO_DECODED_INTRINSIC_BRANCH_SIGN,
+    /**
+     * A `CIO_DECODED_CALL` to the native implementation of `callv` in a trampolining VM, called inline.
+     */
+    CIO_DECODED_INTRINSIC_CALLV
+} cio_decoded_opcode_t;
+
+/**
+ * An instruction decoded ahead of execution by the VM.
+ */
+typedef struct {
+    /**
+     * The opcode of the instruction.
+     */
+    gen_uint32_t opcode;
+    /**
+     * The operand to the instruction.
+     */
+    gen_uint32_t operand;
+} cio_decoded_instruction_t;
+
+/**
+ * A bytecode file consumed by the VM.
+ */
+typedef struct {
+    cio_extension_settings_t extension_settings;
+    cio_extension_data_t* extensions;
+    gen_size_t extensions_length;
+
+    /**
+     * The bytecode data to execute.
+     */
+    const unsigned char* bytecode;
+    /**
+     * The size of the bytecode data.
+     */
+    gen_size_t size;
+    /**
+     * The pre-decoded form of the bytecode data.
+     * Indexed by the same offsets as `bytecode`.
+     */
+    cio_decoded_instruction_t* decoded;
+
+    /**
+     * The callable routines for this module.
+     * Points into the VM's `callables` table.
+     */
+    cio_callable_t* callables;
+    /**
+     * The number of callable routines for this module.
+     */
+    gen_size_t callables_length;
+    /**
+     * The index of this module's first callable in the VM's `callables` table.
+     */
+    gen_size_t callables_offset;
+} cio_bytecode_t;
+
+/**
+ * The resolved target of a callable, as used by the VM to dispatch calls.
+ */
+typedef struct {
+    /**
+     * The underlying function to call.
+     */
+    cio_routine_function_t function;
+    /**
+     * The fast calling convention of the underlying function, if the external library provides one.
+     */
+    cio_fast_routine_function_t fast;
+    /**
+     * The pre-decoded code to begin execution at.
+     * `GEN_NULL` for external routines.
+     */
+    const cio_decoded_instruction_t* code;
+    /**
+     * The index of the bytecode module to execute in.
+     */
+    gen_uint32_t bytecode_index;
+    /**
+     * The offset into the bytecode module to begin execution at.
+     */
+    gen_uint32_t offset;
+    /**
+     * Whether the routine calls an external routine marked as reading its caller's caller's frame (e.g. `copy=cvv`), so reads its own caller's frame through it.
+     * Such routines are never entered by a tail call, which would replace the frame they read.
+     */
+    gen_bool_t observes_caller;
+    /**
+     * Whether the external routine is marked as reading its caller's caller's frame with `CIO_EXTLIB_READS_CALLER`.
+     * Only resolved with the `tail_calls` setting.
+     */
+    gen_bool_t reads_caller;
+} cio_dispatch_t;
+
+/**
+ * Execution settings for a VM.
+ */
+typedef struct {
+    /**
+     * Dispatch calls and returns between Cíonom routines from within a single interpreter loop rather than recursing natively.
+     * Only calls to external routines are made natively, and are the only calls to pass through `external_lib_call_wrapper`.
+     * Calls made through `?`, `?+-` and `callv` are also dispatched from within the loop, whatever the other settings.
+     */
+    gen_bool_t trampoline;
+    /**
+     * Reuse the current frame for calls to Cíonom routines which directly precede a return, including those made through `?`, `?+-` and `callv`.
+     * Routines which call external routines marked with `CIO_EXTLIB_READS_CALLER` (e.g. `copy=cvv`) are called normally so that they read the same frame as without tail calls.
+     * Other external routines which look beyond their caller's frame (e.g. through `cio_vm_get_frame`) may see the frames of routines which made tail calls replaced by their callees.
+     */
+    gen_bool_t tail_calls;
+    /**
+     * Zero a frame's stack cells when it is popped, as opposed to zeroing cells as they are pushed over.
+     * Cells are always zeroed or written as they are pushed, so this only changes what is seen above the top of the stack.
+     * e.g. a routine reading a stack index past the end of its frame, or an external routine reading more parameters than it was called with.
+     * Without it, such reads see values left behind by earlier calls rather than 0.
+     * Intended for debugging.
+     */
+    gen_bool_t scrub_stack;
+    /**
+     * Always call the native implementations of core routines such as `+` and `copy=`, rather than executing them inline.
+     * `?`, `?+-` and `callv` are still executed inline when trampolining.
+     */
+    gen_bool_t no_intrinsics;
+    /**
+     * Compile Cíonom routines to native code when the VM is initialized.
+     * Calls between compiled routines are made natively and do not pass through `external_lib_call_wrapper`.
+     * Routines which cannot be compiled are interpreted, as is everything on unsupported platforms.
+     * Has no effect alongside `trampoline`, `tail_calls`, `profile` or debug prints, which need the interpreter - a warning is logged and everything is interpreted.
+     */
+    gen_bool_t jit;
+    /**
+     * Write `/tmp/perf-PID.map` describing compiled routines so they can be symbolised by `perf`.
+     */
+    gen_bool_t jit_perf_map;
+    /**
+     * Record call counts and times for each callable, and for each call stack, into `cio_vm_t.profile`.
+     * Implies `no_intrinsics` and disables `jit` so that every call is observed.
+     * Calls made within coroutines are attributed to the routine which ran them.
+     */
+    gen_bool_t profile;
+    /**
+     * The length of the stack segment each coroutine executes on.
+     * Defaults to `CIO_COROUTINE_STACK_LENGTH_DEFAULT` if zero.
+     */
+    gen_size_t coroutine_stack_length;
+} cio_vm_settings_t;
+
+/**
+ * The stack length coroutines execute with if `cio_vm_settings_t.coroutine_stack_length` is unset.
+ */
+#define CIO_COROUTINE_STACK_LENGTH_DEFAULT 256
+
+/**
+ * A routine executing as a coroutine within a VM.
+ * While the coroutine is running its stack and frames are exchanged with those of the VM.
+ */
+typedef struct cio_coroutine_t {
+    /**
+     * The coroutine's stack segment.
+     */
+    gen_size_t* stack;
+    /**
+     * The length of `stack`.
+     */
+    gen_size_t stack_length;
+    /**
+     * The number of cells of `stack` which have ever been in use.
+     */
+    gen_size_t stack_high_water;
+
+    /**
+     * The coroutine's call frames.
+     * The first frame holds the routine's parameters - the routine itself executes in the second.
+     */
+    cio_frame_t* frames;
+    /**
+     * The number of call frames in use.
+     */
+    gen_size_t frames_used;
+    /**
+     * The number of call frames available to use.
+     */
+    gen_size_t frames_length;
+
+    /**
+     * The bytecode data bundle being executed.
+     */
+    gen_size_t current_bytecode;
+
+    /**
+     * The index of the routine being executed, relative to the module it was started from.
+     */
+    gen_size_t routine;
+    /**
+     * The number of parameters to the routine.
+     */
+    gen_size_t parameters_length;
+    /**
+     * Whether the routine has begun executing.
+     */
+    gen_bool_t started;
+    /**
+     * Whether the coroutine is suspended until it is woken by `cio_vm_wake_coroutine`.
+     */
+    gen_bool_t parked;
+
+    /**
+     * The next coroutine in the list this coroutine belongs to.
+     */
+    struct cio_coroutine_t* next;
+} cio_coroutine_t;
+
+/**
+ * Profiling totals for a callable.
+ * Times are in nanoseconds.
+ */
+typedef struct {
+    /**
+     * The number of calls made to the callable.
+     */
+    gen_size_t calls;
+    /**
+     * The time spent within the callable, including its callees.
+     * Time within recursive calls is only counted by the outermost.
+     */
+    gen_size_t inclusive;
+    /**
+     * The time spent within the callable, excluding its callees.
+     */
+    gen_size_t exclusive;
+    /**
+     * The number of calls to the callable in progress.
+     */
+    gen_size_t active;
+} cio_profile_callable_t;
+
+/**
+ * A node in the profiled calling context tree, representing a distinct call stack.
+ */
+typedef struct {
+    /**
+     * The index of the callable called, or `GEN_SIZE_MAX` for the root.
+     */
+    gen_size_t callable;
+    /**
+     * The index of the node for the calling stack.
+     */
+    gen_size_t parent;
+    /**
+     * The index of the first node called from this stack, or `GEN_SIZE_MAX` if none.
+     */
+    gen_size_t first_child;
+    /**
+     * The index of the next node called from the same stack as this one, or `GEN_SIZE_MAX` if none.
+     */
+    gen_size_t next_sibling;
+    /**
+     * The time spent with this as the call stack, in nanoseconds.
+     */
+    gen_size_t exclusive;
+} cio_profile_node_t;
+
+/**
+ * A call in progress while profiling.
+ */
+typedef struct {
+    /**
+     * The index of the call stack's node.
+     */
+    gen_size_t node;
+    /**
+     * The time the call began at, in nanoseconds.
+     */
+    gen_size_t start;
+    /**
+     * The time spent in completed callees, in nanoseconds.
+     */
+    gen_size_t children;
+} cio_profile_activation_t;
+
+/**
+ * A profile of the calls made in a VM.
+ */
+typedef struct {
+    /**
+     * The totals for each callable, indexed as `cio_vm_t.callables`.
+     */
+    cio_profile_callable_t* callables;
+
+    /**
+     * The calling context tree. The first node is the root.
+     */
+    cio_profile_node_t* nodes;
+    /**
+     * The number of nodes in `nodes`.
+     */
+    gen_size_t nodes_length;
+    /**
+     * The number of nodes `nodes` has space for.
+     */
+    gen_size_t nodes_capacity;
+
+    /**
+     * The calls in progress.
+     */
+    cio_profile_activation_t* activations;
+    /**
+     * The number of calls in progress.
+     */
+    gen_size_t activations_used;
+    /**
+     * The number of calls `activations` has space for.
+     */
+    gen_size_t activations_length;
+} cio_profile_t;
+
+/**
+ * The number of frames recorded by a sample, innermost first.
+ */
+#define CIO_SAMPLE_DEPTH_MAX 32
+
+/**
+ * The rate in samples per second of CPU time used by the CLI when sampling.
+ */
+#define CIO_SAMPLE_FREQUENCY_DEFAULT 997
+
+/**
+ * The number of samples the CLI keeps before dropping further samples.
+ */
+#define CIO_SAMPLE_CAPACITY_DEFAULT 16384
+
+/**
+ * A frame recorded by a sample.
+ */
+typedef struct {
+    /**
+     * The index of the bytecode module the frame was executing in.
+     */
+    gen_uint32_t bytecode_index;
+    /**
+     * The execution offset of the frame at the time of the sample.
+     */
+    gen_uint32_t execution_offset;
+} cio_sample_frame_t;
+
+/**
+ * The call stack of a VM at the time of a sample.
+ */
+typedef struct {
+    /**
+     * The number of frames recorded in `frames`.
+     */
+    gen_size_t depth;
+    /**
+     * Whether frames beyond `CIO_SAMPLE_DEPTH_MAX` were left out.
+     */
+    gen_bool_t truncated;
+    /**
+     * The frames of the call stack, innermost first.
+     */
+    cio_sample_frame_t frames[CIO_SAMPLE_DEPTH_MAX];
+} cio_sample_t;
+
+/**
+ * The state of a VM being sampled.
+ * Samples are written by the signal handler and read by `cio_vm_emit_samples`, so the ring is only modified atomically.
+ */
+typedef struct {
+    /**
+     * The ring of samples taken.
+     */
+    cio_sample_t* samples;
+    /**
+     * The number of samples `samples` has space for.
+     */
+    gen_size_t capacity;
+    /**
+     * The number of samples ever written to `samples`.
+     */
+    gen_size_t head;
+    /**
+     * The number of samples ever read from `samples`.
+     */
+    gen_size_t tail;
+    /**
+     * The number of samples dropped because `samples` was full or the call stack was being switched.
+     */
+    gen_size_t dropped;
+    /**
+     * Whether the VM's frames are being switched, so cannot be sampled.
+     */
+    gen_bool_t paused;
+    /**
+     * Whether the sampling timer is running.
+     */
+    gen_bool_t running;
+} cio_sampler_t;
+
+#ifndef CIO_VM_STATS
+/**
+ * Whether VMs count execution statistics.
+ * The counters slow the interpreter by a few percent, so are compiled out unless this is defined as `1`.
+ * The library and its users must agree on this setting - build with `CIONOM_STATS=1` for `cionom-cli --stats`.
+ */
+#define CIO_VM_STATS 0
+#endif
+
+/**
+ * Execution statistics of a VM.
+ * A call into a routine compiled by the `jit` setting is counted once - the instructions, pushes and calls made within compiled code are not counted.
+ */
+typedef struct {
+    /**
+     * The number of bytecode instructions executed.
+     */
+    gen_size_t instructions;
+    /**
+     * The number of `push` instructions executed.
+     */
+    gen_size_t pushes;
+    /**
+     * The number of calls made to Cíonom routines.
+     */
+    gen_size_t cionom_calls;
+    /**
+     * The number of calls made to external routines, including those executed as intrinsics.
+     */
+    gen_size_t external_calls;
+    /**
+     * The number of calls made to routines from a different bytecode module than the caller.
+     */
+    gen_size_t cross_module_calls;
+    /**
+     * The number of extension markers processed during execution.
+     */
+    gen_size_t extension_markers;
+    /**
+     * The greatest number of frames in use at once.
+     */
+    gen_size_t peak_frame_depth;
+    /**
+     * The greatest number of stack cells in use at once.
+     * Does not include the stacks of coroutines.
+     */
+    gen_size_t peak_stack_height;
+    /**
+     * The time taken to load and resolve the VM's program, in nanoseconds.
+     */
+    gen_size_t resolution_time;
+} cio_vm_stats_t;
+
+typedef gen_error_t*(*cio_extlib_call_wrapper_t)(cio_vm_t* const restrict vm, const cio_routine_function_t call);
+typedef gen_error_t*(*cio_extlib_clone_hook_t)(cio_vm_t* const restrict vm, const cio_vm_t* const restrict source);
+
+/**
+ * A loaded and resolved program, shared between the VMs executing it.
+ * Immutable once initialized, so may be used by VMs on any number of threads.
  */
 typedef struct {
     /**
-     * The offset of the call frame.
+     * The number of references held to this image - by its creator and each VM initialized from it.
+     * Modified atomically.
      */
-    gen_size_t base;
+    gen_size_t references;
+
     /**
-     * The height of the call frame.
+     * The bytecode data bundles of the program.
      */
-    gen_size_t height;
+    cio_bytecode_t* bytecode;
     /**
-     * The current point of execution in the bytecode for the call frame.
+     * The number of bytecode data bundles of the program.
      */
-    gen_size_t execution_offset;
-} cio_frame_t;
+    gen_size_t bytecode_length;
 
-typedef struct {
     /**
-     * The identifier of this callable.
+     * The callables of all bytecode modules, in module order.
      */
-    const char* identifier;
+    cio_callable_t* callables;
     /**
-     * The length of the identifier of this callable.
+     * The number of callables in `callables`.
      */
-    gen_size_t identifier_length;
+    gen_size_t callables_length;
     /**
-     * The underlying function to call for this callable.
+     * The resolved dispatch targets of each entry in `callables`.
      */
-    cio_routine_function_t function;
+    cio_dispatch_t* dispatch;
+
     /**
-     * The index of the bytecode module this callable originates from.
+     * The identifier hash table over `callables`.
      */
-    gen_size_t bytecode_index;
+    cio_symbol_t* symbols;
     /**
-     * The offset into the bytecode buffer this callable begins at.
+     * The number of entries in `symbols`. Always a power of two.
      */
-    gen_size_t offset;
+    gen_size_t symbols_length;
+
     /**
-     * The index of this callable.
+     * The library handle from which externally resolved routines were loaded.
      */
-    gen_size_t routine_index;
-} cio_callable_t;
-
-typedef struct {
-
-} cio_module_debug_info_t;
-
-typedef enum {
-    CIO_EXTENSION_ID_ELIDE_RESERVE_SPACE = 0,
-    CIO_EXTENSION_ID_CONSTANTS = 2,
-    CIO_EXTENSION_ID_NIL_CALLS = 3,
-    CIO_EXTENSION_ID_BREAKPOINTS = 4,
-    CIO_EXTENSION_ID_DEBUG_INFO = 5,
-    CIO_EXTENSION_ID_ENCODE_STACK_LENGTH = 6
-} cio_extension_id_t;
-
-typedef struct {
-    cio_extension_id_t id;
-    union {
-        struct {} elide_reserve_space;
-        struct {
-            gen_size_t size;
-            gen_uint8_t* data;
-        } constants;
-        struct {
-            gen_size_t nil_call_index;
-            gen_size_t nil_call_frame_index;
-        } nil_calls;
-        struct {} breakpoints;
-        cio_module_debug_info_t debug_info;
-        struct {
-            gen_size_t length;
-        } encode_stack_length;
-    };
-} cio_extension_data_t;
-
-/**
- * A bytecode file consumed by the VM.
- */
-typedef struct {
-    cio_extension_settings_t extension_settings;
-    cio_extension_data_t* extensions;
-    gen_size_t extensions_length;
+    gen_dynamic_library_handle_t external_lib;
+    /**
+     * The routine run by each VM initialized from this image to set up its extlib state, if any.
+     */
+    cio_routine_function_t external_lib_on_load;
+    /**
+     * The routine run by each VM cloned from another to copy its extlib state, if any.
+     * VMs are cloned by running `external_lib_on_load` if this is absent.
+     */
+    cio_extlib_clone_hook_t external_lib_on_clone;
+    /**
+     * The routine run when every coroutine in a VM is parked, which should block until one is woken, if any.
+     */
+    cio_routine_function_t external_lib_on_idle;
+    /**
+     * The routine run by each VM when it is destroyed to clean up its extlib state, if any.
+     * Runs before the VM's coroutines are freed, so may wake those it has parked for them to be freed too.
+     */
+    cio_routine_function_t external_lib_on_free;
+    /**
+     * VM call wrapper for the extlib, if any.
+     */
+    cio_extlib_call_wrapper_t external_lib_call_wrapper;
 
     /**
-     * The bytecode data to execute.
+     * The executable mapping holding routines compiled by the JIT, if any.
      */
-    const unsigned char* bytecode;
+    void* jit_code;
     /**
-     * The size of the bytecode data.
+     * The size of `jit_code` in bytes.
      */
-    gen_size_t size;
+    gen_size_t jit_code_length;
 
     /**
-     * The callable routines for this module.
+     * The read-only mapping of the file the program was loaded from, if any.
+     * `bytecode` points into this mapping.
      */
-    cio_callable_t* callables;
+    const unsigned char* file;
     /**
-     * The number of callable routines for this module.
+     * The size of `file` in bytes.
      */
-    gen_size_t callables_length;
-} cio_bytecode_t;
+    gen_size_t file_length;
 
-typedef gen_error_t*(*cio_extlib_call_wrapper_t)(cio_vm_t* const restrict vm, const cio_routine_function_t call);
+    gen_bool_t debug_prints;
+
+    const cio_warning_settings_t* warning_settings;
+
+    /**
+     * The execution settings the program was prepared for.
+     */
+    cio_vm_settings_t settings;
+
+    /**
+     * The time taken to load and resolve the program, in nanoseconds.
+     */
+    gen_size_t resolution_time;
+} cio_image_t;
 
 /**
  * The VM state.
+ * Program fields alias those of `image` and must not be modified.
  */
 typedef struct cio_vm_t {
+    /**
+     * The program image this VM executes.
+     */
+    cio_image_t* image;
+
     /**
      * The length of the stack.
      */
@@ -303,6 +1090,11 @@ typedef struct cio_vm_t {
      * The stack - consists of a buffer of `gen_size_t`s.
      */
     gen_size_t* stack;
+    /**
+     * The number of stack cells which have ever been in use.
+     * Cells at or above this index are still zeroed from allocation.
+     */
+    gen_size_t stack_high_water;
 
     /**
      * The number of call frames currently in use.
@@ -330,6 +1122,29 @@ typedef struct cio_vm_t {
      */
     gen_size_t current_bytecode;
 
+    /**
+     * The callables of all bytecode modules, in module order.
+     */
+    cio_callable_t* callables;
+    /**
+     * The number of callables in `callables`.
+     */
+    gen_size_t callables_length;
+    /**
+     * The resolved dispatch targets of each entry in `callables`.
+     * Call sites in decoded bytecode refer to indices into this table.
+     */
+    cio_dispatch_t* dispatch;
+
+    /**
+     * The identifier hash table over `callables`.
+     */
+    cio_symbol_t* symbols;
+    /**
+     * The number of entries in `symbols`. Always a power of two.
+     */
+    gen_size_t symbols_length;
+
     /**
      * The library handle from which to load externally resolved routines.
      */
@@ -340,12 +1155,71 @@ typedef struct cio_vm_t {
     void* external_lib_storage;
     /**
      * VM call wrapper for the extlib. Should restore stack/frame state before returning.
+     * Routines called through their fast calling convention only pass through the wrapper when they fail.
      */
     cio_extlib_call_wrapper_t external_lib_call_wrapper;
+    /**
+     * The error being raised by a routine using the fast calling convention.
+     */
+    gen_error_t* fault;
+
+    /**
+     * The executable mapping holding routines compiled by the JIT, if any.
+     */
+    void* jit_code;
+    /**
+     * The size of `jit_code` in bytes.
+     */
+    gen_size_t jit_code_length;
 
     gen_bool_t debug_prints;
 
     const cio_warning_settings_t* warning_settings;
+
+    /**
+     * The execution settings for this VM.
+     */
+    cio_vm_settings_t settings;
+
+    /**
+     * The profile being recorded if `settings.profile` is set, otherwise `GEN_NULL`.
+     */
+    cio_profile_t* profile;
+    /**
+     * The sampling state if `cio_vm_start_sampling` has been called, otherwise `GEN_NULL`.
+     */
+    cio_sampler_t* sampler;
+
+    /**
+     * The execution statistics of this VM, if counted.
+     * Peak stack height and resolution time are filled in by `cio_vm_get_stats`.
+     */
+    cio_vm_stats_t stats;
+
+    /**
+     * The first of the coroutines waiting to run, in the order they will be resumed.
+     */
+    cio_coroutine_t* coroutines;
+    /**
+     * The last of the coroutines waiting to run.
+     */
+    cio_coroutine_t* coroutines_last;
+    /**
+     * Finished coroutines whose stack segments can be reused.
+     */
+    cio_coroutine_t* coroutines_free;
+    /**
+     * The number of coroutines which are parked.
+     */
+    gen_size_t coroutines_parked;
+    /**
+     * The coroutine currently running, if any.
+     */
+    cio_coroutine_t* coroutine;
+    /**
+     * Whether the running coroutine should be suspended once the current routine returns.
+     */
+    gen_bool_t yield_requested;
 } cio_vm_t;
 
 /**
@@ -448,6 +1322,22 @@ extern gen_error_t* cio_mangle_identifier(const char* const restrict identifier,
  * @return An error, otherwise `GEN_NULL`. 
  */
 extern gen_error_t* cio_resolve_external(const char* const restrict identifier, cio_routine_function_t* const out_function, const gen_dynamic_library_handle_t* const restrict lib);
+/**
+ * Resolves an external routine identifier to native code using the fast calling convention.
+ * @param[in] identifier the identifier to resolve.
+ * @param[out] out_function a pointer to storage for the underlying function.
+ * @param[in] lib the library to resolve the identifier from.
+ * @return An error, otherwise `GEN_NULL`. 
+ */
+extern gen_error_t* cio_resolve_external_fast(const char* const restrict identifier, cio_fast_routine_function_t* const out_function, const gen_dynamic_library_handle_t* const restrict lib);
+/**
+ * Resolves whether an external routine is marked as reading its caller's caller's frame.
+ * @param[in] identifier the identifier to resolve.
+ * @param[out] out_reads_caller a pointer to storage for whether the routine is marked.
+ * @param[in] lib the library to resolve the identifier from.
+ * @return An error, otherwise `GEN_NULL`. 
+ */
+extern gen_error_t* cio_resolve_external_reads_caller(const char* const restrict identifier, gen_bool_t* const restrict out_reads_caller, const gen_dynamic_library_handle_t* const restrict lib);
 
 /**
  * Generates a token buffer from a source buffer.
@@ -459,6 +1349,17 @@ extern gen_error_t* cio_resolve_external(const char* const restrict identifier,
  */
 extern gen_error_t* cio_tokenize(const char* const restrict source, const gen_size_t source_length, cio_token_t** const restrict out_tokens, gen_size_t* const restrict out_tokens_length);
 
+/**
+ * Generates a packed token buffer from a source buffer.
+ * Produces the same tokens as `cio_tokenize`.
+ * @param[in] source the source buffer to tokenize. Must not be longer than `CIO_PACKED_TOKEN_OFFSET_MAX`.
+ * @param[in] source_length the length of the source buffer to tokenize.
+ * @param[out] out_tokens a pointer to storage for a pointer to the token buffer. Must be freed.
+ * @param[out] out_tokens_length a pointer to storage for the length of the token buffer.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_tokenize_packed(const char* const restrict source, const gen_size_t source_length, cio_packed_token_t** const restrict out_tokens, gen_size_t* const restrict out_tokens_length);
+
 /**
  * Parses a token buffer into a program representation.
  * @param[in] tokens the token buffer to parse.
@@ -492,6 +1393,21 @@ extern gen_error_t* cio_program_free(cio_program_t* const restrict program);
  */
 extern gen_error_t* cio_module_emit(const cio_program_t* const restrict program, unsigned char** const restrict out_bytecode, gen_size_t* const restrict out_bytecode_length, const char* const restrict source, const gen_size_t source_length, const char* const restrict source_file, const gen_size_t source_file_length, const cio_warning_settings_t* const restrict warning_settings);
 
+/**
+ * Emits executable bytecode for a source read through a `cio_stream_reader_t`.
+ * The source is read twice - once to lay out the routine table and once to emit code, which is written as each routine's block closes.
+ * Only a window over the source, the routine table and a buffer of code are held in memory at once.
+ * The bytecode and diagnostics produced are the same as from `cio_tokenize`, `cio_parse` and `cio_module_emit`.
+ * @param[in] reader the reader to read the source through. Must support reading from any offset, and reading the same offsets again, so sources such as pipes and standard input which can only be read once are not supported.
+ * @param[in] reader_data user data to pass to `reader`.
+ * @param[in] writer the writer to write the emitted bytecode through. Called with the header followed by each part of the code section in order.
+ * @param[in] writer_data user data to pass to `writer`.
+ * @param[in] source_file file name from which the source is read.
+ * @param[in] source_file_length the length of the file name from which the source is read.
+ * @return An error, otherwise `GEN_NULL`. Bytecode may already have been written when an error occurs.
+ */
+extern gen_error_t* cio_module_emit_stream(const cio_stream_reader_t reader, void* const reader_data, const cio_stream_writer_t writer, void* const writer_data, const char* const restrict source_file, const gen_size_t source_file_length, const cio_warning_settings_t* const restrict warning_settings);
+
 /**
  * Gets a callable from an identifier in a VM.
  * @param vm the VM to get a callable from.
@@ -507,9 +1423,84 @@ extern gen_error_t* cio_vm_get_identifier(cio_vm_t* const restrict vm, const cha
  * @param[in] bytecode_length the length of `bytecode`.
  * @param[in] stack_length the length of the stack to execute with.
  * @param[out] out_instance a pointer to storage for the created VM.
+ * @param[in] settings the execution settings for the VM. May be `GEN_NULL` to use the defaults.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, const gen_size_t stack_length, gen_bool_t resolve_externals, cio_vm_t* const restrict out_instance, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings);
+
+/**
+ * Creates and initializes a VM to execute a bytecode module or bundled executable file.
+ * The file is mapped read-only rather than copied, so VMs in separate processes executing the same file share its pages.
+ * The mapping is held by the VM's image and released by `cio_vm_free`.
+ * @param[in] path the path of the bytecode file to execute.
+ * @param[in] stack_length the length of the stack to execute with.
+ * @param[out] out_instance a pointer to storage for the created VM.
+ * @param[in] settings the execution settings for the VM. May be `GEN_NULL` to use the defaults.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_initialize_from_file(const char* const restrict path, const gen_size_t stack_length, gen_bool_t resolve_externals, cio_vm_t* const restrict out_instance, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings);
+
+/**
+ * Creates and initializes a VM to execute a shared program image.
+ * Takes a reference to the image which is released by `cio_vm_free`.
+ * The VM executes with the settings the image was initialized with.
+ * @param[in] image the image to execute.
+ * @param[in] stack_length the length of the stack to execute with.
+ * @param[out] out_instance a pointer to storage for the created VM.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_initialize_from_image(cio_image_t* const restrict image, const gen_size_t stack_length, cio_vm_t* const restrict out_instance);
+
+/**
+ * Creates a VM as a copy of another, sharing its image.
+ * The stack, frames and extlib state are copied so the clone resumes from the same point, e.g. after a prefix of the entrypoint has been executed.
+ * Only the part of the stack which has ever been used is copied - the remainder is left to be zeroed lazily by the allocator.
+ * Execution statistics are copied, while the clone starts with an empty profile and is not sampled.
+ * @param[in] source the VM to copy. Must not be executing, and must not have any unfinished coroutines.
+ * @param[out] out_instance a pointer to storage for the created VM.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_clone(const cio_vm_t* const restrict source, cio_vm_t* const restrict out_instance);
+
+/**
+ * Loads and resolves a bytecode module or bundled executable into an image which can be shared between VMs.
+ * @param[in] bytecode the bytecode buffer to load. Must outlive the image.
+ * @param[in] bytecode_length the length of `bytecode`.
+ * @param[in] resolve_externals whether to resolve external routines.
+ * @param[in] debug_prints whether VMs executing the image should print debug information.
+ * @param[in] warning_settings the warning settings for VMs executing the image. Must outlive the image.
+ * @param[in] settings the execution settings for VMs executing the image. May be `GEN_NULL` to use the defaults.
+ * @param[out] out_image a pointer to storage for a pointer to the created image, which holds one reference.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_image_initialize(const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, gen_bool_t resolve_externals, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings, cio_image_t** const restrict out_image);
+
+/**
+ * Loads and resolves a bytecode module or bundled executable file into an image which can be shared between VMs.
+ * The file is mapped read-only rather than copied. The mapping is released along with the image.
+ * @param[in] path the path of the bytecode file to load.
+ * @param[in] resolve_externals whether to resolve external routines.
+ * @param[in] debug_prints whether VMs executing the image should print debug information.
+ * @param[in] warning_settings the warning settings for VMs executing the image. Must outlive the image.
+ * @param[in] settings the execution settings for VMs executing the image. May be `GEN_NULL` to use the defaults.
+ * @param[out] out_image a pointer to storage for a pointer to the created image, which holds one reference.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_image_initialize_from_file(const char* const restrict path, gen_bool_t resolve_externals, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings, cio_image_t** const restrict out_image);
+
+/**
+ * Takes a reference to an image.
+ * @param[in,out] image the image to reference.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_image_retain(cio_image_t* const restrict image);
+
+/**
+ * Releases a reference to an image, destroying it once no references remain.
+ * @param[in,out] image the image to release.
  * @return An error, otherwise `GEN_NULL`.
  */
-extern gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, const gen_size_t stack_length, gen_bool_t resolve_externals, cio_vm_t* const restrict out_instance, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings);
+extern gen_error_t* cio_image_release(cio_image_t* const restrict image);
 
 /**
  * Destroys a VM.
@@ -518,6 +1509,73 @@ extern gen_error_t* cio_vm_initialize(const unsigned char* const restrict byteco
  */
 extern gen_error_t* cio_vm_free(cio_vm_t* const restrict instance);
 
+/**
+ * Translates the routines of an initialized VM into a C translation unit which executes the program.
+ * The generated code operates on the VM's stack and frames as the interpreter would, and calls external routines directly by symbol.
+ * It must be linked against libcionom and the external library.
+ * Routines which cannot be translated are interpreted.
+ * @param[in] vm the VM to translate. Must have been initialized from `bytecode` with externals resolved.
+ * @param[in] bytecode the bytecode buffer the VM was initialized from, which is embedded in the output.
+ * @param[in] bytecode_length the length of `bytecode`.
+ * @param[in] stack_length the length of the stack for the generated program to execute with.
+ * @param[in] entry_routine the identifier of the routine for the generated program to begin executing at.
+ * @param[out] out_source a pointer to storage for a pointer to the generated source buffer. Must be freed.
+ * @param[out] out_source_length a pointer to storage for the length of the generated source buffer.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_emit_c(const cio_vm_t* const restrict vm, const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, const gen_size_t stack_length, const char* const restrict entry_routine, char** const restrict out_source, gen_size_t* const restrict out_source_length);
+
+/**
+ * Formats the profile recorded by a VM.
+ * @param[in] vm the VM to format the profile of. Must have been initialized with `profile` set.
+ * @param[out] out_summary a pointer to storage for a pointer to a table of the totals for each callable called, as lines of text. Must be freed.
+ * @param[out] out_summary_length a pointer to storage for the length of the table.
+ * @param[out] out_folded a pointer to storage for a pointer to the time spent in each call stack, as folded stacks for flame graph tools. Must be freed.
+ * @param[out] out_folded_length a pointer to storage for the length of the folded stacks.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_emit_profile(const cio_vm_t* const restrict vm, char** const restrict out_summary, gen_size_t* const restrict out_summary_length, char** const restrict out_folded, gen_size_t* const restrict out_folded_length);
+
+/**
+ * Gets the execution statistics of a VM.
+ * @param[in] vm the VM to get the statistics of.
+ * @param[out] out_stats pointer to storage for the statistics.
+ * @return An error, otherwise `GEN_NULL`.
+ * @note Fails if the statistics were compiled out with `CIO_VM_STATS`.
+ */
+extern gen_error_t* cio_vm_get_stats(const cio_vm_t* const restrict vm, cio_vm_stats_t* const restrict out_stats);
+
+/**
+ * Starts sampling the call stack of a VM at an interval of CPU time.
+ * Samples are taken from a signal handler on the calling thread without instrumenting calls, so have negligible overhead.
+ * Only one VM in a process may be sampled at a time, and it must be executed on the thread which started sampling.
+ * @param[in,out] vm the VM to sample.
+ * @param[in] frequency the number of samples to take per second of CPU time.
+ * @param[in] capacity the number of samples to keep until they are emitted. Further samples are dropped.
+ * @return An error, otherwise `GEN_NULL`.
+ * @note Only supported on Linux.
+ */
+extern gen_error_t* cio_vm_start_sampling(cio_vm_t* const restrict vm, const gen_size_t frequency, const gen_size_t capacity);
+
+/**
+ * Stops sampling the call stack of a VM.
+ * Samples already taken are kept until emitted.
+ * @param[in,out] vm the VM to stop sampling.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_stop_sampling(cio_vm_t* const restrict vm);
+
+/**
+ * Symbolises and removes the samples taken of a VM.
+ * May be called while sampling to drain samples periodically.
+ * @param[in,out] vm the VM to emit the samples of.
+ * @param[out] out_folded a pointer to storage for a pointer to the number of samples of each call stack, as folded stacks for flame graph tools. Must be freed.
+ * @param[out] out_folded_length a pointer to storage for the length of the folded stacks.
+ * @param[out] out_dropped a pointer to storage for the number of samples dropped since sampling started.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_emit_samples(cio_vm_t* const restrict vm, char** const restrict out_folded, gen_size_t* const restrict out_folded_length, gen_size_t* const restrict out_dropped);
+
 /**
  * Dispatches a call to a callable in a VM.
  * @param[in,out] vm the VM to call in.
@@ -536,6 +1594,68 @@ extern gen_error_t* cio_vm_dispatch_callable(cio_vm_t* const restrict vm, const
  */
 extern gen_error_t* cio_vm_dispatch_call(cio_vm_t* const restrict vm, const gen_size_t callable, const gen_size_t argc);
 
+/**
+ * Starts a routine index as a coroutine in a VM.
+ * The coroutine is queued to run on its own stack segment the next time coroutines are scheduled.
+ * Requires the `trampoline` setting, as coroutines are suspended by leaving the interpreter loop.
+ * @param[in,out] vm the VM to start the coroutine in.
+ * @param[in] callable the index of the routine to start, relative to the current module.
+ * @param[in] parameters the parameters to the routine, which are copied.
+ * @param[in] parameters_length the number of parameters to the routine.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_start_coroutine(cio_vm_t* const restrict vm, const gen_size_t callable, const gen_size_t* const restrict parameters, const gen_size_t parameters_length);
+
+/**
+ * Yields execution to other coroutines in a VM.
+ * Within a coroutine this suspends it once the calling routine returns, after which it is resumed from the next instruction.
+ * Otherwise this runs each waiting coroutine until it yields or finishes.
+ * @param[in,out] vm the VM to yield in.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_yield(cio_vm_t* const restrict vm);
+
+/**
+ * Parks the coroutine running in a VM, suspending it once the calling routine returns until it is woken.
+ * Used by external routines which wait on events, e.g. I/O.
+ * @param[in,out] vm the VM running the coroutine.
+ * @param[out] out_coroutine a pointer to storage for a pointer to the parked coroutine, to pass to `cio_vm_wake_coroutine`.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_park_coroutine(cio_vm_t* const restrict vm, cio_coroutine_t** const restrict out_coroutine);
+
+/**
+ * Wakes a parked coroutine, queueing it to run.
+ * @param[in,out] vm the VM containing the coroutine.
+ * @param[in,out] coroutine the coroutine to wake.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_wake_coroutine(cio_vm_t* const restrict vm, cio_coroutine_t* const restrict coroutine);
+
+/**
+ * Runs the coroutines in a VM in turn until all have finished.
+ * While every remaining coroutine is parked the extlib's idle hook is run to wait for one to be woken.
+ * @param[in,out] vm the VM to run coroutines in. Must not be running a coroutine.
+ * @return An error, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_run_coroutines(cio_vm_t* const restrict vm);
+
+/**
+ * Gets the error to raise for the status of a routine using the fast calling convention.
+ * @param[in,out] vm the VM the routine was called in.
+ * @param[in] status the status returned by the routine.
+ * @return The error described by `status`, otherwise `GEN_NULL`.
+ */
+extern gen_error_t* cio_vm_status_error(cio_vm_t* const restrict vm, const cio_status_t status);
+/**
+ * Raises the error for the status of a routine using the fast calling convention.
+ * The error is passed through `external_lib_call_wrapper` as if the routine had been called through it.
+ * @param[in,out] vm the VM the routine was called in.
+ * @param[in] status the status returned by the routine.
+ * @return The error returned by the wrapper, otherwise the error described by `status`.
+ */
+extern gen_error_t* cio_vm_raise_status(cio_vm_t* const restrict vm, const cio_status_t status);
+
 /**
  * Pushes a new stack frame in a VM.
  * @param[in,out] vm the VM to push a new stack frame in.
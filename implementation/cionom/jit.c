@@ -0,0 +1,549 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/cionom.h"
+
+#include <genmemory.h>
+#include <genlog.h>
+#include <genstring.h>
+#include <genfilesystem.h>
+
+extern gen_error_t* cio_vm_internal_jit_compile(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_jit_free(cio_image_t* const restrict image);
+
+#if defined(__x86_64__) && defined(__linux__)
+
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <stddef.h>
+#include <sys/mman.h>
+#include <unistd.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+extern gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_translatable(const cio_vm_t* const restrict vm, const cio_bytecode_t* const restrict module, const gen_size_t offset, gen_bool_t* const restrict out_translatable);
+extern gen_error_t* cio_vm_internal_jit_call(cio_vm_t* const restrict vm, const gen_size_t height, const gen_size_t slot, const gen_size_t argc, const gen_size_t offset);
+
+// Routines are compiled into one buffer which is copied into an executable mapping once complete
+// Calls between compiled routines are patched in afterwards as their entry points are not yet known
+typedef struct {
+    unsigned char* code;
+    gen_size_t length;
+    gen_size_t capacity;
+
+    // Indexed by callable slot - `GEN_SIZE_MAX` where the slot's routine was not compiled
+    gen_size_t* starts;
+    gen_size_t* entries;
+    gen_size_t* ends;
+
+    gen_size_t* patches;
+    gen_size_t* patch_slots;
+    gen_size_t patches_length;
+} cio_vm_internal_jit_buffer_t;
+
+// Generated code keeps the VM in `rbx`, the frame's stack cells in `r12`, the frame's height in `r13`, the frame in `r14` and the frame's base in `r15`
+// All are callee-saved so remain valid across calls out of generated code
+
+#define CIO_VM_INTERNAL_JIT_IMM32(value) (unsigned char) ((gen_uint32_t) (value)), (unsigned char) ((gen_uint32_t) (value) >> 8), (unsigned char) ((gen_uint32_t) (value) >> 16), (unsigned char) ((gen_uint32_t) (value) >> 24)
+#define CIO_VM_INTERNAL_JIT_IMM64(value) CIO_VM_INTERNAL_JIT_IMM32((gen_uint64_t) (value)), CIO_VM_INTERNAL_JIT_IMM32((gen_uint64_t) (value) >> 32)
+
+#define CIO_VM_INTERNAL_JIT_VM(field) CIO_VM_INTERNAL_JIT_IMM32(offsetof(cio_vm_t, field))
+#define CIO_VM_INTERNAL_JIT_FRAME(field) CIO_VM_INTERNAL_JIT_IMM32(offsetof(cio_frame_t, field))
+
+static gen_error_t* cio_vm_internal_jit_emit(cio_vm_internal_jit_buffer_t* const restrict buffer, const unsigned char* const restrict bytes, const gen_size_t length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_emit, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(buffer->length + length > buffer->capacity) {
+        const gen_size_t capacity = (buffer->capacity ? buffer->capacity : 4096) * 2 + length;
+        error = gen_memory_reallocate_zeroed((void**) &buffer->code, buffer->capacity, capacity, sizeof(unsigned char));
+        if(error) return error;
+        buffer->capacity = capacity;
+    }
+
+    error = gen_memory_copy(&buffer->code[buffer->length], buffer->capacity - buffer->length, bytes, length, length);
+    if(error) return error;
+    buffer->length += length;
+
+    return GEN_NULL;
+}
+
+#define CIO_VM_INTERNAL_JIT_EMIT(...) \
+    do { \
+        const unsigned char bytes[] = {__VA_ARGS__}; \
+        error = cio_vm_internal_jit_emit(buffer, bytes, sizeof(bytes)); \
+        if(error) return error; \
+    } while(0)
+
+// Emits an instruction ending in a 32-bit displacement to `target` within the buffer
+#define CIO_VM_INTERNAL_JIT_EMIT_BRANCH(target, ...) \
+    do { \
+        const unsigned char opcode[] = {__VA_ARGS__}; \
+        error = cio_vm_internal_jit_emit(buffer, opcode, sizeof(opcode)); \
+        if(error) return error; \
+        CIO_VM_INTERNAL_JIT_EMIT(CIO_VM_INTERNAL_JIT_IMM32((target) - (buffer->length + 4))); \
+    } while(0)
+
+// Raises the high-water mark to the top of the frame
+// lea rax, [r15 + r13]; cmp rax, [rbx + stack_high_water]; jbe +7; mov [rbx + stack_high_water], rax
+#define CIO_VM_INTERNAL_JIT_EMIT_MARK_HIGH_WATER() \
+    CIO_VM_INTERNAL_JIT_EMIT(0x4B, 0x8D, 0x04, 0x2F, 0x48, 0x3B, 0x83, CIO_VM_INTERNAL_JIT_VM(stack_high_water), 0x76, 0x07, 0x48, 0x89, 0x83, CIO_VM_INTERNAL_JIT_VM(stack_high_water))
+
+static gen_error_t* cio_vm_internal_jit_stack_overflow(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_stack_overflow, GEN_FILE_NAME);
+	if(error) return error;
+
+    (void) vm;
+
+    return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "Stack overflow");
+}
+
+static gen_error_t* cio_vm_internal_jit_frames_exhausted(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_frames_exhausted, GEN_FILE_NAME);
+	if(error) return error;
+
+    (void) vm;
+
+    return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "No unused frames available to push");
+}
+
+static gen_error_t* cio_vm_internal_jit_translate(const cio_vm_t* const restrict vm, cio_vm_internal_jit_buffer_t* const restrict buffer, const gen_size_t slot) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_translate, GEN_FILE_NAME);
+	if(error) return error;
+
+    const cio_dispatch_t* const routine = &vm->dispatch[slot];
+    const cio_bytecode_t* const module = &vm->bytecode[routine->bytecode_index];
+
+    // Align routines for the benefit of the branch predictor - padding is never executed
+    while(buffer->length % 16) CIO_VM_INTERNAL_JIT_EMIT(0xCC);
+    buffer->starts[slot] = buffer->length;
+
+    // Shared exits are emitted ahead of the entry point so that branches to them are always backwards
+    // pop r15; pop r14; pop r13; pop r12; pop rbx; ret
+    const gen_size_t epilogue = buffer->length;
+    CIO_VM_INTERNAL_JIT_EMIT(0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3);
+
+    // mov rdi, rbx; mov rax, cio_vm_internal_jit_stack_overflow; call rax; jmp epilogue
+    const gen_size_t stack_overflow = buffer->length;
+    CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x89, 0xDF, 0x48, 0xB8, CIO_VM_INTERNAL_JIT_IMM64((void*) cio_vm_internal_jit_stack_overflow), 0xFF, 0xD0);
+    CIO_VM_INTERNAL_JIT_EMIT_BRANCH(epilogue, 0xE9);
+
+    // mov rdi, rbx; mov rax, cio_vm_internal_jit_frames_exhausted; call rax; jmp epilogue
+    const gen_size_t frames_exhausted = buffer->length;
+    CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x89, 0xDF, 0x48, 0xB8, CIO_VM_INTERNAL_JIT_IMM64((void*) cio_vm_internal_jit_frames_exhausted), 0xFF, 0xD0);
+    CIO_VM_INTERNAL_JIT_EMIT_BRANCH(epilogue, 0xE9);
+
+    buffer->entries[slot] = buffer->length;
+
+    // push rbx; push r12; push r13; push r14; push r15; mov rbx, rdi
+    CIO_VM_INTERNAL_JIT_EMIT(0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57, 0x48, 0x89, 0xFB);
+    // mov rax, [rbx + frames_used]; imul rax, rax, sizeof(cio_frame_t); add rax, [rbx + frames]; sub rax, sizeof(cio_frame_t); mov r14, rax
+    CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x8B, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_used), 0x48, 0x69, 0xC0, CIO_VM_INTERNAL_JIT_IMM32(sizeof(cio_frame_t)), 0x48, 0x03, 0x83, CIO_VM_INTERNAL_JIT_VM(frames), 0x48, 0x2D, CIO_VM_INTERNAL_JIT_IMM32(sizeof(cio_frame_t)), 0x49, 0x89, 0xC6);
+    // mov r15, [r14 + base]; mov r12, r15; shl r12, 3; add r12, [rbx + stack]; mov r13, [r14 + height]
+    CIO_VM_INTERNAL_JIT_EMIT(0x4D, 0x8B, 0xBE, CIO_VM_INTERNAL_JIT_FRAME(base), 0x4D, 0x89, 0xFC, 0x49, 0xC1, 0xE4, 0x03, 0x4C, 0x03, 0xA3, CIO_VM_INTERNAL_JIT_VM(stack), 0x4D, 0x8B, 0xAE, CIO_VM_INTERNAL_JIT_FRAME(height));
+
+    gen_size_t argc = 0;
+    for(gen_size_t i = routine->offset;; ++i) {
+        const gen_uint8_t operand = module->bytecode[i] & CIO_OPERAND_MAX;
+
+        if(!(module->bytecode[i] >> 7)) {
+            // Runs of pushes are bounds checked once then stored directly
+            gen_size_t run = 0;
+            while(!(module->bytecode[i + run] >> 7)) ++run;
+
+            // lea rax, [r15 + r13 + run]; cmp rax, [rbx + stack_length]; ja stack_overflow
+            CIO_VM_INTERNAL_JIT_EMIT(0x4B, 0x8D, 0x84, 0x2F, CIO_VM_INTERNAL_JIT_IMM32(run), 0x48, 0x3B, 0x83, CIO_VM_INTERNAL_JIT_VM(stack_length));
+            CIO_VM_INTERNAL_JIT_EMIT_BRANCH(stack_overflow, 0x0F, 0x87);
+
+            // mov qword [r12 + r13 * 8 + j * 8], operand
+            for(gen_size_t j = 0; j < run; ++j) CIO_VM_INTERNAL_JIT_EMIT(0x4B, 0xC7, 0x84, 0xEC, CIO_VM_INTERNAL_JIT_IMM32(j * sizeof(gen_size_t)), CIO_VM_INTERNAL_JIT_IMM32(module->bytecode[i + j] & CIO_OPERAND_MAX));
+
+            // add r13, run
+            CIO_VM_INTERNAL_JIT_EMIT(0x49, 0x81, 0xC5, CIO_VM_INTERNAL_JIT_IMM32(run));
+
+            argc += run;
+            i += run - 1;
+            continue;
+        }
+
+        if(operand == CIO_OPERAND_MAX) {
+            // mov [r14 + height], r13; mov qword [r14 + execution_offset], i; xor eax, eax; jmp epilogue
+            CIO_VM_INTERNAL_JIT_EMIT_MARK_HIGH_WATER();
+            CIO_VM_INTERNAL_JIT_EMIT(0x4D, 0x89, 0xAE, CIO_VM_INTERNAL_JIT_FRAME(height), 0x49, 0xC7, 0x86, CIO_VM_INTERNAL_JIT_FRAME(execution_offset), CIO_VM_INTERNAL_JIT_IMM32(i), 0x31, 0xC0);
+            CIO_VM_INTERNAL_JIT_EMIT_BRANCH(epilogue, 0xE9);
+            break;
+        }
+
+        // Subtract 1 for reserve space
+        const gen_size_t callee_argc = argc - 1;
+        const gen_size_t target_slot = module->decoded[i].operand;
+        const cio_dispatch_t* const target = &vm->dispatch[target_slot];
+        const gen_uint8_t* const current = &module->bytecode[i - callee_argc];
+        argc = 0;
+
+        const cio_decoded_opcode_t opcode = module->decoded[i].opcode;
+        const gen_size_t arity = opcode == CIO_DECODED_INTRINSIC_STORE_CHAR ? 3 : 2;
+        const gen_bool_t intrinsic = opcode == CIO_DECODED_INTRINSIC_ADD || opcode == CIO_DECODED_INTRINSIC_SUBTRACT || opcode == CIO_DECODED_INTRINSIC_COPY || opcode == CIO_DECODED_INTRINSIC_COPY_VARIABLE || opcode == CIO_DECODED_INTRINSIC_STORE_CHAR;
+
+        const gen_size_t target_routine = vm->bytecode[vm->callables[target_slot].bytecode_index].callables_offset + vm->callables[target_slot].routine_index;
+        const gen_bool_t compiled = target->function == cio_vm_internal_execute_routine && buffer->entries[target_routine] != GEN_SIZE_MAX;
+
+        if(intrinsic && !vm->settings.scrub_stack && callee_argc == arity) {
+            // Intrinsics operate on the stack as in the interpreter, using the pushed operands as immediates
+            // mov rax, [rbx + frames_used]; cmp rax, [rbx + frames_length]; jae frames_exhausted
+            CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x8B, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_used), 0x48, 0x3B, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_length));
+            CIO_VM_INTERNAL_JIT_EMIT_BRANCH(frames_exhausted, 0x0F, 0x83);
+            CIO_VM_INTERNAL_JIT_EMIT_MARK_HIGH_WATER();
+
+            // sub r13, callee_argc
+            CIO_VM_INTERNAL_JIT_EMIT(0x49, 0x81, 0xED, CIO_VM_INTERNAL_JIT_IMM32(callee_argc));
+
+            const gen_size_t first = (current[0] & CIO_OPERAND_MAX) * sizeof(gen_size_t);
+            const gen_size_t second = (current[1] & CIO_OPERAND_MAX) * sizeof(gen_size_t);
+            switch(opcode) {
+                case CIO_DECODED_INTRINSIC_ADD:
+                case CIO_DECODED_INTRINSIC_SUBTRACT: {
+                    // mov rax, [r12 + first]; add/sub rax, [r12 + second]; mov [r12 + r13 * 8 - 8], rax
+                    CIO_VM_INTERNAL_JIT_EMIT(0x49, 0x8B, 0x84, 0x24, CIO_VM_INTERNAL_JIT_IMM32(first), 0x49, opcode == CIO_DECODED_INTRINSIC_ADD ? 0x03 : 0x2B, 0x84, 0x24, CIO_VM_INTERNAL_JIT_IMM32(second), 0x4B, 0x89, 0x84, 0xEC, CIO_VM_INTERNAL_JIT_IMM32(-(gen_int64_t) sizeof(gen_size_t)));
+                    break;
+                }
+                case CIO_DECODED_INTRINSIC_COPY: {
+                    // mov qword [r12 + first], current[1]
+                    CIO_VM_INTERNAL_JIT_EMIT(0x49, 0xC7, 0x84, 0x24, CIO_VM_INTERNAL_JIT_IMM32(first), CIO_VM_INTERNAL_JIT_IMM32(current[1] & CIO_OPERAND_MAX));
+                    break;
+                }
+                case CIO_DECODED_INTRINSIC_COPY_VARIABLE: {
+                    // mov rax, [r12 + second]; mov [r12 + first], rax
+                    CIO_VM_INTERNAL_JIT_EMIT(0x49, 0x8B, 0x84, 0x24, CIO_VM_INTERNAL_JIT_IMM32(second), 0x49, 0x89, 0x84, 0x24, CIO_VM_INTERNAL_JIT_IMM32(first));
+                    break;
+                }
+                default: {
+                    // mov rax, [r12 + first]; mov byte [rax + current[1]], current[2]
+                    CIO_VM_INTERNAL_JIT_EMIT(0x49, 0x8B, 0x84, 0x24, CIO_VM_INTERNAL_JIT_IMM32(first), 0xC6, 0x80, CIO_VM_INTERNAL_JIT_IMM32(current[1] & CIO_OPERAND_MAX), current[2] & CIO_OPERAND_MAX);
+                    break;
+                }
+            }
+
+            continue;
+        }
+
+        if(vm->settings.scrub_stack || (!compiled && !target->fast)) {
+            // Everything else goes through the interpreter's dispatch
+            // mov rdi, rbx; mov rsi, r13; mov edx, target_slot; mov ecx, callee_argc; mov r8d, i; mov rax, cio_vm_internal_jit_call; call rax
+            CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x89, 0xDF, 0x4C, 0x89, 0xEE, 0xBA, CIO_VM_INTERNAL_JIT_IMM32(target_slot), 0xB9, CIO_VM_INTERNAL_JIT_IMM32(callee_argc), 0x41, 0xB8, CIO_VM_INTERNAL_JIT_IMM32(i), 0x48, 0xB8, CIO_VM_INTERNAL_JIT_IMM64((void*) cio_vm_internal_jit_call), 0xFF, 0xD0);
+            // test rax, rax; jnz epilogue; mov r13, [r14 + height]
+            CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x85, 0xC0);
+            CIO_VM_INTERNAL_JIT_EMIT_BRANCH(epilogue, 0x0F, 0x85);
+            CIO_VM_INTERNAL_JIT_EMIT(0x4D, 0x8B, 0xAE, CIO_VM_INTERNAL_JIT_FRAME(height));
+            continue;
+        }
+
+        // Compiled routines and routines with the fast calling convention are called directly with their frame pushed inline
+        // The high-water mark is raised first as it clobbers `rax`
+        // mov rax, [rbx + frames_used]; cmp rax, [rbx + frames_length]; jae frames_exhausted
+        CIO_VM_INTERNAL_JIT_EMIT_MARK_HIGH_WATER();
+        CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x8B, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_used), 0x48, 0x3B, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_length));
+        CIO_VM_INTERNAL_JIT_EMIT_BRANCH(frames_exhausted, 0x0F, 0x83);
+
+        // Callee takes ownership of lower stack items
+        // sub r13, callee_argc; mov [r14 + height], r13; mov qword [r14 + execution_offset], i
+        CIO_VM_INTERNAL_JIT_EMIT(0x49, 0x81, 0xED, CIO_VM_INTERNAL_JIT_IMM32(callee_argc), 0x4D, 0x89, 0xAE, CIO_VM_INTERNAL_JIT_FRAME(height), 0x49, 0xC7, 0x86, CIO_VM_INTERNAL_JIT_FRAME(execution_offset), CIO_VM_INTERNAL_JIT_IMM32(i));
+
+        // The callee's frame is written before it is counted, as the sampler may read the frames at any point
+        // imul rax, rax, sizeof(cio_frame_t); add rax, [rbx + frames]
+        CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x69, 0xC0, CIO_VM_INTERNAL_JIT_IMM32(sizeof(cio_frame_t)), 0x48, 0x03, 0x83, CIO_VM_INTERNAL_JIT_VM(frames));
+        // lea rcx, [r15 + r13]; mov [rax + base], rcx; mov ecx, callee_argc; mov [rax + height], rcx; mov ecx, offset; mov [rax + execution_offset], rcx
+        CIO_VM_INTERNAL_JIT_EMIT(0x4B, 0x8D, 0x0C, 0x2F, 0x48, 0x89, 0x88, CIO_VM_INTERNAL_JIT_FRAME(base), 0xB9, CIO_VM_INTERNAL_JIT_IMM32(callee_argc), 0x48, 0x89, 0x88, CIO_VM_INTERNAL_JIT_FRAME(height), 0xB9, CIO_VM_INTERNAL_JIT_IMM32(target->offset), 0x48, 0x89, 0x88, CIO_VM_INTERNAL_JIT_FRAME(execution_offset));
+        // mov ecx, bytecode_index; mov [rax + bytecode_index], rcx; mov [rbx + current_bytecode], rcx; inc qword [rbx + frames_used]
+        CIO_VM_INTERNAL_JIT_EMIT(0xB9, CIO_VM_INTERNAL_JIT_IMM32(target->bytecode_index), 0x48, 0x89, 0x88, CIO_VM_INTERNAL_JIT_FRAME(bytecode_index), 0x48, 0x89, 0x8B, CIO_VM_INTERNAL_JIT_VM(current_bytecode), 0x48, 0xFF, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_used));
+
+        if(compiled) {
+            // mov rdi, rbx; call target; test rax, rax; jnz epilogue
+            CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x89, 0xDF, 0xE8);
+
+            error = gen_memory_reallocate_zeroed((void**) &buffer->patches, buffer->patches_length, buffer->patches_length + 1, sizeof(gen_size_t));
+            if(error) return error;
+            error = gen_memory_reallocate_zeroed((void**) &buffer->patch_slots, buffer->patches_length, buffer->patches_length + 1, sizeof(gen_size_t));
+            if(error) return error;
+            buffer->patches[buffer->patches_length] = buffer->length;
+            buffer->patch_slots[buffer->patches_length] = target_routine;
+            ++buffer->patches_length;
+
+            CIO_VM_INTERNAL_JIT_EMIT(CIO_VM_INTERNAL_JIT_IMM32(0), 0x48, 0x85, 0xC0);
+            CIO_VM_INTERNAL_JIT_EMIT_BRANCH(epilogue, 0x0F, 0x85);
+        }
+        else {
+            // mov rdi, rbx; lea rsi, [r12 + r13 * 8]; mov rdx, r12; mov rcx, r14; mov rax, fast; call rax; test rax, rax; jz +27
+            CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x89, 0xDF, 0x4B, 0x8D, 0x34, 0xEC, 0x4C, 0x89, 0xE2, 0x4C, 0x89, 0xF1, 0x48, 0xB8, CIO_VM_INTERNAL_JIT_IMM64((void*) target->fast), 0xFF, 0xD0, 0x48, 0x85, 0xC0, 0x74, 0x1B);
+
+            // A fault handled by the wrapper resumes the caller as if the routine had returned, so the status is raised in place
+            // mov rsi, rax; mov rdi, rbx; mov rax, cio_vm_raise_status; call rax; test rax, rax; jnz epilogue
+            CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x89, 0xC6, 0x48, 0x89, 0xDF, 0x48, 0xB8, CIO_VM_INTERNAL_JIT_IMM64((void*) cio_vm_raise_status), 0xFF, 0xD0, 0x48, 0x85, 0xC0);
+            CIO_VM_INTERNAL_JIT_EMIT_BRANCH(epilogue, 0x0F, 0x85);
+        }
+
+        // The routine may have replaced its own frame (e.g. `callv`), so the top frame is popped
+        // mov rax, [rbx + frames_used]; sub rax, 1; mov [rbx + frames_used], rax; imul rax, rax, sizeof(cio_frame_t); add rax, [rbx + frames]; xor ecx, ecx
+        CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x8B, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_used), 0x48, 0x83, 0xE8, 0x01, 0x48, 0x89, 0x83, CIO_VM_INTERNAL_JIT_VM(frames_used), 0x48, 0x69, 0xC0, CIO_VM_INTERNAL_JIT_IMM32(sizeof(cio_frame_t)), 0x48, 0x03, 0x83, CIO_VM_INTERNAL_JIT_VM(frames), 0x31, 0xC9);
+        // mov [rax + n], rcx
+        for(gen_size_t j = 0; j < sizeof(cio_frame_t); j += sizeof(gen_size_t)) CIO_VM_INTERNAL_JIT_EMIT(0x48, 0x89, 0x88, CIO_VM_INTERNAL_JIT_IMM32(j));
+        // mov ecx, bytecode_index; mov [rbx + current_bytecode], rcx; mov r13, [r14 + height]
+        CIO_VM_INTERNAL_JIT_EMIT(0xB9, CIO_VM_INTERNAL_JIT_IMM32(routine->bytecode_index), 0x48, 0x89, 0x8B, CIO_VM_INTERNAL_JIT_VM(current_bytecode), 0x4D, 0x8B, 0xAE, CIO_VM_INTERNAL_JIT_FRAME(height));
+    }
+
+    buffer->ends[slot] = buffer->length;
+
+    return GEN_NULL;
+}
+
+#undef CIO_VM_INTERNAL_JIT_EMIT_MARK_HIGH_WATER
+#undef CIO_VM_INTERNAL_JIT_EMIT_BRANCH
+#undef CIO_VM_INTERNAL_JIT_EMIT
+#undef CIO_VM_INTERNAL_JIT_FRAME
+#undef CIO_VM_INTERNAL_JIT_VM
+
+static gen_error_t* cio_vm_internal_jit_buffer_free(cio_vm_internal_jit_buffer_t* const restrict buffer) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_buffer_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(buffer->code) {
+        error = gen_memory_free((void**) &buffer->code);
+        if(error) return error;
+    }
+    if(buffer->starts) {
+        error = gen_memory_free((void**) &buffer->starts);
+        if(error) return error;
+    }
+    if(buffer->entries) {
+        error = gen_memory_free((void**) &buffer->entries);
+        if(error) return error;
+    }
+    if(buffer->ends) {
+        error = gen_memory_free((void**) &buffer->ends);
+        if(error) return error;
+    }
+    if(buffer->patches) {
+        error = gen_memory_free((void**) &buffer->patches);
+        if(error) return error;
+    }
+    if(buffer->patch_slots) {
+        error = gen_memory_free((void**) &buffer->patch_slots);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static void cio_vm_internal_jit_cleanup_buffer(cio_vm_internal_jit_buffer_t* buffer) {
+    gen_error_t* error = cio_vm_internal_jit_buffer_free(buffer);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+static void cio_vm_internal_jit_cleanup_map(char** map) {
+    if(!*map) return;
+
+    gen_error_t* error = gen_memory_free((void**) map);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+#define CIO_VM_INTERNAL_JIT_APPEND(out, out_length, format, ...) \
+    do { \
+        gen_size_t formatted_length = 0; \
+        error = gen_string_format(GEN_STRING_NO_BOUNDS, GEN_NULL, &formatted_length, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        error = gen_memory_reallocate_zeroed((void**) out, *out ? *out_length + 1 : 0, *out_length + formatted_length + 1, sizeof(char)); \
+        if(error) return error; \
+        error = gen_string_format(formatted_length + 1, &(*out)[*out_length], GEN_NULL, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        *out_length += formatted_length; \
+    } while(0)
+
+// The map is appended to as other VMs in the process may have written their own routines to it
+static gen_error_t* cio_vm_internal_jit_write_perf_map(const cio_vm_t* const restrict vm, const cio_vm_internal_jit_buffer_t* const restrict buffer) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_write_perf_map, GEN_FILE_NAME);
+	if(error) return error;
+
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_jit_cleanup_map) char* map = GEN_NULL;
+    gen_size_t map_length = 0;
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        if(buffer->entries[i] == GEN_SIZE_MAX) continue;
+
+        CIO_VM_INTERNAL_JIT_APPEND(&map, &map_length, "%p %p cionom:%t\n", (void*) ((unsigned char*) vm->jit_code + buffer->starts[i]), (void*) (buffer->ends[i] - buffer->starts[i]), vm->callables[i].identifier);
+    }
+
+    if(!map) return GEN_NULL;
+
+    char path[64] = {0};
+    error = gen_string_format(sizeof(path), path, GEN_NULL, "/tmp/perf-%uz.map", sizeof("/tmp/perf-%uz.map") - 1, (gen_size_t) getpid());
+    if(error) return error;
+
+    gen_bool_t exists = gen_false;
+    error = gen_filesystem_path_exists(path, GEN_STRING_NO_BOUNDS, &exists);
+    if(error) return error;
+
+    if(!exists) {
+        error = gen_filesystem_path_create_file(path, GEN_STRING_NO_BOUNDS);
+        if(error) return error;
+    }
+
+    gen_filesystem_handle_t handle = {0};
+    error = gen_filesystem_handle_open(path, GEN_STRING_NO_BOUNDS, &handle);
+    if(error) return error;
+
+    error = gen_filesystem_handle_lock(&handle);
+    if(error) {
+        (void) gen_filesystem_handle_close(&handle);
+        return error;
+    }
+
+    gen_size_t offset = 0;
+    error = gen_filesystem_handle_file_size(&handle, &offset);
+    if(!error) error = gen_filesystem_handle_file_write(&handle, (const unsigned char*) map, offset, map_length);
+
+    // The handle is released whether or not the write succeeded
+    gen_error_t* const unlock_error = gen_filesystem_handle_unlock(&handle);
+    gen_error_t* const close_error = gen_filesystem_handle_close(&handle);
+    if(error) return error;
+    if(unlock_error) return unlock_error;
+    if(close_error) return close_error;
+
+    return GEN_NULL;
+}
+
+#undef CIO_VM_INTERNAL_JIT_APPEND
+
+gen_error_t* cio_vm_internal_jit_compile(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_compile, GEN_FILE_NAME);
+	if(error) return error;
+
+    // The interpreter is needed to trampoline, to produce debug output and to profile calls
+    const char* const interpreted_by = vm->settings.trampoline ? "trampoline" : vm->settings.tail_calls ? "tail_calls" : vm->settings.profile ? "profile" : vm->debug_prints ? "debug_prints" : GEN_NULL;
+    if(interpreted_by) {
+        error = gen_log_formatted(GEN_LOG_LEVEL_WARNING, "cionom", "`jit` has no effect with `%t` enabled, all routines will be interpreted", interpreted_by);
+        if(error) return error;
+
+        return GEN_NULL;
+    }
+
+    if(!vm->callables_length) return GEN_NULL;
+
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_jit_cleanup_buffer) cio_vm_internal_jit_buffer_t buffer = {0};
+    error = gen_memory_allocate_zeroed((void**) &buffer.starts, vm->callables_length, sizeof(gen_size_t));
+    if(error) return error;
+    error = gen_memory_allocate_zeroed((void**) &buffer.entries, vm->callables_length, sizeof(gen_size_t));
+    if(error) return error;
+    error = gen_memory_allocate_zeroed((void**) &buffer.ends, vm->callables_length, sizeof(gen_size_t));
+    if(error) return error;
+
+    // Each routine is compiled once, under the slot of its definition
+    // Entries are marked before any are compiled so calls between routines can be made directly regardless of order
+    gen_bool_t any = gen_false;
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        buffer.entries[i] = GEN_SIZE_MAX;
+
+        const cio_callable_t* const callable = &vm->callables[i];
+        const cio_bytecode_t* const module = &vm->bytecode[callable->bytecode_index];
+        if(vm->dispatch[i].function != cio_vm_internal_execute_routine || module->callables_offset + callable->routine_index != i || callable->offset >= module->size) continue;
+
+        gen_bool_t translatable = gen_false;
+        error = cio_vm_internal_translatable(vm, module, callable->offset, &translatable);
+        if(error) return error;
+
+        if(translatable) {
+            buffer.entries[i] = 0;
+            any = gen_true;
+        }
+    }
+
+    if(!any) return GEN_NULL;
+
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        if(buffer.entries[i] == GEN_SIZE_MAX) continue;
+
+        error = cio_vm_internal_jit_translate(vm, &buffer, i);
+        if(error) return error;
+    }
+
+    for(gen_size_t i = 0; i < buffer.patches_length; ++i) {
+        const gen_uint32_t displacement = (gen_uint32_t) (buffer.entries[buffer.patch_slots[i]] - (buffer.patches[i] + 4));
+        error = gen_memory_copy(&buffer.code[buffer.patches[i]], buffer.length - buffer.patches[i], &displacement, sizeof(displacement), sizeof(displacement));
+        if(error) return error;
+    }
+
+    const gen_size_t page = (gen_size_t) sysconf(_SC_PAGESIZE);
+    const gen_size_t code_length = ((buffer.length + page - 1) / page) * page;
+    void* const code = mmap(GEN_NULL, code_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(code == MAP_FAILED) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_MEMORY, GEN_LINE_NUMBER, "Failed to map memory for compiled routines");
+
+    error = gen_memory_copy(code, code_length, buffer.code, buffer.length, buffer.length);
+    if(error) {
+        (void) munmap(code, code_length);
+        return error;
+    }
+
+    if(mprotect(code, code_length, PROT_READ | PROT_EXEC)) {
+        (void) munmap(code, code_length);
+        return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "Failed to make compiled routines executable");
+    }
+
+    // The mapping is owned by the VM from here, and released with its image
+    vm->jit_code = code;
+    vm->jit_code_length = code_length;
+
+    // Calls to compiled routines from the interpreter and the extlib dispatch to the compiled code
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        if(vm->dispatch[i].function != cio_vm_internal_execute_routine) continue;
+
+        const gen_size_t routine = vm->bytecode[vm->callables[i].bytecode_index].callables_offset + vm->callables[i].routine_index;
+        if(buffer.entries[routine] == GEN_SIZE_MAX) continue;
+
+        vm->dispatch[i].function = (cio_routine_function_t) (void*) ((unsigned char*) vm->jit_code + buffer.entries[routine]);
+    }
+
+    if(vm->settings.jit_perf_map) {
+        error = cio_vm_internal_jit_write_perf_map(vm, &buffer);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_internal_jit_free(cio_image_t* const restrict image) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(munmap(image->jit_code, image->jit_code_length)) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "Failed to unmap compiled routines");
+    image->jit_code = GEN_NULL;
+    image->jit_code_length = 0;
+
+    return GEN_NULL;
+}
+
+#else
+
+// Routines are always interpreted on platforms the JIT does not support
+gen_error_t* cio_vm_internal_jit_compile(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_compile, GEN_FILE_NAME);
+	if(error) return error;
+
+    (void) vm;
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_internal_jit_free(cio_image_t* const restrict image) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    (void) image;
+
+    return GEN_NULL;
+}
+
+#endif
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/cionom.h"
+
+#include <genmemory.h>
+
+extern gen_error_t* cio_vm_internal_file_map(const char* const restrict path, const unsigned char** const restrict out_file, gen_size_t* const restrict out_file_length);
+extern gen_error_t* cio_vm_internal_file_unmap(const unsigned char* const restrict file, const gen_size_t file_length);
+
+#if defined(__linux__)
+
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+// Files are mapped read-only, so processes loading the same file share its pages through the page cache
+gen_error_t* cio_vm_internal_file_map(const char* const restrict path, const unsigned char** const restrict out_file, gen_size_t* const restrict out_file_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_file_map, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!path) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`path` was `GEN_NULL`");
+	if(!out_file) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_file` was `GEN_NULL`");
+	if(!out_file_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_file_length` was `GEN_NULL`");
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not open `%t`: %t", path, gen_error_description_from_errno());
+
+    struct stat status = {0};
+    if(fstat(fd, &status) == -1) {
+        error = gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not get the size of `%t`: %t", path, gen_error_description_from_errno());
+        close(fd);
+        return error;
+    }
+
+    // Empty mappings are invalid, and an empty file is not bytecode either way
+    if(!status.st_size) {
+        close(fd);
+        return gen_error_attach_backtrace_formatted(GEN_ERROR_BAD_CONTENT, GEN_LINE_NUMBER, "`%t` was empty", path);
+    }
+
+    void* const file = mmap(GEN_NULL, (gen_size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(file == MAP_FAILED) {
+        error = gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not map `%t`: %t", path, gen_error_description_from_errno());
+        close(fd);
+        return error;
+    }
+
+    // The mapping holds its own reference to the file
+    close(fd);
+
+    // Loading decodes every module front to back, so the whole file is read ahead
+    // This is only a hint, so failure is not an error
+    (void) madvise(file, (gen_size_t) status.st_size, MADV_WILLNEED);
+
+    *out_file = file;
+    *out_file_length = (gen_size_t) status.st_size;
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_internal_file_unmap(const unsigned char* const restrict file, const gen_size_t file_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_file_unmap, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!file) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`file` was `GEN_NULL`");
+
+    if(munmap((void*) file, file_length)) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Failed to unmap bytecode file: %t", gen_error_description_from_errno());
+
+    return GEN_NULL;
+}
+
+#else
+
+#include <genfilesystem.h>
+
+static void cio_vm_internal_file_cleanup_buffer(unsigned char** file) {
+    if(!*file) return;
+
+    gen_error_t* error = gen_memory_free((void**) file);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+// Reads the whole of a file which has already been opened and locked
+static gen_error_t* cio_vm_internal_file_read(const char* const restrict path, gen_filesystem_handle_t* const restrict handle, unsigned char** const restrict out_file, gen_size_t* const restrict out_file_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_file_read, GEN_FILE_NAME);
+	if(error) return error;
+
+    gen_size_t file_length = 0;
+    error = gen_filesystem_handle_file_size(handle, &file_length);
+    if(error) return error;
+
+    if(!file_length) return gen_error_attach_backtrace_formatted(GEN_ERROR_BAD_CONTENT, GEN_LINE_NUMBER, "`%t` was empty", path);
+
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_file_cleanup_buffer) unsigned char* file = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &file, file_length, sizeof(unsigned char));
+    if(error) return error;
+
+    error = gen_filesystem_handle_file_read(handle, 0, file_length, file);
+    if(error) return error;
+
+    *out_file = file;
+    *out_file_length = file_length;
+    file = GEN_NULL;
+
+    return GEN_NULL;
+}
+
+// Files are read into memory on platforms without `mmap`
+gen_error_t* cio_vm_internal_file_map(const char* const restrict path, const unsigned char** const restrict out_file, gen_size_t* const restrict out_file_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_file_map, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!path) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`path` was `GEN_NULL`");
+	if(!out_file) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_file` was `GEN_NULL`");
+	if(!out_file_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_file_length` was `GEN_NULL`");
+
+    gen_filesystem_handle_t handle = {0};
+    error = gen_filesystem_handle_open(path, GEN_STRING_NO_BOUNDS, &handle);
+    if(error) return error;
+
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_file_cleanup_buffer) unsigned char* file = GEN_NULL;
+    gen_size_t file_length = 0;
+
+    // The handle is released whether or not reading succeeded, with the first error being the one reported
+    error = gen_filesystem_handle_lock(&handle);
+    if(!error) {
+        error = cio_vm_internal_file_read(path, &handle, &file, &file_length);
+
+        gen_error_t* const unlock_error = gen_filesystem_handle_unlock(&handle);
+        if(!error) error = unlock_error;
+        else if(unlock_error) gen_error_print("cionom", unlock_error, GEN_ERROR_SEVERITY_WARNING);
+    }
+
+    gen_error_t* const close_error = gen_filesystem_handle_close(&handle);
+    if(!error) error = close_error;
+    else if(close_error) gen_error_print("cionom", close_error, GEN_ERROR_SEVERITY_WARNING);
+
+    if(error) return error;
+
+    *out_file = file;
+    *out_file_length = file_length;
+    file = GEN_NULL;
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_internal_file_unmap(const unsigned char* const restrict file, const gen_size_t file_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_file_unmap, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!file) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`file` was `GEN_NULL`");
+
+    (void) file_length;
+
+    unsigned char* freed = (unsigned char*) file;
+    error = gen_memory_free((void**) &freed);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+#endif
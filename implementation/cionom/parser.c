@@ -44,6 +44,157 @@ static void cio_parse_internal_cleanup_program(cio_program_t** program) {
     }
 }
 
+extern gen_error_t* cio_arena_internal_allocate(cio_arena_block_t** const restrict arena, const gen_size_t size, void** const restrict out_pointer);
+extern gen_error_t* cio_arena_internal_reallocate(cio_arena_block_t** const restrict arena, void** const restrict pointer, const gen_size_t size, const gen_size_t new_size);
+extern gen_error_t* cio_arena_internal_free(cio_arena_block_t** const restrict arena);
+extern gen_uint64_t cio_internal_hash(const char* const restrict identifier, const gen_size_t length);
+
+// The number of entries space is initially made for in the identifier intern table
+#define CIO_PARSE_INTERNAL_INTERN_CAPACITY_INITIAL 256
+
+// The number of routines space is initially made for
+#define CIO_PARSE_INTERNAL_ROUTINES_CAPACITY_INITIAL 16
+
+typedef struct {
+    const char* identifier;
+    gen_size_t length;
+    gen_uint64_t hash;
+} cio_parse_internal_intern_entry_t;
+
+// An open-addressed table of the identifiers interned into an arena-backed program
+typedef struct {
+    cio_parse_internal_intern_entry_t* entries;
+    // Always a power of two
+    gen_size_t capacity;
+    gen_size_t length;
+} cio_parse_internal_interner_t;
+
+static void cio_parse_internal_cleanup_interner(cio_parse_internal_interner_t* interner) {
+    if(!interner->entries) return;
+
+    gen_error_t* error = gen_memory_free((void**) &interner->entries);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+static gen_error_t* cio_parse_internal_interner_grow(cio_parse_internal_interner_t* const restrict interner) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_parse_internal_interner_grow, GEN_FILE_NAME);
+	if(error) return error;
+
+    const gen_size_t capacity = interner->capacity ? interner->capacity * 2 : CIO_PARSE_INTERNAL_INTERN_CAPACITY_INITIAL;
+
+    cio_parse_internal_intern_entry_t* entries = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &entries, capacity, sizeof(cio_parse_internal_intern_entry_t));
+    if(error) return error;
+
+    for(gen_size_t i = 0; i < interner->capacity; ++i) {
+        const cio_parse_internal_intern_entry_t* const entry = &interner->entries[i];
+        if(!entry->identifier) continue;
+
+        gen_size_t slot = (gen_size_t) (entry->hash & (capacity - 1));
+        while(entries[slot].identifier) slot = (slot + 1) & (capacity - 1);
+        entries[slot] = *entry;
+    }
+
+    if(interner->entries) {
+        error = gen_memory_free((void**) &interner->entries);
+        if(error) return error;
+    }
+
+    interner->entries = entries;
+    interner->capacity = capacity;
+
+    return GEN_NULL;
+}
+
+// Gets storage for an identifier - interned into the arena for arena-backed programs, otherwise duplicated
+static gen_error_t* cio_parse_internal_identifier(cio_program_t* const restrict program, cio_parse_internal_interner_t* const restrict interner, const char* const restrict identifier, const gen_size_t identifier_bounds, const gen_size_t length, char** const restrict out_identifier) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_parse_internal_identifier, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(!program->arena) return gen_string_duplicate(identifier, identifier_bounds, length, out_identifier, GEN_NULL);
+
+    if((interner->length + 1) * 2 > interner->capacity) {
+        error = cio_parse_internal_interner_grow(interner);
+        if(error) return error;
+    }
+
+    const gen_uint64_t hash = cio_internal_hash(identifier, length);
+
+    gen_size_t slot = (gen_size_t) (hash & (interner->capacity - 1));
+    for(; interner->entries[slot].identifier; slot = (slot + 1) & (interner->capacity - 1)) {
+        const cio_parse_internal_intern_entry_t* const entry = &interner->entries[slot];
+        if(entry->hash != hash || entry->length != length) continue;
+
+        gen_bool_t equal = gen_false;
+        error = gen_memory_compare(entry->identifier, length, identifier, length, length, &equal);
+        if(error) return error;
+
+        if(equal) {
+            *out_identifier = (char*) entry->identifier;
+            return GEN_NULL;
+        }
+    }
+
+    // Arena storage is zeroed so the copy is already terminated
+    error = cio_arena_internal_allocate(&program->arena_blocks, length + 1, (void**) out_identifier);
+    if(error) return error;
+
+    error = gen_memory_copy(*out_identifier, length + 1, identifier, identifier_bounds, length);
+    if(error) return error;
+
+    interner->entries[slot] = (cio_parse_internal_intern_entry_t) {*out_identifier, length, hash};
+    ++interner->length;
+
+    return GEN_NULL;
+}
+
+// Gets zeroed storage for part of a program - from the arena for arena-backed programs, otherwise from the heap
+static gen_error_t* cio_parse_internal_allocate(cio_program_t* const restrict program, const gen_size_t count, const gen_size_t size, void** const restrict out_pointer) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_parse_internal_allocate, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(program->arena) return cio_arena_internal_allocate(&program->arena_blocks, count * size, out_pointer);
+
+    return gen_memory_allocate_zeroed(out_pointer, count, size);
+}
+
+// Counts the routines in a token buffer by following the structure parsing expects without validating it
+static gen_size_t cio_parse_internal_count_routines(const cio_token_t* const restrict tokens, const gen_size_t tokens_length) {
+    gen_size_t count = 0;
+    for(gen_size_t i = 0; i < tokens_length; ++count) {
+        // Identifier and parameter count
+        i += 2;
+
+        if(i < tokens_length && tokens[i].type == CIO_TOKEN_BLOCK) {
+            for(++i; i < tokens_length && tokens[i].type != CIO_TOKEN_BLOCK; ++i);
+            ++i;
+        }
+    }
+
+    return count;
+}
+
+// Counts the calls in a routine body beginning at `start`
+static gen_size_t cio_parse_internal_count_calls(const cio_token_t* const restrict tokens, const gen_size_t tokens_length, gen_size_t start) {
+    gen_size_t count = 0;
+    for(; start < tokens_length && tokens[start].type != CIO_TOKEN_BLOCK; ++start) {
+        if(tokens[start].type == CIO_TOKEN_IDENTIFIER) ++count;
+    }
+
+    return count;
+}
+
+// Counts the parameters to a call beginning at `start`
+static gen_size_t cio_parse_internal_count_parameters(const cio_token_t* const restrict tokens, const gen_size_t tokens_length, gen_size_t start) {
+    gen_size_t count = 0;
+    for(; start < tokens_length && tokens[start].type == CIO_TOKEN_NUMBER; ++start) ++count;
+
+    return count;
+}
+
 gen_error_t* cio_parse(const cio_token_t* const restrict tokens, const gen_size_t tokens_length, cio_program_t* const restrict out_program, const char* const restrict source, const gen_size_t source_length, const char* const restrict source_file, const gen_size_t source_file_length, const cio_warning_settings_t* const restrict warning_settings) {
 	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_parse, GEN_FILE_NAME);
 	if(error) return error;
@@ -55,18 +206,39 @@ gen_error_t* cio_parse(const cio_token_t* const restrict tokens, const gen_size_
 	if(!tokens) return GEN_NULL;
 
     GEN_CLEANUP_FUNCTION(cio_parse_internal_cleanup_program) cio_program_t* program_cleanup = out_program;
+    GEN_CLEANUP_FUNCTION(cio_parse_internal_cleanup_interner) cio_parse_internal_interner_t interner = {0};
+
+    gen_size_t routines_capacity = out_program->routines_length;
+
+    const gen_size_t routines_length = cio_parse_internal_count_routines(tokens, tokens_length);
+    if(routines_length) {
+        const gen_size_t capacity = out_program->routines_length + routines_length;
+
+        if(out_program->arena) error = cio_arena_internal_reallocate(&out_program->arena_blocks, (void**) &out_program->routines, routines_capacity * sizeof(cio_routine_t), capacity * sizeof(cio_routine_t));
+        else error = gen_memory_reallocate_zeroed((void**) &out_program->routines, routines_capacity, capacity, sizeof(cio_routine_t));
+        if(error) return error;
+
+        routines_capacity = capacity;
+    }
 
     for(gen_size_t i = 0; i < tokens_length; ++i) {
         const cio_token_t* token = &tokens[i];
 
 		error = cio_parse_internal_expect(token, CIO_TOKEN_IDENTIFIER, source, source_length, source_file, source_file_length);
 		if(error) return error;
-		error = gen_memory_reallocate_zeroed((void**) &out_program->routines, out_program->routines_length, out_program->routines_length + 1, sizeof(cio_routine_t));
-		if(error) return error;
+        if(out_program->routines_length == routines_capacity) {
+            const gen_size_t capacity = routines_capacity ? routines_capacity * 2 : CIO_PARSE_INTERNAL_ROUTINES_CAPACITY_INITIAL;
+
+            if(out_program->arena) error = cio_arena_internal_reallocate(&out_program->arena_blocks, (void**) &out_program->routines, routines_capacity * sizeof(cio_routine_t), capacity * sizeof(cio_routine_t));
+            else error = gen_memory_reallocate_zeroed((void**) &out_program->routines, routines_capacity, capacity, sizeof(cio_routine_t));
+            if(error) return error;
+
+            routines_capacity = capacity;
+        }
 		++out_program->routines_length;
 		cio_routine_t* const routine = &out_program->routines[out_program->routines_length - 1];
 		routine->token = token;
-		error = gen_string_duplicate(source + token->offset, source_length - token->offset, token->length, &routine->identifier, GEN_NULL);
+		error = cio_parse_internal_identifier(out_program, &interner, source + token->offset, source_length - token->offset, token->length, &routine->identifier);
 		if(error) return error;
 
         if(warning_settings->reserved_identifier) {
@@ -148,17 +320,27 @@ gen_error_t* cio_parse(const cio_token_t* const restrict tokens, const gen_size_
         i += 2;
         token = &tokens[i];
 
+        const gen_size_t calls_length = cio_parse_internal_count_calls(tokens, tokens_length, i);
+        if(calls_length) {
+            error = cio_parse_internal_allocate(out_program, calls_length, sizeof(cio_call_t), (void**) &routine->calls);
+            if(error) return error;
+        }
+
 		while(token->type != CIO_TOKEN_BLOCK) {
 			error = cio_parse_internal_expect(token, CIO_TOKEN_IDENTIFIER, source, source_length, source_file, source_file_length);
 			if(error) return error;
-			error = gen_memory_reallocate_zeroed((void**) &routine->calls, routine->calls_length, routine->calls_length + 1, sizeof(cio_call_t));
-			if(error) return error;
 			++routine->calls_length;
 			cio_call_t* const call = &routine->calls[routine->calls_length - 1];
 			call->token = token;
-			error = gen_string_duplicate(source + token->offset, source_length - token->offset, token->length, &call->identifier, GEN_NULL);
+			error = cio_parse_internal_identifier(out_program, &interner, source + token->offset, source_length - token->offset, token->length, &call->identifier);
 			if(error) return error;
 
+            const gen_size_t parameters_length = cio_parse_internal_count_parameters(tokens, tokens_length, i + 1);
+            if(parameters_length) {
+                error = cio_parse_internal_allocate(out_program, parameters_length, sizeof(gen_size_t), (void**) &call->parameters);
+                if(error) return error;
+            }
+
             if(!(i + 1 < tokens_length)) {
                 gen_size_t line = 0;
                 gen_size_t column = 0;
@@ -184,8 +366,6 @@ gen_error_t* cio_parse(const cio_token_t* const restrict tokens, const gen_size_
             }
 
 			while(token->type == CIO_TOKEN_NUMBER) {
-				error = gen_memory_reallocate_zeroed((void**) &call->parameters, call->parameters_length, call->parameters_length + 1, sizeof(gen_size_t));
-				if(error) return error;
 				++call->parameters_length;
 				error = gen_string_number(source + token->offset, source_length - token->offset, token->length, &call->parameters[call->parameters_length - 1]);
 				if(error) return error;
@@ -221,6 +401,16 @@ gen_error_t* cio_program_free(cio_program_t* const restrict program) {
 
 	if(!program) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`program` was `GEN_NULL`");
 
+    if(program->arena) {
+        error = cio_arena_internal_free(&program->arena_blocks);
+        if(error) return error;
+
+        program->routines = GEN_NULL;
+        program->routines_length = 0;
+
+        return GEN_NULL;
+    }
+
     for(gen_size_t i = 0; i < program->routines_length; ++i) {
         if(program->routines[i].identifier) {
             error = gen_memory_free((void**) &program->routines[i].identifier);
@@ -236,6 +426,10 @@ gen_error_t* cio_program_free(cio_program_t* const restrict program) {
                 if(error) return error;
             }        
         }
+        if(program->routines[i].calls) {
+            error = gen_memory_free((void**) &program->routines[i].calls);
+            if(error) return error;
+        }
     }
 
     if(program->routines) {
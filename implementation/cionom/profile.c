@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/cionom.h"
+
+#include <genmemory.h>
+#include <genstring.h>
+
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <time.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+extern gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm);
+
+// The number of call stacks space is initially made for
+#define CIO_VM_INTERNAL_PROFILE_NODES_INITIAL 64
+
+// The number of characters space is initially made for in emitted profiles
+#define CIO_VM_INTERNAL_PROFILE_OUTPUT_INITIAL 256
+
+// Gets a monotonic timestamp in nanoseconds
+// Also used to time program resolution
+extern gen_size_t cio_vm_internal_now(void);
+gen_size_t cio_vm_internal_now(void) {
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (gen_size_t) now.tv_sec * 1000000000 + (gen_size_t) now.tv_nsec;
+}
+
+// Sets up profiling for a VM with `settings.profile`
+// Used by VM initialization
+extern gen_error_t* cio_vm_internal_profile_initialize(cio_vm_t* const restrict vm);
+gen_error_t* cio_vm_internal_profile_initialize(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_profile_initialize, GEN_FILE_NAME);
+	if(error) return error;
+
+    error = gen_memory_allocate_zeroed((void**) &vm->profile, 1, sizeof(cio_profile_t));
+    if(error) return error;
+
+    cio_profile_t* const profile = vm->profile;
+
+    error = gen_memory_allocate_zeroed((void**) &profile->callables, vm->callables_length ? vm->callables_length : 1, sizeof(cio_profile_callable_t));
+    if(error) return error;
+
+    profile->nodes_capacity = CIO_VM_INTERNAL_PROFILE_NODES_INITIAL;
+    error = gen_memory_allocate_zeroed((void**) &profile->nodes, profile->nodes_capacity, sizeof(cio_profile_node_t));
+    if(error) return error;
+    profile->nodes[0] = (cio_profile_node_t) {GEN_SIZE_MAX, GEN_SIZE_MAX, GEN_SIZE_MAX, GEN_SIZE_MAX, 0};
+    profile->nodes_length = 1;
+
+    // Every call in progress has a frame
+    profile->activations_length = vm->frames_length;
+    error = gen_memory_allocate_zeroed((void**) &profile->activations, profile->activations_length ? profile->activations_length : 1, sizeof(cio_profile_activation_t));
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+// Used by `cio_vm_free`
+extern gen_error_t* cio_vm_internal_profile_free(cio_vm_t* const restrict vm);
+gen_error_t* cio_vm_internal_profile_free(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_profile_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(!vm->profile) return GEN_NULL;
+
+    error = gen_memory_free((void**) &vm->profile->callables);
+    if(error) return error;
+    error = gen_memory_free((void**) &vm->profile->nodes);
+    if(error) return error;
+    error = gen_memory_free((void**) &vm->profile->activations);
+    if(error) return error;
+    error = gen_memory_free((void**) &vm->profile);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+// Records the beginning of a call to a callable
+// Used by the interpreter and `cio_vm_internal_dispatch_slot`
+extern gen_error_t* cio_vm_internal_profile_enter(cio_vm_t* const restrict vm, const gen_size_t slot);
+gen_error_t* cio_vm_internal_profile_enter(cio_vm_t* const restrict vm, const gen_size_t slot) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_profile_enter, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_profile_t* const profile = vm->profile;
+    if(profile->activations_used == profile->activations_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "Too many profiled calls in progress");
+
+    const gen_size_t parent = profile->activations_used ? profile->activations[profile->activations_used - 1].node : 0;
+
+    gen_size_t node = profile->nodes[parent].first_child;
+    while(node != GEN_SIZE_MAX && profile->nodes[node].callable != slot) node = profile->nodes[node].next_sibling;
+
+    if(node == GEN_SIZE_MAX) {
+        if(profile->nodes_length == profile->nodes_capacity) {
+            error = gen_memory_reallocate_zeroed((void**) &profile->nodes, profile->nodes_capacity, profile->nodes_capacity * 2, sizeof(cio_profile_node_t));
+            if(error) return error;
+            profile->nodes_capacity *= 2;
+        }
+
+        node = profile->nodes_length++;
+        profile->nodes[node] = (cio_profile_node_t) {slot, parent, GEN_SIZE_MAX, profile->nodes[parent].first_child, 0};
+        profile->nodes[parent].first_child = node;
+    }
+
+    ++profile->callables[slot].calls;
+    ++profile->callables[slot].active;
+
+    profile->activations[profile->activations_used++] = (cio_profile_activation_t) {node, cio_vm_internal_now(), 0};
+
+    return GEN_NULL;
+}
+
+// Records the end of the innermost call in progress
+// Used by the interpreter and `cio_vm_internal_dispatch_slot`
+extern gen_error_t* cio_vm_internal_profile_exit(cio_vm_t* const restrict vm);
+gen_error_t* cio_vm_internal_profile_exit(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_profile_exit, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_profile_t* const profile = vm->profile;
+    if(!profile->activations_used) return GEN_NULL;
+
+    const cio_profile_activation_t* const activation = &profile->activations[--profile->activations_used];
+    const gen_size_t elapsed = cio_vm_internal_now() - activation->start;
+    const gen_size_t exclusive = elapsed - activation->children;
+
+    cio_profile_node_t* const node = &profile->nodes[activation->node];
+    node->exclusive += exclusive;
+
+    cio_profile_callable_t* const callable = &profile->callables[node->callable];
+    callable->exclusive += exclusive;
+    if(!--callable->active) callable->inclusive += elapsed;
+
+    if(profile->activations_used) profile->activations[profile->activations_used - 1].children += elapsed;
+
+    return GEN_NULL;
+}
+
+// Gets the padding to right-align a number in a summary column
+static gen_size_t cio_vm_internal_profile_pad(const gen_size_t width, gen_size_t value) {
+    gen_size_t digits = 1;
+    while(value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+
+    return digits < width ? width - digits : 0;
+}
+
+// Grows an emitted buffer to hold at least `length` characters
+// Buffers double in size so that emitting is linear in the length of the output
+static gen_error_t* cio_vm_internal_profile_reserve(char** const restrict buffer, gen_size_t* const restrict capacity, const gen_size_t length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_profile_reserve, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(length <= *capacity) return GEN_NULL;
+
+    gen_size_t grown = *capacity ? *capacity * 2 : CIO_VM_INTERNAL_PROFILE_OUTPUT_INITIAL;
+    while(grown < length) grown *= 2;
+
+    error = gen_memory_reallocate_zeroed((void**) buffer, *capacity, grown, sizeof(char));
+    if(error) return error;
+    *capacity = grown;
+
+    return GEN_NULL;
+}
+
+static void cio_vm_internal_profile_cleanup_path(char** path) {
+    if(!*path) return;
+
+    gen_error_t* error = gen_memory_free((void**) path);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+static void cio_vm_internal_profile_cleanup_indices(gen_size_t** indices) {
+    if(!*indices) return;
+
+    gen_error_t* error = gen_memory_free((void**) indices);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+#define CIO_VM_INTERNAL_PROFILE_APPEND(out, out_length, out_capacity, format, ...) \
+    do { \
+        gen_size_t formatted_length = 0; \
+        error = gen_string_format(GEN_STRING_NO_BOUNDS, GEN_NULL, &formatted_length, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        error = cio_vm_internal_profile_reserve(out, out_capacity, *out_length + formatted_length + 1); \
+        if(error) return error; \
+        error = gen_string_format(formatted_length + 1, &(*out)[*out_length], GEN_NULL, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        *out_length += formatted_length; \
+    } while(0)
+
+gen_error_t* cio_vm_emit_profile(const cio_vm_t* const restrict vm, char** const restrict out_summary, gen_size_t* const restrict out_summary_length, char** const restrict out_folded, gen_size_t* const restrict out_folded_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_emit_profile, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!vm->profile) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "`vm` was not initialized with `profile` set");
+	if(!out_summary) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_summary` was `GEN_NULL`");
+	if(!out_summary_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_summary_length` was `GEN_NULL`");
+	if(!out_folded) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_folded` was `GEN_NULL`");
+	if(!out_folded_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_folded_length` was `GEN_NULL`");
+
+    const cio_profile_t* const profile = vm->profile;
+
+    *out_summary = GEN_NULL;
+    *out_summary_length = 0;
+    *out_folded = GEN_NULL;
+    *out_folded_length = 0;
+
+    gen_size_t summary_capacity = 0;
+    gen_size_t folded_capacity = 0;
+
+    // Callables are listed by exclusive time, most first
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_profile_cleanup_indices) gen_size_t* order = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &order, vm->callables_length ? vm->callables_length : 1, sizeof(gen_size_t));
+    if(error) return error;
+
+    gen_size_t order_length = 0;
+    gen_size_t identifier_width = sizeof("routine") - 1;
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        if(!profile->callables[i].calls) continue;
+        if(vm->callables[i].identifier_length > identifier_width) identifier_width = vm->callables[i].identifier_length;
+
+        gen_size_t j = order_length++;
+        for(; j && profile->callables[order[j - 1]].exclusive < profile->callables[i].exclusive; --j) order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    CIO_VM_INTERNAL_PROFILE_APPEND(out_summary, out_summary_length, &summary_capacity, "routine%cz  module  kind           calls  inclusive (ns)  exclusive (ns)\n", ' ', identifier_width - (sizeof("routine") - 1));
+
+    gen_size_t cionom_time = 0;
+    gen_size_t external_time = 0;
+    for(gen_size_t i = 0; i < order_length; ++i) {
+        const cio_callable_t* const callable = &vm->callables[order[i]];
+        const cio_profile_callable_t* const totals = &profile->callables[order[i]];
+        const gen_bool_t cionom = vm->dispatch[order[i]].function == cio_vm_internal_execute_routine;
+
+        if(cionom) cionom_time += totals->exclusive;
+        else external_time += totals->exclusive;
+
+        CIO_VM_INTERNAL_PROFILE_APPEND(out_summary, out_summary_length, &summary_capacity, "%t%cz  %cz%uz  %t  %cz%uz  %cz%uz  %cz%uz\n", callable->identifier, ' ', identifier_width - callable->identifier_length, ' ', cio_vm_internal_profile_pad(sizeof("module") - 1, callable->bytecode_index), callable->bytecode_index, cionom ? "cionom  " : "external", ' ', cio_vm_internal_profile_pad(sizeof("     calls") - 1, totals->calls), totals->calls, ' ', cio_vm_internal_profile_pad(sizeof("inclusive (ns)") - 1, totals->inclusive), totals->inclusive, ' ', cio_vm_internal_profile_pad(sizeof("exclusive (ns)") - 1, totals->exclusive), totals->exclusive);
+    }
+
+    CIO_VM_INTERNAL_PROFILE_APPEND(out_summary, out_summary_length, &summary_capacity, "Exclusive time in Cíonom routines: %uz ns, in external routines: %uz ns\n", cionom_time, external_time);
+
+    // Frames are named `identifier@module` - each line is a call stack from the root followed by the time spent in it
+    // The tree is walked depth first, with the path to the current node kept as it would be emitted
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_profile_cleanup_path) char* path = GEN_NULL;
+    gen_size_t path_length = 0;
+    gen_size_t path_capacity = 0;
+    error = cio_vm_internal_profile_reserve(&path, &path_capacity, 1);
+    if(error) return error;
+
+    // The length of the path above each node on it, to be restored when leaving the node
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_profile_cleanup_indices) gen_size_t* lengths = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &lengths, profile->nodes_length, sizeof(gen_size_t));
+    if(error) return error;
+    gen_size_t depth = 0;
+
+    gen_size_t node = profile->nodes[0].first_child;
+    while(node != GEN_SIZE_MAX) {
+        const cio_callable_t* const callable = &vm->callables[profile->nodes[node].callable];
+        lengths[depth++] = path_length;
+        CIO_VM_INTERNAL_PROFILE_APPEND(&path, &path_length, &path_capacity, "%t%t@%uz", depth == 1 ? "" : ";", callable->identifier, callable->bytecode_index);
+
+        if(profile->nodes[node].exclusive) CIO_VM_INTERNAL_PROFILE_APPEND(out_folded, out_folded_length, &folded_capacity, "%t %uz\n", path, profile->nodes[node].exclusive);
+
+        if(profile->nodes[node].first_child != GEN_SIZE_MAX) {
+            node = profile->nodes[node].first_child;
+            continue;
+        }
+
+        // Leave each node with no siblings left to visit
+        while(depth && profile->nodes[node].next_sibling == GEN_SIZE_MAX) {
+            path_length = lengths[--depth];
+            node = profile->nodes[node].parent;
+        }
+        if(!depth) break;
+
+        path_length = lengths[--depth];
+        node = profile->nodes[node].next_sibling;
+    }
+
+    return GEN_NULL;
+}
+
+#undef CIO_VM_INTERNAL_PROFILE_APPEND
@@ -0,0 +1,361 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/cionom.h"
+
+#include <genmemory.h>
+#include <genstring.h>
+
+#if defined(__linux__)
+
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <signal.h>
+#include <sys/time.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+// `ITIMER_PROF` is per-process, so only one VM can be sampled at a time
+static gen_bool_t cio_vm_internal_sampling = gen_false;
+static struct sigaction cio_vm_internal_sampling_previous = {0};
+
+// Signals are only sampled on the thread executing the VM
+static _Thread_local cio_vm_t* cio_vm_internal_sampled = GEN_NULL;
+
+// Runs in signal context, so may only touch the VM's frames and the ring
+static void cio_vm_internal_sample(int signal) {
+    (void) signal;
+
+    cio_vm_t* const vm = cio_vm_internal_sampled;
+    if(!vm) return;
+
+    cio_sampler_t* const sampler = vm->sampler;
+    if(__atomic_load_n(&sampler->paused, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&sampler->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    const gen_size_t head = __atomic_load_n(&sampler->head, __ATOMIC_RELAXED);
+    if(head - __atomic_load_n(&sampler->tail, __ATOMIC_ACQUIRE) == sampler->capacity) {
+        __atomic_add_fetch(&sampler->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    cio_sample_t* const sample = &sampler->samples[head % sampler->capacity];
+
+    // The first frame belongs to whatever dispatched into the VM
+    gen_size_t depth = 0;
+    gen_size_t i = vm->frames_used;
+    for(; i > 1 && depth < CIO_SAMPLE_DEPTH_MAX; --i) {
+        const cio_frame_t* const frame = &vm->frames[i - 1];
+        if(frame->execution_offset == CIO_FRAME_BRANCH) continue;
+
+        sample->frames[depth++] = (cio_sample_frame_t) {frame->bytecode_index, (gen_uint32_t) frame->execution_offset};
+    }
+    sample->depth = depth;
+    sample->truncated = i > 1;
+
+    __atomic_store_n(&sampler->head, head + 1, __ATOMIC_RELEASE);
+}
+
+gen_error_t* cio_vm_start_sampling(cio_vm_t* const restrict vm, const gen_size_t frequency, const gen_size_t capacity) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_start_sampling, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!frequency || frequency > 1000000) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`frequency` must be between 1 and 1000000 samples per second");
+	if(!capacity) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`capacity` was 0");
+
+    if(vm->sampler && vm->sampler->running) return gen_error_attach_backtrace(GEN_ERROR_IN_USE, GEN_LINE_NUMBER, "`vm` is already being sampled");
+    if(__atomic_exchange_n(&cio_vm_internal_sampling, gen_true, __ATOMIC_ACQ_REL)) return gen_error_attach_backtrace(GEN_ERROR_IN_USE, GEN_LINE_NUMBER, "Another VM is already being sampled");
+
+    if(!vm->sampler) {
+        error = gen_memory_allocate_zeroed((void**) &vm->sampler, 1, sizeof(cio_sampler_t));
+        if(error) return error;
+    }
+
+    // Samples not yet emitted are discarded if the ring is resized
+    if(vm->sampler->capacity != capacity) {
+        if(vm->sampler->samples) {
+            error = gen_memory_free((void**) &vm->sampler->samples);
+            if(error) return error;
+        }
+
+        error = gen_memory_allocate_zeroed((void**) &vm->sampler->samples, capacity, sizeof(cio_sample_t));
+        if(error) return error;
+
+        vm->sampler->capacity = capacity;
+        vm->sampler->head = 0;
+        vm->sampler->tail = 0;
+    }
+    vm->sampler->dropped = 0;
+    vm->sampler->paused = gen_false;
+
+    cio_vm_internal_sampled = vm;
+
+    struct sigaction action = {0};
+    action.sa_handler = cio_vm_internal_sample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if(sigaction(SIGPROF, &action, &cio_vm_internal_sampling_previous)) {
+        cio_vm_internal_sampled = GEN_NULL;
+        __atomic_store_n(&cio_vm_internal_sampling, gen_false, __ATOMIC_RELEASE);
+        return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Failed to install the sampling signal handler: %t", gen_error_description_from_errno());
+    }
+
+    const gen_size_t interval = 1000000 / frequency;
+    const struct itimerval timer = {{(time_t) (interval / 1000000), (suseconds_t) (interval % 1000000)}, {(time_t) (interval / 1000000), (suseconds_t) (interval % 1000000)}};
+    if(setitimer(ITIMER_PROF, &timer, GEN_NULL)) {
+        sigaction(SIGPROF, &cio_vm_internal_sampling_previous, GEN_NULL);
+        cio_vm_internal_sampled = GEN_NULL;
+        __atomic_store_n(&cio_vm_internal_sampling, gen_false, __ATOMIC_RELEASE);
+        return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Failed to start the sampling timer: %t", gen_error_description_from_errno());
+    }
+
+    vm->sampler->running = gen_true;
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_stop_sampling(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_stop_sampling, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+
+    if(!vm->sampler || !vm->sampler->running) return GEN_NULL;
+
+    const struct itimerval timer = {0};
+    if(setitimer(ITIMER_PROF, &timer, GEN_NULL)) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Failed to stop the sampling timer: %t", gen_error_description_from_errno());
+    if(sigaction(SIGPROF, &cio_vm_internal_sampling_previous, GEN_NULL)) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Failed to restore the previous `SIGPROF` handler: %t", gen_error_description_from_errno());
+
+    cio_vm_internal_sampled = GEN_NULL;
+    vm->sampler->running = gen_false;
+    __atomic_store_n(&cio_vm_internal_sampling, gen_false, __ATOMIC_RELEASE);
+
+    return GEN_NULL;
+}
+
+#else
+
+// Sampling relies on `ITIMER_PROF` and `SIGPROF`
+gen_error_t* cio_vm_start_sampling(cio_vm_t* const restrict vm, const gen_size_t frequency, const gen_size_t capacity) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_start_sampling, GEN_FILE_NAME);
+	if(error) return error;
+
+    (void) vm;
+    (void) frequency;
+    (void) capacity;
+
+    return gen_error_attach_backtrace(GEN_ERROR_NOT_IMPLEMENTED, GEN_LINE_NUMBER, "Sampling is not supported on this platform");
+}
+
+gen_error_t* cio_vm_stop_sampling(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_stop_sampling, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+
+    return GEN_NULL;
+}
+
+#endif
+
+// Used by `cio_vm_free`
+extern gen_error_t* cio_vm_internal_sampler_free(cio_vm_t* const restrict vm);
+gen_error_t* cio_vm_internal_sampler_free(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_sampler_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(!vm->sampler) return GEN_NULL;
+
+    error = cio_vm_stop_sampling(vm);
+    if(error) return error;
+
+    if(vm->sampler->samples) {
+        error = gen_memory_free((void**) &vm->sampler->samples);
+        if(error) return error;
+    }
+
+    error = gen_memory_free((void**) &vm->sampler);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+// A symbolised call stack and the number of samples of it
+typedef struct {
+    gen_size_t depth;
+    gen_bool_t truncated;
+    // Indices into `vm->callables`, or `GEN_SIZE_MAX` for frames of external routines
+    gen_size_t callables[CIO_SAMPLE_DEPTH_MAX];
+    gen_size_t bytecode_indices[CIO_SAMPLE_DEPTH_MAX];
+    gen_size_t count;
+} cio_vm_internal_sampled_stack_t;
+
+// Finds the routine containing a frame's execution offset
+static gen_size_t cio_vm_internal_sample_symbolise(const cio_vm_t* const restrict vm, const cio_sample_frame_t* const restrict frame) {
+    if(frame->bytecode_index >= vm->bytecode_length || frame->execution_offset == CIO_ROUTINE_EXTERNAL) return GEN_SIZE_MAX;
+
+    const cio_bytecode_t* const module = &vm->bytecode[frame->bytecode_index];
+
+    gen_size_t found = GEN_SIZE_MAX;
+    for(gen_size_t i = 0; i < module->callables_length; ++i) {
+        const cio_callable_t* const callable = &module->callables[i];
+        if(callable->bytecode_index != frame->bytecode_index || callable->offset == CIO_ROUTINE_EXTERNAL || callable->offset > frame->execution_offset) continue;
+        if(found == GEN_SIZE_MAX || callable->offset > vm->callables[found].offset) found = (gen_size_t) (callable - vm->callables);
+    }
+
+    return found;
+}
+
+#define CIO_VM_INTERNAL_SAMPLE_OUTPUT_INITIAL 256
+
+// Grows `buffer` to hold at least `length` bytes, doubling so that appending is amortised linear
+static gen_error_t* cio_vm_internal_sample_reserve(char** const restrict buffer, gen_size_t* const restrict capacity, const gen_size_t length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_sample_reserve, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(length <= *capacity) return GEN_NULL;
+
+    gen_size_t grown = *capacity ? *capacity * 2 : CIO_VM_INTERNAL_SAMPLE_OUTPUT_INITIAL;
+    while(grown < length) grown *= 2;
+
+    error = gen_memory_reallocate_zeroed((void**) buffer, *capacity, grown, sizeof(char));
+    if(error) return error;
+    *capacity = grown;
+
+    return GEN_NULL;
+}
+
+// FNV-1a over the symbolised frames, so equal stacks land in the same slot
+static gen_size_t cio_vm_internal_sample_hash(const cio_vm_internal_sampled_stack_t* const restrict stack) {
+    gen_size_t hash = 14695981039346656037ULL;
+    hash = (hash ^ stack->depth) * 1099511628211ULL;
+    hash = (hash ^ (gen_size_t) stack->truncated) * 1099511628211ULL;
+    for(gen_size_t i = 0; i < stack->depth; ++i) {
+        hash = (hash ^ stack->callables[i]) * 1099511628211ULL;
+        hash = (hash ^ stack->bytecode_indices[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static gen_bool_t cio_vm_internal_sample_equal(const cio_vm_internal_sampled_stack_t* const restrict a, const cio_vm_internal_sampled_stack_t* const restrict b) {
+    if(a->depth != b->depth || a->truncated != b->truncated) return gen_false;
+
+    for(gen_size_t i = 0; i < a->depth; ++i) {
+        if(a->callables[i] != b->callables[i] || a->bytecode_indices[i] != b->bytecode_indices[i]) return gen_false;
+    }
+
+    return gen_true;
+}
+
+static void cio_vm_internal_sample_cleanup_stacks(cio_vm_internal_sampled_stack_t** stacks) {
+    if(!*stacks) return;
+
+    gen_error_t* error = gen_memory_free((void**) stacks);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+static void cio_vm_internal_sample_cleanup_slots(gen_size_t** slots) {
+    if(!*slots) return;
+
+    gen_error_t* error = gen_memory_free((void**) slots);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+#define CIO_VM_INTERNAL_SAMPLE_APPEND(format, ...) \
+    do { \
+        gen_size_t formatted_length = 0; \
+        error = gen_string_format(GEN_STRING_NO_BOUNDS, GEN_NULL, &formatted_length, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        error = cio_vm_internal_sample_reserve(out_folded, &folded_capacity, *out_folded_length + formatted_length + 1); \
+        if(error) return error; \
+        error = gen_string_format(formatted_length + 1, &(*out_folded)[*out_folded_length], GEN_NULL, format, sizeof(format) - 1, ##__VA_ARGS__); \
+        if(error) return error; \
+        *out_folded_length += formatted_length; \
+    } while(0)
+
+gen_error_t* cio_vm_emit_samples(cio_vm_t* const restrict vm, char** const restrict out_folded, gen_size_t* const restrict out_folded_length, gen_size_t* const restrict out_dropped) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_emit_samples, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!vm->sampler) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "`vm` has not been sampled");
+	if(!out_folded) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_folded` was `GEN_NULL`");
+	if(!out_folded_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_folded_length` was `GEN_NULL`");
+	if(!out_dropped) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_dropped` was `GEN_NULL`");
+
+    cio_sampler_t* const sampler = vm->sampler;
+
+    *out_folded = GEN_NULL;
+    *out_folded_length = 0;
+    *out_dropped = __atomic_load_n(&sampler->dropped, __ATOMIC_RELAXED);
+
+    const gen_size_t tail = sampler->tail;
+    const gen_size_t head = __atomic_load_n(&sampler->head, __ATOMIC_ACQUIRE);
+    if(head == tail) return GEN_NULL;
+
+    const gen_size_t samples_length = head - tail;
+
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_sample_cleanup_stacks) cio_vm_internal_sampled_stack_t* stacks = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &stacks, samples_length, sizeof(cio_vm_internal_sampled_stack_t));
+    if(error) return error;
+
+    // Open-addressed table of `stacks` indices plus one, kept at most half full so probes stay short
+    gen_size_t slots_length = 1;
+    while(slots_length < samples_length * 2) slots_length *= 2;
+
+    GEN_CLEANUP_FUNCTION(cio_vm_internal_sample_cleanup_slots) gen_size_t* slots = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &slots, slots_length, sizeof(gen_size_t));
+    if(error) return error;
+
+    gen_size_t stacks_length = 0;
+    for(gen_size_t i = tail; i < head; ++i) {
+        const cio_sample_t* const sample = &sampler->samples[i % sampler->capacity];
+
+        cio_vm_internal_sampled_stack_t* const stack = &stacks[stacks_length];
+        *stack = (cio_vm_internal_sampled_stack_t) {sample->depth, sample->truncated, {0}, {0}, 1};
+        for(gen_size_t j = 0; j < sample->depth; ++j) {
+            stack->callables[j] = cio_vm_internal_sample_symbolise(vm, &sample->frames[j]);
+            stack->bytecode_indices[j] = sample->frames[j].bytecode_index;
+        }
+
+        gen_size_t slot = cio_vm_internal_sample_hash(stack) & (slots_length - 1);
+        while(slots[slot] && !cio_vm_internal_sample_equal(&stacks[slots[slot] - 1], stack)) slot = (slot + 1) & (slots_length - 1);
+
+        if(slots[slot]) ++stacks[slots[slot] - 1].count;
+        else slots[slot] = ++stacks_length;
+    }
+
+    // The samples are consumed once symbolised
+    __atomic_store_n(&sampler->tail, head, __ATOMIC_RELEASE);
+
+    gen_size_t folded_capacity = 0;
+
+    // Frames are named `identifier@module` as in `cio_vm_emit_profile` - each line is a call stack from the outermost frame followed by the number of samples of it
+    for(gen_size_t i = 0; i < stacks_length; ++i) {
+        const cio_vm_internal_sampled_stack_t* const stack = &stacks[i];
+
+        if(stack->truncated) CIO_VM_INTERNAL_SAMPLE_APPEND("[truncated]%t", stack->depth ? ";" : "");
+        else if(!stack->depth) CIO_VM_INTERNAL_SAMPLE_APPEND("[native]");
+
+        for(gen_size_t j = stack->depth; j; --j) {
+            const char* const separator = j == 1 ? "" : ";";
+            if(stack->callables[j - 1] == GEN_SIZE_MAX) CIO_VM_INTERNAL_SAMPLE_APPEND("[external]@%uz%t", stack->bytecode_indices[j - 1], separator);
+            else CIO_VM_INTERNAL_SAMPLE_APPEND("%t@%uz%t", vm->callables[stack->callables[j - 1]].identifier, stack->bytecode_indices[j - 1], separator);
+        }
+
+        CIO_VM_INTERNAL_SAMPLE_APPEND(" %uz\n", stack->count);
+    }
+
+    return GEN_NULL;
+}
+
+#undef CIO_VM_INTERNAL_SAMPLE_APPEND
@@ -5,6 +5,161 @@
 
 #include <genmemory.h>
 
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+// The source is classified this many bytes at a time, one bit per byte
+#define CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH 64
+
+// Token storage is grown geometrically from an estimate based on the source length
+#define CIO_TOKENIZE_INTERNAL_CAPACITY_MIN 64
+#define CIO_TOKENIZE_INTERNAL_BYTES_PER_TOKEN 6
+
+#define CIO_TOKENIZE_INTERNAL_IS_WHITESPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\0' || (c) == '\r')
+#define CIO_TOKENIZE_INTERNAL_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+typedef struct {
+    const char* source;
+    gen_size_t source_length;
+
+    // The index of the block whose masks are currently held
+    gen_size_t block;
+    // Bit `n` is set where byte `n` of the block is whitespace or lies past the end of the source
+    gen_uint64_t whitespace;
+    // Bit `n` is set where byte `n` of the block is a decimal digit
+    gen_uint64_t digits;
+
+    // Set where the source continues past `source_length`, leaving tokens which reach it unscanned
+    gen_bool_t partial;
+} cio_tokenize_internal_scanner_t;
+
+static void cio_tokenize_internal_classify(cio_tokenize_internal_scanner_t* const restrict scanner, const gen_size_t block) {
+    const gen_size_t start = block * CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH;
+    const char* const restrict bytes = &scanner->source[start];
+
+    scanner->block = block;
+    scanner->whitespace = 0;
+    scanner->digits = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    if(start + CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH <= scanner->source_length) {
+#if defined(__AVX2__)
+        for(gen_size_t i = 0; i < CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH; i += 32) {
+            const __m256i chunk = _mm256_loadu_si256((const __m256i*) &bytes[i]);
+
+            __m256i whitespace = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+            whitespace = _mm256_or_si256(whitespace, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t')));
+            whitespace = _mm256_or_si256(whitespace, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+            whitespace = _mm256_or_si256(whitespace, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')));
+            whitespace = _mm256_or_si256(whitespace, _mm256_cmpeq_epi8(chunk, _mm256_setzero_si256()));
+
+            // Bytes below '0' wrap around, so a saturating subtract leaves zero exactly for '0' through '9'
+            const __m256i above = _mm256_subs_epu8(_mm256_sub_epi8(chunk, _mm256_set1_epi8('0')), _mm256_set1_epi8(9));
+            const __m256i digits = _mm256_cmpeq_epi8(above, _mm256_setzero_si256());
+
+            scanner->whitespace |= (gen_uint64_t) (gen_uint32_t) _mm256_movemask_epi8(whitespace) << i;
+            scanner->digits |= (gen_uint64_t) (gen_uint32_t) _mm256_movemask_epi8(digits) << i;
+        }
+#else
+        for(gen_size_t i = 0; i < CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH; i += 16) {
+            const __m128i chunk = _mm_loadu_si128((const __m128i*) &bytes[i]);
+
+            __m128i whitespace = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+            whitespace = _mm_or_si128(whitespace, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+            whitespace = _mm_or_si128(whitespace, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+            whitespace = _mm_or_si128(whitespace, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+            whitespace = _mm_or_si128(whitespace, _mm_cmpeq_epi8(chunk, _mm_setzero_si128()));
+
+            // Bytes below '0' wrap around, so a saturating subtract leaves zero exactly for '0' through '9'
+            const __m128i above = _mm_subs_epu8(_mm_sub_epi8(chunk, _mm_set1_epi8('0')), _mm_set1_epi8(9));
+            const __m128i digits = _mm_cmpeq_epi8(above, _mm_setzero_si128());
+
+            scanner->whitespace |= (gen_uint64_t) (gen_uint32_t) _mm_movemask_epi8(whitespace) << i;
+            scanner->digits |= (gen_uint64_t) (gen_uint32_t) _mm_movemask_epi8(digits) << i;
+        }
+#endif
+        return;
+    }
+#endif
+
+    for(gen_size_t i = 0; i < CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH; ++i) {
+        if(start + i >= scanner->source_length) {
+            scanner->whitespace |= (gen_uint64_t) 1 << i;
+            continue;
+        }
+
+        if(CIO_TOKENIZE_INTERNAL_IS_WHITESPACE(bytes[i])) scanner->whitespace |= (gen_uint64_t) 1 << i;
+        if(CIO_TOKENIZE_INTERNAL_IS_DIGIT(bytes[i])) scanner->digits |= (gen_uint64_t) 1 << i;
+    }
+}
+
+// Finds the first offset at or after `offset` whose bit in the selected mask is set, or the source length if there is none
+static inline gen_size_t cio_tokenize_internal_find(cio_tokenize_internal_scanner_t* const restrict scanner, gen_size_t offset, const gen_bool_t digits, const gen_bool_t invert) {
+    while(offset < scanner->source_length) {
+        const gen_size_t block = offset / CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH;
+        if(block != scanner->block) cio_tokenize_internal_classify(scanner, block);
+
+        gen_uint64_t mask = digits ? scanner->digits : scanner->whitespace;
+        if(invert) mask = ~mask;
+        mask &= ~(gen_uint64_t) 0 << (offset % CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH);
+
+        if(mask) {
+            const gen_size_t found = block * CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH + (gen_size_t) __builtin_ctzll(mask);
+            return found < scanner->source_length ? found : scanner->source_length;
+        }
+
+        offset = (block + 1) * CIO_TOKENIZE_INTERNAL_BLOCK_LENGTH;
+    }
+
+    return scanner->source_length;
+}
+
+// Scans the next token starting at `*offset`, returning `gen_false` once the source is exhausted
+static inline gen_bool_t cio_tokenize_internal_next(cio_tokenize_internal_scanner_t* const restrict scanner, gen_size_t* const restrict offset, cio_token_type_t* const restrict out_type, gen_size_t* const restrict out_offset, gen_size_t* const restrict out_length) {
+    const gen_size_t start = cio_tokenize_internal_find(scanner, *offset, gen_false, gen_true);
+    if(start >= scanner->source_length) {
+        *offset = start;
+        return gen_false;
+    }
+
+    const char c = scanner->source[start];
+    gen_size_t end = start + 1;
+    if(c == ':') {
+        *out_type = CIO_TOKEN_BLOCK;
+    }
+    else if(CIO_TOKENIZE_INTERNAL_IS_DIGIT(c)) {
+        *out_type = CIO_TOKEN_NUMBER;
+        end = cio_tokenize_internal_find(scanner, end, gen_true, gen_true);
+    }
+    else {
+        *out_type = CIO_TOKEN_IDENTIFIER;
+        // Identifiers run up to whitespace, so take in any `:` after their first character wherever they appear
+        end = cio_tokenize_internal_find(scanner, end, gen_false, gen_false);
+    }
+
+    if(end == scanner->source_length && scanner->partial && *out_type != CIO_TOKEN_BLOCK) {
+        *offset = start;
+        return gen_false;
+    }
+
+    *out_offset = start;
+    *out_length = end - start;
+    *offset = end;
+
+    return gen_true;
+}
+
+static gen_size_t cio_tokenize_internal_initial_capacity(const gen_size_t tokens_length, const gen_size_t source_length) {
+    const gen_size_t estimate = tokens_length + source_length / CIO_TOKENIZE_INTERNAL_BYTES_PER_TOKEN;
+    return estimate > CIO_TOKENIZE_INTERNAL_CAPACITY_MIN ? estimate : CIO_TOKENIZE_INTERNAL_CAPACITY_MIN;
+}
+
 static void cio_tokenize_internal_cleanup_tokens(cio_token_t** tokens) {
     if(!*tokens) return;
 
@@ -23,58 +178,95 @@ gen_error_t* cio_tokenize(const char* const restrict source, const gen_size_t so
 	if(!out_tokens) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_tokens` was `GEN_NULL`");
 	if(!out_tokens_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_tokens_length` was `GEN_NULL`");
 
-	gen_size_t offset = 0;
-	char c = source[offset];
-
     GEN_CLEANUP_FUNCTION(cio_tokenize_internal_cleanup_tokens) cio_token_t* tokens_cleanup = *out_tokens;
 
-	do {
-		if((c == ' ' || c == '\t' || c == '\n' || c == '\0' || c == '\r')) {
-            if(offset + 1 >= source_length) break;
-			(c = source[++offset]);
-			continue;
-		}
-
-		error = gen_memory_reallocate_zeroed((void**) out_tokens, *out_tokens_length, *out_tokens_length + 1, sizeof(cio_token_t));
-        if(error) return error;
-		++*out_tokens_length;
-		cio_token_t* const token = &(*out_tokens)[*out_tokens_length - 1];
-		token->offset = offset;
-
-		if(c == ':') {
-			token->type = CIO_TOKEN_BLOCK;
-			token->length = 1;
-            if(offset + 1 >= source_length) break;
-			(c = source[++offset]);
-			continue;
-		}
-		else if((c >= '0' && c <= '9')) {
-			token->type = CIO_TOKEN_NUMBER;
-			do {
-                if(offset + 1 >= source_length) {
-                    token->length = offset - token->offset;
-                    break;
-                }
-				(c = source[++offset]);
-			} while((c >= '0' && c <= '9'));
-			token->length = offset - token->offset;
-			continue;
-		}
-		else {
-			token->type = CIO_TOKEN_IDENTIFIER;
-			do {
-                if(offset + 1 >= source_length) {
-                    token->length = offset - token->offset;
-                    break;
-                }
-				(c = source[++offset]);
-			} while(!(c == ' ' || c == '\t' || c == '\n' || c == '\0' || c == '\r'));
-			token->length = offset - token->offset;
-			continue;
-		}
-	} while(offset < source_length);
+    const gen_size_t initial_length = *out_tokens_length;
+    gen_size_t capacity = initial_length;
+    cio_tokenize_internal_scanner_t scanner = {source, source_length, GEN_SIZE_MAX, 0, 0, gen_false};
+    gen_size_t offset = 0;
+    cio_token_type_t type = CIO_TOKEN_IDENTIFIER;
+    gen_size_t token_offset = 0;
+    gen_size_t token_length = 0;
+
+    while(cio_tokenize_internal_next(&scanner, &offset, &type, &token_offset, &token_length)) {
+        if(*out_tokens_length == capacity) {
+            const gen_size_t new_capacity = capacity == initial_length ? cio_tokenize_internal_initial_capacity(initial_length, source_length) : capacity * 2;
+            error = gen_memory_reallocate_zeroed((void**) out_tokens, capacity, new_capacity, sizeof(cio_token_t));
+            if(error) return error;
+            capacity = new_capacity;
+            tokens_cleanup = *out_tokens;
+        }
+
+        (*out_tokens)[(*out_tokens_length)++] = (cio_token_t) {type, token_offset, token_length};
+    }
+
+    tokens_cleanup = GEN_NULL;
+
+	return GEN_NULL;
+}
+
+static void cio_tokenize_internal_cleanup_packed_tokens(cio_packed_token_t** tokens) {
+    if(!*tokens) return;
+
+    gen_error_t* error = gen_memory_free((void**) tokens);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+gen_error_t* cio_tokenize_packed(const char* const restrict source, const gen_size_t source_length, cio_packed_token_t** const restrict out_tokens, gen_size_t* const restrict out_tokens_length) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_tokenize_packed, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!source) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`source` was `GEN_NULL`");
+	if(!out_tokens) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_tokens` was `GEN_NULL`");
+	if(!out_tokens_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_tokens_length` was `GEN_NULL`");
+
+    if(source_length > CIO_PACKED_TOKEN_OFFSET_MAX) return gen_error_attach_backtrace_formatted(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "Source length %uz exceeds maximum of %uz for packed tokens", source_length, (gen_size_t) CIO_PACKED_TOKEN_OFFSET_MAX);
+
+    GEN_CLEANUP_FUNCTION(cio_tokenize_internal_cleanup_packed_tokens) cio_packed_token_t* tokens_cleanup = *out_tokens;
+
+    const gen_size_t initial_length = *out_tokens_length;
+    gen_size_t capacity = initial_length;
+    cio_tokenize_internal_scanner_t scanner = {source, source_length, GEN_SIZE_MAX, 0, 0, gen_false};
+    gen_size_t offset = 0;
+    cio_token_type_t type = CIO_TOKEN_IDENTIFIER;
+    gen_size_t token_offset = 0;
+    gen_size_t token_length = 0;
+
+    while(cio_tokenize_internal_next(&scanner, &offset, &type, &token_offset, &token_length)) {
+        if(token_length > CIO_PACKED_TOKEN_LENGTH_MAX) return gen_error_attach_backtrace_formatted(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "Token at offset %uz of length %uz exceeds maximum of %uz for packed tokens", token_offset, token_length, (gen_size_t) CIO_PACKED_TOKEN_LENGTH_MAX);
+
+        if(*out_tokens_length == capacity) {
+            const gen_size_t new_capacity = capacity == initial_length ? cio_tokenize_internal_initial_capacity(initial_length, source_length) : capacity * 2;
+            error = gen_memory_reallocate_zeroed((void**) out_tokens, capacity, new_capacity, sizeof(cio_packed_token_t));
+            if(error) return error;
+            capacity = new_capacity;
+            tokens_cleanup = *out_tokens;
+        }
+
+        (*out_tokens)[(*out_tokens_length)++] = (cio_packed_token_t) {(gen_uint32_t) token_offset, (gen_uint32_t) token_length, (gen_uint32_t) type};
+    }
 
     tokens_cleanup = GEN_NULL;
 
 	return GEN_NULL;
 }
+
+// Tokenizes a window over part of a source from `*offset` until the window or `out_tokens` is exhausted
+// Unless `final` is set the source is taken to continue past the window, so a token reaching its end is left for the next window
+// `*offset` is left where tokenization should resume
+// Used by the streaming emitter
+extern void cio_tokenize_internal_window(const char* const restrict window, const gen_size_t window_length, const gen_bool_t final, gen_size_t* const restrict offset, cio_token_t* const restrict out_tokens, const gen_size_t tokens_capacity, gen_size_t* const restrict out_tokens_length);
+void cio_tokenize_internal_window(const char* const restrict window, const gen_size_t window_length, const gen_bool_t final, gen_size_t* const restrict offset, cio_token_t* const restrict out_tokens, const gen_size_t tokens_capacity, gen_size_t* const restrict out_tokens_length) {
+    cio_tokenize_internal_scanner_t scanner = {window, window_length, GEN_SIZE_MAX, 0, 0, !final};
+    cio_token_type_t type = CIO_TOKEN_IDENTIFIER;
+    gen_size_t token_offset = 0;
+    gen_size_t token_length = 0;
+
+    *out_tokens_length = 0;
+    while(*out_tokens_length < tokens_capacity && cio_tokenize_internal_next(&scanner, offset, &type, &token_offset, &token_length)) {
+        out_tokens[(*out_tokens_length)++] = (cio_token_t) {type, token_offset, token_length};
+    }
+}
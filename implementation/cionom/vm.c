@@ -9,6 +9,31 @@
 
 // TODO: Error checking on genlog calls in VM
 
+const cio_fault_t cio_fault_propagated = {GEN_ERROR_UNKNOWN, "Error raised through `cio_vm_t.fault`"};
+
+#if CIO_VM_STATS
+// Counters are updated unconditionally so as not to add branches to the interpreter
+#define CIO_VM_INTERNAL_COUNT(vm, field, amount) ((vm)->stats.field += (gen_size_t) (amount))
+#define CIO_VM_INTERNAL_PEAK(vm, field, value) ((vm)->stats.field = (value) > (vm)->stats.field ? (value) : (vm)->stats.field)
+#else
+#define CIO_VM_INTERNAL_COUNT(vm, field, amount) ((void) 0)
+#define CIO_VM_INTERNAL_PEAK(vm, field, value) ((void) 0)
+#endif
+
+// The sampler reads frames from a signal handler on the executing thread
+// So frames are only counted once written, and stop being counted before they are cleared
+#define CIO_VM_INTERNAL_PUBLISH_FRAMES(vm, count) \
+    do { \
+        __atomic_signal_fence(__ATOMIC_SEQ_CST); \
+        (vm)->frames_used += (count); \
+    } while(0)
+
+#define CIO_VM_INTERNAL_RETIRE_FRAME(vm) \
+    do { \
+        --(vm)->frames_used; \
+        __atomic_signal_fence(__ATOMIC_SEQ_CST); \
+    } while(0)
+
 gen_error_t* cio_vm_push_frame(cio_vm_t* const restrict vm) {
 	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_push_frame, GEN_FILE_NAME);
 	if(error) return error;
@@ -17,7 +42,9 @@ gen_error_t* cio_vm_push_frame(cio_vm_t* const restrict vm) {
 
 	if(vm->frames_used >= vm->frames_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "No unused frames available to push");
 	if(vm->frames_used) vm->frames[vm->frames_used].base = vm->frames[vm->frames_used - 1].base + vm->frames[vm->frames_used - 1].height;
-	++vm->frames_used;
+	vm->frames[vm->frames_used].bytecode_index = vm->current_bytecode;
+	CIO_VM_INTERNAL_PUBLISH_FRAMES(vm, 1);
+    CIO_VM_INTERNAL_PEAK(vm, peak_frame_depth, vm->frames_used);
 
 	return GEN_NULL;
 }
@@ -32,13 +59,17 @@ gen_error_t* cio_vm_pop_frame(cio_vm_t* const restrict vm) {
 
     cio_frame_t* frame = &vm->frames[vm->frames_used - 1];
 
-    error = gen_memory_set(&vm->stack[frame->base], frame->height * sizeof(gen_size_t), 0);
-	if(error) return error;
+    // Cells are otherwise zeroed by `cio_vm_push` as they are reused
+    if(vm->settings.scrub_stack) {
+        error = gen_memory_set(&vm->stack[frame->base], frame->height * sizeof(gen_size_t), 0);
+    	if(error) return error;
+    }
 
+	CIO_VM_INTERNAL_RETIRE_FRAME(vm);
     frame->base = 0;
     frame->height = 0;
     frame->execution_offset = 0;
-	--vm->frames_used;
+    frame->bytecode_index = 0;
 
 	return GEN_NULL;
 }
@@ -54,287 +85,928 @@ gen_error_t* cio_vm_push(cio_vm_t* const restrict vm) {
 		++vm->frames[vm->frames_used - 1].height;
 	else
 		return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "Stack overflow");
-	vm->stack[vm->frames[vm->frames_used - 1].base + vm->frames[vm->frames_used - 1].height - 1] = 0;
+
+    // Cells above the high-water mark have never been used and are still zeroed
+    const gen_size_t cell = vm->frames[vm->frames_used - 1].base + vm->frames[vm->frames_used - 1].height - 1;
+    if(cell < vm->stack_high_water) vm->stack[cell] = 0;
+    else vm->stack_high_water = cell + 1;
 
 	return GEN_NULL;
 }
 
-// We keep this externally resolvable to let
-// The tests check against it's function pointer.
+static gen_error_t* cio_vm_internal_dispatch_slot(cio_vm_t* const restrict vm, const gen_size_t slot, const gen_size_t argc);
 extern gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm);
-gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_execute_routine, GEN_FILE_NAME);
+extern gen_error_t* cio_vm_internal_jit_compile(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_jit_free(cio_image_t* const restrict image);
+extern gen_error_t* cio_vm_internal_file_map(const char* const restrict path, const unsigned char** const restrict out_file, gen_size_t* const restrict out_file_length);
+extern gen_error_t* cio_vm_internal_file_unmap(const unsigned char* const restrict file, const gen_size_t file_length);
+extern gen_uint64_t cio_internal_hash(const char* const restrict identifier, const gen_size_t length);
+extern gen_error_t* cio_vm_internal_coroutines_free(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_profile_initialize(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_profile_free(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_profile_enter(cio_vm_t* const restrict vm, const gen_size_t slot);
+extern gen_error_t* cio_vm_internal_profile_exit(cio_vm_t* const restrict vm);
+extern gen_error_t* cio_vm_internal_sampler_free(cio_vm_t* const restrict vm);
+extern gen_size_t cio_vm_internal_now(void);
+
+// Executes from the top frame until the frame at `entry_frame` returns
+// A `resumable` loop is the outermost for a coroutine, and leaves when it yields with the top frame's `execution_offset` at the instruction to resume from
+// Also used by the coroutine scheduler
+extern gen_error_t* cio_vm_internal_interpret(cio_vm_t* const restrict vm, const gen_size_t entry_frame, const gen_bool_t resumable);
+gen_error_t* cio_vm_internal_interpret(cio_vm_t* const restrict vm, const gen_size_t entry_frame, const gen_bool_t resumable) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_interpret, GEN_FILE_NAME);
 	if(error) return error;
 
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	cio_frame_t* frame = &vm->frames[vm->frames_used - 1];
+    const cio_bytecode_t* module = &vm->bytecode[vm->current_bytecode];
+    const cio_decoded_instruction_t* instruction = &module->decoded[frame->execution_offset];
 
-	cio_frame_t* const frame = &vm->frames[vm->frames_used - 1];
-#ifdef __ANALYZER
-    cio_instruction_t* instruction = calloc(1, sizeof(cio_instruction_t));
-#else
-	const cio_instruction_t* instruction = (const cio_instruction_t*) &vm->bytecode[vm->current_bytecode].bytecode[frame->execution_offset];
-#endif
+    // Frame state is kept in locals and only synchronized with the frame around calls
+    gen_size_t* const stack = vm->stack;
+    gen_size_t base = frame->base;
+    gen_size_t height = frame->height;
 
     if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Commencing execution in BC %uz @ %uz w/ frame %uz", vm->current_bytecode, frame->execution_offset, vm->frames_used - 1);
 
 	gen_size_t argc = 0;
     gen_bool_t elide_reserve_space = gen_false;
-	while(!(instruction->opcode == CIO_CALL && instruction->operand == CIO_OPERAND_MAX)) {
-        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Decoding %uc (%uc %uc) in BC %uz @ %uz", *(const gen_uint8_t*) instruction, instruction->opcode, instruction->operand, vm->current_bytecode, frame->execution_offset);
-		if(instruction->opcode == CIO_CALL) {
-            if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "call %uc (argc = %uz (effective argc = %uz), argc[0] = %uz)", instruction->operand, argc, argc - (1 * !elide_reserve_space), vm->stack[frame->base + frame->height - argc]);
-
-			// Callee takes ownership of lower stack items
-			// Subtract 1 for reserve space
-			frame->height -= argc - (1 * !elide_reserve_space);
-			error = cio_vm_dispatch_call(vm, instruction->operand, argc - (1 * !elide_reserve_space));
-            elide_reserve_space = gen_false;
-#ifdef __ANALYZER
-			if(error) {
-                free(instruction);
-                return error;
+
+    static const void* const dispatch_table[] = {
+        [CIO_DECODED_PUSH] = &&op_push,
+        [CIO_DECODED_EXTENSION] = &&op_extension,
+        [CIO_DECODED_CALL] = &&op_call,
+        [CIO_DECODED_RET] = &&op_ret,
+        [CIO_DECODED_TAIL_CALL] = &&op_tail_call,
+        [CIO_DECODED_TAIL_BRANCH] = &&op_tail_branch,
+        [CIO_DECODED_TAIL_BRANCH_SIGN] = &&op_tail_branch,
+        [CIO_DECODED_TAIL_CALLV] = &&op_tail_callv,
+        [CIO_DECODED_PUSH_CALL_1] = &&op_push_call_1,
+        [CIO_DECODED_PUSH_CALL_2] = &&op_push_call_2,
+        [CIO_DECODED_PUSH_CALL_3] = &&op_push_call_3,
+        [CIO_DECODED_PUSH_CALL_4] = &&op_push_call_4,
+        [CIO_DECODED_INTRINSIC_ADD] = &&op_intrinsic_add,
+        [CIO_DECODED_INTRINSIC_SUBTRACT] = &&op_intrinsic_subtract,
+        [CIO_DECODED_INTRINSIC_COPY] = &&op_intrinsic_copy,
+        [CIO_DECODED_INTRINSIC_COPY_VARIABLE] = &&op_intrinsic_copy_variable,
+        [CIO_DECODED_INTRINSIC_STORE_CHAR] = &&op_intrinsic_store_char,
+        [CIO_DECODED_INTRINSIC_BRANCH] = &&op_intrinsic_branch,
+        [CIO_DECODED_INTRINSIC_BRANCH_SIGN] = &&op_intrinsic_branch,
+        [CIO_DECODED_INTRINSIC_CALLV] = &&op_intrinsic_callv
+    };
+
+    // Pushes within the loop write their cells directly, so the high-water mark is raised whenever the stack shrinks or control leaves the loop
+#define CIO_VM_INTERNAL_MARK_HIGH_WATER() \
+    do { \
+        if(base + height > vm->stack_high_water) vm->stack_high_water = base + height; \
+    } while(0)
+
+    // State for replacing the current frame in tail position
+    gen_size_t tail_slot = 0;
+    gen_size_t tail_parameters = 0;
+    gen_size_t tail_argc = 0;
+
+#define CIO_VM_INTERNAL_DISPATCH() \
+    do { \
+        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Decoding %uc (%uc %uc) in BC %uz @ %uz", module->bytecode[instruction - module->decoded], (gen_uint8_t) (module->bytecode[instruction - module->decoded] >> 7), (gen_uint8_t) (module->bytecode[instruction - module->decoded] & CIO_OPERAND_MAX), vm->current_bytecode, (gen_size_t) (instruction - module->decoded)); \
+        CIO_VM_INTERNAL_COUNT(vm, instructions, 1); \
+        goto *dispatch_table[instruction->opcode]; \
+    } while(0)
+
+    CIO_VM_INTERNAL_DISPATCH();
+
+    op_extension: {
+        if(!height) goto op_push;
+
+        if(vm->debug_prints) {
+            gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "push %uc", instruction->operand);
+            gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Processing extension ID %uc", stack[base + height - 1]);
+        }
+
+        switch(stack[base + height - 1]) {
+            case CIO_EXTENSION_ID_ELIDE_RESERVE_SPACE: {
+                // vm->bytecode[vm->current_bytecode].extension_settings.elide_reserve_space
+                elide_reserve_space = gen_true;
+                break;
             }
-#else
-			if(error) return error;
-#endif
+            case CIO_EXTENSION_ID_BREAKPOINTS: {
+                // TODO: Implement breakpoints
+                break;
+            }
+            default: {
+                return gen_error_attach_backtrace_formatted(GEN_ERROR_BAD_CONTENT, GEN_LINE_NUMBER, "Extension ID %uc is unrecognized in bytecode %uz @ %uz", stack[base + height - 1], vm->current_bytecode, (gen_size_t) (instruction - module->decoded));
+            }
+        }
 
-            if(vm->debug_prints) gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "Call returned successfully");
+        CIO_VM_INTERNAL_COUNT(vm, extension_markers, 1);
+        CIO_VM_INTERNAL_MARK_HIGH_WATER();
+        --height; // Remove extension ID
+        argc = 0;
+        ++instruction;
+        CIO_VM_INTERNAL_DISPATCH();
+    }
 
-			argc = 0;
-		}
-		else {
-			if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "push %uc", instruction->operand);
+    op_push: {
+        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "push %uc", instruction->operand);
 
-            if(instruction->operand == CIO_OPERAND_MAX && frame->height) {
-    			if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Processing extension ID %uc", vm->stack[frame->base + frame->height - 1]);
+        if(instruction->operand == CIO_OPERAND_MAX && vm->warning_settings->consume_reserved_encoding) {
+            // TODO: Add source info/disassembly here once debugging "stuff" is implemented
 
-                switch(vm->stack[frame->base + frame->height - 1]) {
-                    case CIO_EXTENSION_ID_ELIDE_RESERVE_SPACE: {
-                        // vm->bytecode[vm->current_bytecode].extension_settings.elide_reserve_space
-                        elide_reserve_space = gen_true;
-                        break;
-                    }
-                    case CIO_EXTENSION_ID_BREAKPOINTS: {
-                        // TODO: Implement breakpoints
-                        break;
-                    }
-                    default: {
-                        return gen_error_attach_backtrace_formatted(GEN_ERROR_BAD_CONTENT, GEN_LINE_NUMBER, "Extension ID %uc is unrecognized in bytecode %uz @ %uz", vm->stack[frame->base + frame->height - 1], vm->current_bytecode, frame->execution_offset);
-                    }
-                }
-    
-                frame->height--; // Remove extension ID
-                argc = 0;
-#ifdef __ANALYZER
-#else
-        		instruction = (const cio_instruction_t*) &vm->bytecode[vm->current_bytecode].bytecode[++frame->execution_offset];
-#endif
-                continue;
-           }
+            error = gen_log_formatted(vm->warning_settings->fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom", "Encoding `push 0x7F` is reserved [%tconsume_reserved_encoding]", vm->warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+            if(error) return error;
+
+            if(vm->warning_settings->fatal_warnings) {
+                return gen_error_attach_backtrace_formatted(GEN_ERROR_IN_USE, GEN_LINE_NUMBER, "Encoding `push 0x7F` is reserved [%tconsume_reserved_encoding]", vm->warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+            }
+        }
+
+        if(base + height >= vm->stack_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "Stack overflow");
+        stack[base + height++] = instruction->operand;
+        CIO_VM_INTERNAL_COUNT(vm, pushes, 1);
+        ++argc;
+        ++instruction;
+        CIO_VM_INTERNAL_DISPATCH();
+    }
+
+    // Runs of pushes ending in a call are pushed in one go, then the call is made without being dispatched separately
+    // The call keeps whatever opcode the loader decorated it with, so it is made by that opcode's handler
+    // The remaining pushes in the run are still decoded individually, so falling back to `op_push` is always valid
+#define CIO_VM_INTERNAL_PUSH_CALL(count) \
+    do { \
+        if(vm->debug_prints || base + height + (count) > vm->stack_length) goto op_push; \
+        for(gen_size_t i = 0; i < (count); ++i) stack[base + height + i] = instruction[i].operand; \
+        height += (count); \
+        argc += (count); \
+        CIO_VM_INTERNAL_COUNT(vm, pushes, count); \
+        CIO_VM_INTERNAL_COUNT(vm, instructions, count); \
+        instruction += (count); \
+        goto *dispatch_table[instruction->opcode]; \
+    } while(0)
+
+    op_push_call_1: CIO_VM_INTERNAL_PUSH_CALL(1);
+    op_push_call_2: CIO_VM_INTERNAL_PUSH_CALL(2);
+    op_push_call_3: CIO_VM_INTERNAL_PUSH_CALL(3);
+    op_push_call_4: CIO_VM_INTERNAL_PUSH_CALL(4);
+
+#undef CIO_VM_INTERNAL_PUSH_CALL
+
+    // Intrinsics operate on the stack exactly as their native implementations would
+    // `caller` and `current` refer to the same cells as in the native routine, and the callee's cells are released as a frame pop would
+    // Anything which would make the native call fail (or log) goes through `op_call` instead
+#define CIO_VM_INTERNAL_INTRINSIC(operation) \
+    do { \
+        if(vm->debug_prints || vm->frames_used >= vm->frames_length) goto op_call; \
+        const gen_size_t callee_argc = argc - (1 * !elide_reserve_space); \
+        CIO_VM_INTERNAL_COUNT(vm, external_calls, 1); \
+        CIO_VM_INTERNAL_COUNT(vm, cross_module_calls, vm->dispatch[instruction->operand].bytecode_index != vm->current_bytecode); \
+        CIO_VM_INTERNAL_MARK_HIGH_WATER(); \
+        height -= callee_argc; \
+        gen_size_t* const caller = &stack[base]; \
+        const gen_size_t* const current = &stack[base + height]; \
+        operation; \
+        if(vm->settings.scrub_stack) { \
+            error = gen_memory_set(&stack[base + height], callee_argc * sizeof(gen_size_t), 0); \
+            if(error) return error; \
+        } \
+        elide_reserve_space = gen_false; \
+        argc = 0; \
+        ++instruction; \
+        CIO_VM_INTERNAL_DISPATCH(); \
+    } while(0)
+
+    op_intrinsic_add: CIO_VM_INTERNAL_INTRINSIC(caller[height - 1] = caller[current[0]] + caller[current[1]]);
+    op_intrinsic_subtract: CIO_VM_INTERNAL_INTRINSIC(caller[height - 1] = caller[current[0]] - caller[current[1]]);
+    op_intrinsic_copy: CIO_VM_INTERNAL_INTRINSIC(caller[current[0]] = current[1]);
+    op_intrinsic_copy_variable: CIO_VM_INTERNAL_INTRINSIC(caller[current[0]] = caller[current[1]]);
+    op_intrinsic_store_char: CIO_VM_INTERNAL_INTRINSIC(((char*) caller[current[0]])[current[1]] = (char) current[2]);
+
+#undef CIO_VM_INTERNAL_INTRINSIC
+
+    op_intrinsic_branch: {
+        // Branches made natively run in a nested interpreter, so are only decoded when trampolining
+        // The frame `?`/`?+-` would have had is kept beneath the routine branched to so it sees the same frames
+        if(!vm->settings.trampoline || vm->frames_used + 1 >= vm->frames_length) goto op_call;
+
+        const gen_size_t callee_argc = argc - (1 * !elide_reserve_space);
+        const gen_size_t* const current = &stack[base + height - callee_argc];
+        const gen_size_t condition = stack[base + current[2]];
+        const gen_bool_t sign = instruction->opcode == CIO_DECODED_INTRINSIC_BRANCH_SIGN || instruction->opcode == CIO_DECODED_TAIL_BRANCH_SIGN;
+        const gen_bool_t taken = sign ? (gen_ssize_t) condition >= 0 : condition != 0;
+        if((taken ? current[0] : current[1]) >= module->callables_length) goto op_call;
+
+        const gen_size_t slot = module->callables_offset + (taken ? current[0] : current[1]);
+        const cio_dispatch_t* const target = &vm->dispatch[slot];
+        if(target->function != cio_vm_internal_execute_routine) goto op_call;
+
+        CIO_VM_INTERNAL_MARK_HIGH_WATER();
+
+        frame->height = height - callee_argc;
+        frame->execution_offset = (gen_size_t) (instruction - module->decoded);
+
+        cio_frame_t* const branch = &vm->frames[vm->frames_used];
+        branch->base = base + frame->height;
+        branch->height = callee_argc;
+        branch->execution_offset = CIO_FRAME_BRANCH;
+        branch->bytecode_index = vm->current_bytecode;
+
+        cio_frame_t* const callee = &vm->frames[vm->frames_used + 1];
+        callee->base = branch->base + branch->height;
+        callee->height = 0;
+        callee->execution_offset = target->offset;
+        callee->bytecode_index = target->bytecode_index;
+        CIO_VM_INTERNAL_PUBLISH_FRAMES(vm, 2);
+
+        // The branch routine and the routine it branches to are both counted
+        CIO_VM_INTERNAL_COUNT(vm, external_calls, 1);
+        CIO_VM_INTERNAL_COUNT(vm, cionom_calls, 1);
+        CIO_VM_INTERNAL_COUNT(vm, cross_module_calls, target->bytecode_index != vm->current_bytecode);
+        CIO_VM_INTERNAL_PEAK(vm, peak_frame_depth, vm->frames_used);
+        vm->current_bytecode = target->bytecode_index;
+
+        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Branching to cionom routine %t in BC %uz @ %uz", vm->callables[slot].identifier, vm->current_bytecode, callee->execution_offset);
+
+        // Both calls are in progress until the routine branched to returns
+        if(vm->profile) {
+            error = cio_vm_internal_profile_enter(vm, instruction->operand);
+            if(error) return error;
+            error = cio_vm_internal_profile_enter(vm, slot);
+            if(error) return error;
+        }
+
+        frame = callee;
+        module = &vm->bytecode[vm->current_bytecode];
+        instruction = target->code;
+        base = frame->base;
+        height = 0;
+        elide_reserve_space = gen_false;
+        argc = 0;
+        CIO_VM_INTERNAL_DISPATCH();
+    }
+
+    op_intrinsic_callv: {
+        // As with branches, `callv` is only decoded when trampolining
+        // `callv` is transparent - the routine called takes the place of its frame, with the routine index dropped from the parameters
+        const gen_size_t callee_argc = argc - (1 * !elide_reserve_space);
+        if(!vm->settings.trampoline || !callee_argc || vm->frames_used >= vm->frames_length) goto op_call;
+
+        const gen_size_t* const current = &stack[base + height - callee_argc];
+        if(stack[base + current[0]] >= module->callables_length) goto op_call;
+
+        const gen_size_t slot = module->callables_offset + stack[base + current[0]];
+        const cio_dispatch_t* const target = &vm->dispatch[slot];
+        if(target->function != cio_vm_internal_execute_routine) goto op_call;
+
+        CIO_VM_INTERNAL_MARK_HIGH_WATER();
+
+        frame->height = height - callee_argc;
+        frame->execution_offset = (gen_size_t) (instruction - module->decoded);
+
+        // Move the parameters down over the routine index
+        const gen_size_t parameters = base + frame->height;
+        for(gen_size_t i = 0; i + 1 < callee_argc; ++i) stack[parameters + i] = stack[parameters + i + 1];
+        if(vm->settings.scrub_stack) stack[parameters + callee_argc - 1] = 0;
+
+        cio_frame_t* const callee = &vm->frames[vm->frames_used];
+        callee->base = parameters;
+        callee->height = callee_argc - 1;
+        callee->execution_offset = target->offset;
+        callee->bytecode_index = target->bytecode_index;
+        CIO_VM_INTERNAL_PUBLISH_FRAMES(vm, 1);
+
+        // `callv` and the routine it calls are both counted
+        CIO_VM_INTERNAL_COUNT(vm, external_calls, 1);
+        CIO_VM_INTERNAL_COUNT(vm, cionom_calls, 1);
+        CIO_VM_INTERNAL_COUNT(vm, cross_module_calls, target->bytecode_index != vm->current_bytecode);
+        CIO_VM_INTERNAL_PEAK(vm, peak_frame_depth, vm->frames_used);
+        vm->current_bytecode = target->bytecode_index;
+
+        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Calling cionom routine %t through `callv` in BC %uz @ %uz", vm->callables[slot].identifier, vm->current_bytecode, callee->execution_offset);
+
+        // `callv` has no frame of its own to return through, so its call ends where the routine's begins as a tail call's would
+        if(vm->profile) {
+            error = cio_vm_internal_profile_enter(vm, instruction->operand);
+            if(error) return error;
+            error = cio_vm_internal_profile_exit(vm);
+            if(error) return error;
+            error = cio_vm_internal_profile_enter(vm, slot);
+            if(error) return error;
+        }
+
+        frame = callee;
+        module = &vm->bytecode[vm->current_bytecode];
+        instruction = target->code;
+        base = frame->base;
+        height = frame->height;
+        elide_reserve_space = gen_false;
+        argc = 0;
+        CIO_VM_INTERNAL_DISPATCH();
+    }
+
+    op_call: {
+        // Subtract 1 for reserve space
+        const gen_size_t callee_argc = argc - (1 * !elide_reserve_space);
+
+        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "call %uc (argc = %uz (effective argc = %uz), argc[0] = %uz)", (gen_uint8_t) (module->bytecode[instruction - module->decoded] & CIO_OPERAND_MAX), argc, callee_argc, stack[base + height - argc]);
 
-            if(instruction->operand == CIO_OPERAND_MAX && vm->warning_settings->consume_reserved_encoding) {
-                // TODO: Add source info/disassembly here once debugging "stuff" is implemented
+        // Call sites are decoded to slots in `vm->dispatch`, out-of-range indices decode past its end
+        if(instruction->operand >= vm->callables_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_BOUNDS, GEN_LINE_NUMBER, "`callable` was greater than the current module's callables length");
 
-                error = gen_log_formatted(vm->warning_settings->fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom", "Encoding `push 0x7F` is reserved [%tconsume_reserved_encoding]", vm->warning_settings->fatal_warnings ? "fatal_warnings, " : "");
+        CIO_VM_INTERNAL_MARK_HIGH_WATER();
+
+        // Callee takes ownership of lower stack items
+        frame->height = height - callee_argc;
+        frame->execution_offset = (gen_size_t) (instruction - module->decoded);
+
+        const cio_dispatch_t* const target = &vm->dispatch[instruction->operand];
+        if(vm->settings.trampoline && target->function == cio_vm_internal_execute_routine) {
+            if(vm->frames_used >= vm->frames_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "No unused frames available to push");
+
+            cio_frame_t* const callee = &vm->frames[vm->frames_used];
+            callee->base = base + frame->height;
+            callee->height = callee_argc;
+            callee->execution_offset = target->offset;
+            callee->bytecode_index = target->bytecode_index;
+            CIO_VM_INTERNAL_PUBLISH_FRAMES(vm, 1);
+
+            CIO_VM_INTERNAL_COUNT(vm, cionom_calls, 1);
+            CIO_VM_INTERNAL_COUNT(vm, cross_module_calls, target->bytecode_index != vm->current_bytecode);
+            CIO_VM_INTERNAL_PEAK(vm, peak_frame_depth, vm->frames_used);
+            vm->current_bytecode = target->bytecode_index;
+
+            if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Calling cionom routine %t in BC %uz @ %uz", vm->callables[instruction->operand].identifier, vm->current_bytecode, callee->execution_offset);
+
+            if(vm->profile) {
+                error = cio_vm_internal_profile_enter(vm, instruction->operand);
                 if(error) return error;
+            }
 
-                if(vm->warning_settings->fatal_warnings) {
-                    return gen_error_attach_backtrace_formatted(GEN_ERROR_IN_USE, GEN_LINE_NUMBER, "Encoding `push 0x7F` is reserved [%tconsume_reserved_encoding]", vm->warning_settings->fatal_warnings ? "fatal_warnings, " : "");
-                }
+            frame = callee;
+            module = &vm->bytecode[vm->current_bytecode];
+            instruction = target->code;
+            base = frame->base;
+            height = frame->height;
+            elide_reserve_space = gen_false;
+            argc = 0;
+            CIO_VM_INTERNAL_DISPATCH();
+        }
+
+        if(target->fast && !vm->debug_prints && !vm->profile) {
+            // The fast calling convention skips the wrapper and its frame lookups
+            if(vm->frames_used >= vm->frames_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "No unused frames available to push");
+
+            cio_frame_t* const callee = &vm->frames[vm->frames_used];
+            callee->base = base + frame->height;
+            callee->height = callee_argc;
+            callee->execution_offset = target->offset;
+            callee->bytecode_index = target->bytecode_index;
+            CIO_VM_INTERNAL_PUBLISH_FRAMES(vm, 1);
+
+            CIO_VM_INTERNAL_COUNT(vm, external_calls, 1);
+            CIO_VM_INTERNAL_COUNT(vm, cross_module_calls, target->bytecode_index != vm->current_bytecode);
+            CIO_VM_INTERNAL_PEAK(vm, peak_frame_depth, vm->frames_used);
+            vm->current_bytecode = target->bytecode_index;
+
+            // A fault handled by the wrapper resumes the caller as if the routine had returned
+            const cio_status_t status = target->fast(vm, &stack[callee->base], &stack[base], frame);
+            if(status) {
+                error = cio_vm_raise_status(vm, status);
+                if(error) return error;
             }
 
-			error = cio_vm_push(vm);
-#ifdef __ANALYZER
-			if(error) {
-                free(instruction);
-                return error;
+            // The routine may have replaced its own frame (e.g. `callv`)
+            cio_frame_t* const top = &vm->frames[vm->frames_used - 1];
+            if(vm->settings.scrub_stack) {
+                error = gen_memory_set(&stack[top->base], top->height * sizeof(gen_size_t), 0);
+                if(error) return error;
             }
-#else
-			if(error) return error;
-#endif
-			vm->stack[frame->base + frame->height - 1] = instruction->operand;
-			++argc;
-		}
+            CIO_VM_INTERNAL_RETIRE_FRAME(vm);
+            *top = (cio_frame_t) {0};
+            vm->current_bytecode = frame->bytecode_index;
+        }
+        else {
+            error = cio_vm_internal_dispatch_slot(vm, instruction->operand, callee_argc);
+            if(error) return error;
+        }
 
-#ifdef __ANALYZER
-#else
-		instruction = (const cio_instruction_t*) &vm->bytecode[vm->current_bytecode].bytecode[++frame->execution_offset];
-#endif
-	}
+        if(vm->debug_prints) gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "Call returned successfully");
 
-#ifdef __ANALYZER
-    free(instruction);
-#endif
+        if(vm->yield_requested) {
+            // Coroutines are suspended with their C stack unwound, so may only yield back to the loop they were resumed in
+            if(!resumable) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "`yield` was called from a routine called natively within a coroutine");
+
+            if(vm->debug_prints) gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "Coroutine yielded");
+
+            frame->execution_offset = (gen_size_t) (instruction + 1 - module->decoded);
+            return GEN_NULL;
+        }
 
-    if(vm->debug_prints) {
-        gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Decoding %uc (%uc %uc) in BC %uz @ %uz", *(gen_uint8_t*) &instruction, instruction->opcode, instruction->operand, vm->current_bytecode, frame->execution_offset);
-        gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "ret");
+        height = frame->height;
+        elide_reserve_space = gen_false;
+        argc = 0;
+        ++instruction;
+        CIO_VM_INTERNAL_DISPATCH();
     }
 
-	return GEN_NULL;
+    op_tail_call: {
+        const gen_size_t callee_argc = argc - (1 * !elide_reserve_space);
+        if(instruction->operand >= vm->callables_length) goto op_call;
+
+        tail_slot = instruction->operand;
+        tail_parameters = height - callee_argc;
+        tail_argc = callee_argc;
+        goto tail_call;
+    }
+
+    op_tail_branch: {
+        // Evaluate the branch as `?`/`?+-` would to find the routine being branched to
+        const gen_size_t callee_argc = argc - (1 * !elide_reserve_space);
+        const gen_size_t* const current = &stack[base + height - callee_argc];
+        const gen_size_t condition = stack[base + current[2]];
+        const gen_bool_t taken = instruction->opcode == CIO_DECODED_TAIL_BRANCH ? condition != 0 : (gen_ssize_t) condition >= 0;
+        if((taken ? current[0] : current[1]) >= module->callables_length) goto op_call;
+
+        tail_slot = module->callables_offset + (taken ? current[0] : current[1]);
+        tail_parameters = 0;
+        tail_argc = 0;
+        goto tail_call;
+    }
+
+    op_tail_callv: {
+        const gen_size_t callee_argc = argc - (1 * !elide_reserve_space);
+        if(!callee_argc) goto op_call;
+
+        const gen_size_t* const current = &stack[base + height - callee_argc];
+        if(stack[base + current[0]] >= module->callables_length) goto op_call;
+
+        tail_slot = module->callables_offset + stack[base + current[0]];
+        tail_parameters = height - callee_argc + 1;
+        tail_argc = callee_argc - 1;
+        goto tail_call;
+    }
+
+    tail_call: {
+        // Calls which do not resolve to Cíonom routines, or to ones which read the frame being replaced, are dispatched as normal
+        const cio_dispatch_t* const target = &vm->dispatch[tail_slot];
+        if(target->function != cio_vm_internal_execute_routine || target->observes_caller) {
+            if(instruction->opcode == CIO_DECODED_TAIL_CALLV) goto op_intrinsic_callv;
+            if(instruction->opcode != CIO_DECODED_TAIL_CALL) goto op_intrinsic_branch;
+            goto op_call;
+        }
+
+        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Tail calling cionom routine %t in BC %uz @ %uz", vm->callables[tail_slot].identifier, (gen_size_t) target->bytecode_index, (gen_size_t) target->offset);
+
+        CIO_VM_INTERNAL_MARK_HIGH_WATER();
+
+        // The replaced routine's call ends where the tail call's begins
+        if(vm->profile) {
+            error = cio_vm_internal_profile_exit(vm);
+            if(error) return error;
+            error = cio_vm_internal_profile_enter(vm, tail_slot);
+            if(error) return error;
+        }
+
+        // Move the parameters down to replace the current frame's contents
+        for(gen_size_t i = 0; i < tail_argc; ++i) stack[base + i] = stack[base + tail_parameters + i];
+        if(vm->settings.scrub_stack && height > tail_argc) {
+            error = gen_memory_set(&stack[base + tail_argc], (height - tail_argc) * sizeof(gen_size_t), 0);
+            if(error) return error;
+        }
+
+        frame->height = tail_argc;
+        frame->execution_offset = target->offset;
+        frame->bytecode_index = target->bytecode_index;
+
+        CIO_VM_INTERNAL_COUNT(vm, cionom_calls, 1);
+        CIO_VM_INTERNAL_COUNT(vm, cross_module_calls, target->bytecode_index != vm->current_bytecode);
+        vm->current_bytecode = target->bytecode_index;
+
+        module = &vm->bytecode[vm->current_bytecode];
+        instruction = target->code;
+        height = tail_argc;
+        elide_reserve_space = gen_false;
+        argc = 0;
+        CIO_VM_INTERNAL_DISPATCH();
+    }
+
+    op_ret: {
+        CIO_VM_INTERNAL_MARK_HIGH_WATER();
+        frame->height = height;
+        frame->execution_offset = (gen_size_t) (instruction - module->decoded);
+
+        if(vm->debug_prints) gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "ret");
+
+        if(vm->frames_used - 1 == entry_frame) return GEN_NULL;
+
+        if(vm->profile) {
+            error = cio_vm_internal_profile_exit(vm);
+            if(error) return error;
+        }
+
+        // Pop the callee and resume the caller after its call
+        if(vm->settings.scrub_stack) {
+            error = gen_memory_set(&stack[base], height * sizeof(gen_size_t), 0);
+            if(error) return error;
+        }
+        CIO_VM_INTERNAL_RETIRE_FRAME(vm);
+        *frame = (cio_frame_t) {0};
+
+        // Returning from an inline branch also pops the frame of the branch routine
+        frame = &vm->frames[vm->frames_used - 1];
+        if(frame->execution_offset == CIO_FRAME_BRANCH) {
+            if(vm->profile) {
+                error = cio_vm_internal_profile_exit(vm);
+                if(error) return error;
+            }
+
+            if(vm->settings.scrub_stack) {
+                error = gen_memory_set(&stack[frame->base], frame->height * sizeof(gen_size_t), 0);
+                if(error) return error;
+            }
+            CIO_VM_INTERNAL_RETIRE_FRAME(vm);
+            *frame = (cio_frame_t) {0};
+
+            frame = &vm->frames[vm->frames_used - 1];
+        }
+
+        vm->current_bytecode = frame->bytecode_index;
+        module = &vm->bytecode[vm->current_bytecode];
+        instruction = &module->decoded[frame->execution_offset + 1];
+        base = frame->base;
+        height = frame->height;
+
+        if(vm->debug_prints) gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "Call returned successfully");
+
+        elide_reserve_space = gen_false;
+        argc = 0;
+        CIO_VM_INTERNAL_DISPATCH();
+    }
+
+#undef CIO_VM_INTERNAL_MARK_HIGH_WATER
+#undef CIO_VM_INTERNAL_DISPATCH
 }
 
-gen_error_t* cio_vm_dispatch_callable(cio_vm_t* const restrict vm, const cio_callable_t* callable, const gen_size_t argc) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_dispatch_callable, GEN_FILE_NAME);
+// We keep this externally resolvable to let
+// The tests check against it's function pointer.
+extern gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm);
+gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_execute_routine, GEN_FILE_NAME);
 	if(error) return error;
 
 	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
 
-    error = cio_vm_push_frame(vm);
-    if(error) return error;
+    // Returning from this frame leaves the loop when trampolining
+    return cio_vm_internal_interpret(vm, vm->frames_used - 1, gen_false);
+}
 
-	// Construct call
-    gen_size_t callable_remote_index = callable->routine_index;
-	vm->frames[vm->frames_used - 1].height = argc;
-	vm->frames[vm->frames_used - 1].execution_offset = callable->offset;
-    gen_size_t old_bytecode = vm->current_bytecode;
-    vm->current_bytecode = callable->bytecode_index;
+static gen_error_t* cio_vm_internal_dispatch_slot(cio_vm_t* const restrict vm, const gen_size_t slot, const gen_size_t argc) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_dispatch_slot, GEN_FILE_NAME);
+	if(error) return error;
 
-    if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Calling %t routine %t %uz (@%p) in BC %uz @ %uz", vm->bytecode[vm->current_bytecode].callables[callable_remote_index].function == cio_vm_internal_execute_routine ? "cionom" : "external", callable->identifier, callable_remote_index, (void*) vm->bytecode[vm->current_bytecode].callables[callable_remote_index].function, vm->current_bytecode, vm->frames[vm->frames_used - 1].execution_offset);
+    const cio_dispatch_t* const target = &vm->dispatch[slot];
 
-    if(callable_remote_index >= vm->bytecode[vm->current_bytecode].callables_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_BOUNDS, GEN_LINE_NUMBER, "The index of the callable in remote module was greater than the remote module's callables length");
+	// Construct call
+	if(vm->frames_used >= vm->frames_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_SPACE, GEN_LINE_NUMBER, "No unused frames available to push");
+    cio_frame_t* const frame = &vm->frames[vm->frames_used];
+	if(vm->frames_used) frame->base = vm->frames[vm->frames_used - 1].base + vm->frames[vm->frames_used - 1].height;
+	frame->height = argc;
+	frame->execution_offset = target->offset;
+	frame->bytecode_index = target->bytecode_index;
+	CIO_VM_INTERNAL_PUBLISH_FRAMES(vm, 1);
+
+    CIO_VM_INTERNAL_COUNT(vm, cionom_calls, target->function == cio_vm_internal_execute_routine);
+    CIO_VM_INTERNAL_COUNT(vm, external_calls, target->function != cio_vm_internal_execute_routine);
+    CIO_VM_INTERNAL_COUNT(vm, cross_module_calls, target->bytecode_index != vm->current_bytecode);
+    CIO_VM_INTERNAL_PEAK(vm, peak_frame_depth, vm->frames_used);
+    vm->current_bytecode = target->bytecode_index;
+
+    if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Calling %t routine %t %uz (@%p) in BC %uz @ %uz", target->function == cio_vm_internal_execute_routine ? "cionom" : "external", vm->callables[slot].identifier, slot - vm->bytecode[vm->current_bytecode].callables_offset, (void*) target->function, vm->current_bytecode, frame->execution_offset);
+
+    if(vm->profile) {
+        error = cio_vm_internal_profile_enter(vm, slot);
+        if(error) return error;
+    }
 
 	// Dispatch call
     if(vm->external_lib_call_wrapper) {
-        error = vm->external_lib_call_wrapper(vm, vm->bytecode[vm->current_bytecode].callables[callable_remote_index].function);
+        error = vm->external_lib_call_wrapper(vm, target->function);
         if(error) return error;
     }
     else {
-        error = vm->bytecode[vm->current_bytecode].callables[callable_remote_index].function(vm);
+        error = target->function(vm);
         if(error) return error;
     }
 
-    vm->current_bytecode = old_bytecode;
+    if(vm->profile) {
+        error = cio_vm_internal_profile_exit(vm);
+        if(error) return error;
+    }
 
 	error = cio_vm_pop_frame(vm);
     if(error) return error;
 
+    // Frames record the module they execute in so the caller's can be restored
+    if(vm->frames_used) vm->current_bytecode = vm->frames[vm->frames_used - 1].bytecode_index;
+
 	return GEN_NULL;
 }
 
-gen_error_t* cio_vm_dispatch_call(cio_vm_t* const restrict vm, const gen_size_t callable, const gen_size_t argc) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_dispatch_call, GEN_FILE_NAME);
+static gen_error_t* cio_vm_internal_raise_fault(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_raise_fault, GEN_FILE_NAME);
 	if(error) return error;
 
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-	if(callable >= vm->bytecode[vm->current_bytecode].callables_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_BOUNDS, GEN_LINE_NUMBER, "`callable` was greater than the current module's callables length");
-
-	return cio_vm_dispatch_callable(vm, &vm->bytecode[vm->current_bytecode].callables[callable], argc);
+    return vm->fault;
 }
 
-gen_error_t* cio_vm_get_identifier(cio_vm_t* const restrict vm, const char* identifier, cio_callable_t* restrict * const restrict out_callable, gen_bool_t vminit) {
-    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_get_identifier, GEN_FILE_NAME);
+gen_error_t* cio_vm_raise_status(cio_vm_t* const restrict vm, const cio_status_t status) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_raise_status, GEN_FILE_NAME);
 	if(error) return error;
 
 	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-	if(!identifier) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`identifier` was `GEN_NULL`");
-	if(!out_callable) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_callable` was `GEN_NULL`");
 
-    gen_size_t len = 0;
-    error = gen_string_length(identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &len);
-    if(error) return error;
+    error = cio_vm_status_error(vm, status);
+    if(!vm->external_lib_call_wrapper) return error;
 
-    // TODO: Generate & reference linear list of routine
-    //       Definitions (callables) at VM init instead
-    //       Of maintaining per-bytecode.
-    //       Also allows module-agnostic calls by the native
-    //       Application.
+    // Let the wrapper see the failure as if the routine had been called through it
+    vm->fault = error;
+    error = vm->external_lib_call_wrapper(vm, cio_vm_internal_raise_fault);
+    vm->fault = GEN_NULL;
 
-    // TODO: Maybe this should be a warning
-    if(vm->debug_prints) if(!vm->bytecode_length) gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "Executable bundle has no callables");
+    return error;
+}
 
-    cio_callable_t* extref = GEN_NULL;    
+// Calls from routines compiled by the JIT which they cannot make directly
+// Synchronizes the calling frame as `op_call` would before dispatching
+extern gen_error_t* cio_vm_internal_jit_call(cio_vm_t* const restrict vm, const gen_size_t height, const gen_size_t slot, const gen_size_t argc, const gen_size_t offset);
+gen_error_t* cio_vm_internal_jit_call(cio_vm_t* const restrict vm, const gen_size_t height, const gen_size_t slot, const gen_size_t argc, const gen_size_t offset) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_jit_call, GEN_FILE_NAME);
+	if(error) return error;
 
-    for(gen_size_t i = 0; i < vm->bytecode_length; ++i) {
-        // TODO: Maybe this should be a warning
-        if(vm->debug_prints) if(!vm->bytecode[i].callables_length) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Bytecode module %uz has no callables", i);
+    cio_frame_t* const frame = &vm->frames[vm->frames_used - 1];
+    if(frame->base + height > vm->stack_high_water) vm->stack_high_water = frame->base + height;
 
-        for(gen_size_t j = 0; j < vm->bytecode[i].callables_length; ++j) {
-            if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Trying to resolve `%t` against `%t` from bytecode module %uz routine %uz/%uz...", identifier, vm->bytecode[i].callables[j].identifier, i, j, vm->bytecode[i].callables_length);
+    frame->height = height - argc;
+    frame->execution_offset = offset;
 
-            gen_bool_t equal = gen_false;
-            if(vm->bytecode[i].callables[j].identifier_length == len) {
-                error = gen_string_compare(identifier, GEN_STRING_NO_BOUNDS, vm->bytecode[i].callables[j].identifier, GEN_STRING_NO_BOUNDS, vm->bytecode[i].callables[j].identifier_length, &equal);
-                if(error) return error;
-            }
+    return cio_vm_internal_dispatch_slot(vm, slot, argc);
+}
 
-            if(vm->bytecode[i].callables[j].offset == CIO_ROUTINE_EXTERNAL) {
-                if(equal) extref = &vm->bytecode[i].callables[j]; // Fallback to pure-external routine
-                continue;
-            }
+// Routines are only compiled to native code if every call's argument count is known statically
+// i.e. they contain no extensions (which can elide the reserve space) and each call has at least the reserve space pushed
+// Used by the JIT and the C backend
+extern gen_error_t* cio_vm_internal_translatable(const cio_vm_t* const restrict vm, const cio_bytecode_t* const restrict module, const gen_size_t offset, gen_bool_t* const restrict out_translatable);
+gen_error_t* cio_vm_internal_translatable(const cio_vm_t* const restrict vm, const cio_bytecode_t* const restrict module, const gen_size_t offset, gen_bool_t* const restrict out_translatable) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_translatable, GEN_FILE_NAME);
+	if(error) return error;
 
-            if(equal) {
-                *out_callable = &vm->bytecode[i].callables[j];
+    *out_translatable = gen_false;
+
+    gen_size_t argc = 0;
+    for(gen_size_t i = offset; i < module->size; ++i) {
+        const gen_uint8_t operand = module->bytecode[i] & CIO_OPERAND_MAX;
+
+        if(module->bytecode[i] >> 7) {
+            if(operand == CIO_OPERAND_MAX) {
+                *out_translatable = gen_true;
                 return GEN_NULL;
             }
+
+            if(!argc || module->decoded[i].operand >= vm->callables_length) return GEN_NULL;
+            argc = 0;
+        }
+        else {
+            if(operand == CIO_OPERAND_MAX) return GEN_NULL;
+            ++argc;
         }
     }
 
-    if(!vminit) {
-        if(extref) {
-            if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_WARNING, "cionom", "Resolving identifier %t to purely external callable", identifier);
+    return GEN_NULL;
+}
 
-            *out_callable = extref;
-            return GEN_NULL;
-        }
+gen_error_t* cio_vm_status_error(cio_vm_t* const restrict vm, const cio_status_t status) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_status_error, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+
+    if(status == CIO_STATUS_OK) return GEN_NULL;
+
+    if(status == &cio_fault_propagated) {
+        error = vm->fault;
+        vm->fault = GEN_NULL;
+        return error;
     }
 
-    return gen_error_attach_backtrace_formatted(GEN_ERROR_NO_SUCH_OBJECT, GEN_LINE_NUMBER, "Could not find identifier `%t`", identifier);
+    return gen_error_attach_backtrace(status->type, GEN_LINE_NUMBER, status->context);
 }
 
-gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, const gen_size_t stack_length, gen_bool_t resolve_externals, cio_vm_t* const restrict out_instance, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_initialize, GEN_FILE_NAME);
+gen_error_t* cio_vm_dispatch_callable(cio_vm_t* const restrict vm, const cio_callable_t* callable, const gen_size_t argc) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_dispatch_callable, GEN_FILE_NAME);
 	if(error) return error;
 
-    // TODO: Verify that modules are actually modules
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!callable) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`callable` was `GEN_NULL`");
+	if(callable < vm->callables || callable >= vm->callables + vm->callables_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`callable` was not a callable of `vm`");
 
-	if(!bytecode) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`bytecode` was `GEN_NULL`");
-	if(!bytecode_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`bytecode_length` was 0");
-	if(!out_instance) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_instance` was `GEN_NULL`");
+	return cio_vm_internal_dispatch_slot(vm, (gen_size_t) (callable - vm->callables), argc);
+}
 
-    out_instance->warning_settings = warning_settings;
-    out_instance->debug_prints = debug_prints;
+gen_error_t* cio_vm_dispatch_call(cio_vm_t* const restrict vm, const gen_size_t callable, const gen_size_t argc) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_dispatch_call, GEN_FILE_NAME);
+	if(error) return error;
 
-	out_instance->stack_length = stack_length;
-	error = gen_memory_allocate_zeroed((void**) &out_instance->stack, out_instance->stack_length, sizeof(gen_size_t));
-    if(error) return error;
-	out_instance->frames_length = stack_length;
-	error = gen_memory_allocate_zeroed((void**) &out_instance->frames, out_instance->frames_length, sizeof(cio_frame_t));
-    if(error) return error;
-    static const char external_lib_name[] = "cionom-external";
-	error = gen_dynamic_library_handle_open(external_lib_name, sizeof(external_lib_name) - 1, &out_instance->external_lib);
-    if(error) return error;
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(callable >= vm->bytecode[vm->current_bytecode].callables_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_BOUNDS, GEN_LINE_NUMBER, "`callable` was greater than the current module's callables length");
 
-    cio_routine_function_t onload = GEN_NULL;
-    error = gen_dynamic_library_handle_get_symbol(&out_instance->external_lib, "__cionom_extlib_on_load", sizeof("__cionom_extlib_on_load") - 1, (void**) &onload);
-    if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+	return cio_vm_internal_dispatch_slot(vm, vm->bytecode[vm->current_bytecode].callables_offset + callable, argc);
+}
 
-    error = gen_dynamic_library_handle_get_symbol(&out_instance->external_lib, "__cionom_extlib_wrap_call", sizeof("__cionom_extlib_wrap_call") - 1, (void**) &out_instance->external_lib_call_wrapper);
-    if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+static gen_error_t* cio_vm_internal_find_symbol(cio_vm_t* const restrict vm, const char* const restrict identifier, const gen_size_t identifier_length, const gen_uint64_t hash, cio_symbol_t* restrict * const restrict out_symbol) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_find_symbol, GEN_FILE_NAME);
+	if(error) return error;
 
-    for(gen_size_t i = 0; i < bytecode_length; ++i) {
-        if(out_instance->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Began decoding bytecode module %uz at offset %p in bundle", out_instance->bytecode_length, i);
+    *out_symbol = GEN_NULL;
+    if(!vm->symbols_length) return GEN_NULL;
 
-        error = gen_memory_reallocate_zeroed((void**) &out_instance->bytecode, out_instance->bytecode_length, out_instance->bytecode_length + 1, sizeof(cio_bytecode_t));
+    // Linear probing - the table is kept at most half full so this always terminates on an empty entry
+    for(gen_size_t i = hash & (vm->symbols_length - 1);; i = (i + 1) & (vm->symbols_length - 1)) {
+        cio_symbol_t* const symbol = &vm->symbols[i];
+        if(!symbol->internal && !symbol->external) {
+            *out_symbol = symbol;
+            return GEN_NULL;
+        }
+
+        if(symbol->hash != hash) continue;
+
+        const cio_callable_t* const callable = &vm->callables[(symbol->internal ? symbol->internal : symbol->external) - 1];
+
+        if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Trying to resolve `%t` against `%t` from symbol %uz/%uz...", identifier, callable->identifier, i, vm->symbols_length);
+
+        if(callable->identifier_length != identifier_length) continue;
+
+        gen_bool_t equal = gen_false;
+        error = gen_string_compare(identifier, GEN_STRING_NO_BOUNDS, callable->identifier, GEN_STRING_NO_BOUNDS, identifier_length, &equal);
         if(error) return error;
 
-        cio_bytecode_t* module = &out_instance->bytecode[out_instance->bytecode_length];
+        if(equal) {
+            *out_symbol = symbol;
+            return GEN_NULL;
+        }
+    }
+}
 
-        module->callables_length = bytecode[i] & 0b01111111;
+static gen_error_t* cio_vm_internal_build_symbols(cio_vm_t* const restrict vm) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_build_symbols, GEN_FILE_NAME);
+	if(error) return error;
 
-        gen_size_t offset = 1;
-        if(bytecode[i] & 0b10000000) {
-            if(out_instance->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Module %uz contains extension data", out_instance->bytecode_length);
+    if(!vm->callables_length) return GEN_NULL;
 
-            ++offset;
+    vm->symbols_length = 1;
+    while(vm->symbols_length < vm->callables_length * 2) vm->symbols_length <<= 1;
 
-            do {
-                error = gen_memory_reallocate_zeroed((void**) &module->extensions, module->extensions_length, module->extensions_length + 1, sizeof(cio_extension_data_t));
-                if(error) return error;
+    error = gen_memory_allocate_zeroed((void**) &vm->symbols, vm->symbols_length, sizeof(cio_symbol_t));
+    if(error) return error;
 
-                cio_extension_data_t* extension = &module->extensions[module->extensions_length];
+    for(gen_size_t i = 0; i < vm->callables_length; ++i) {
+        const cio_callable_t* const callable = &vm->callables[i];
+        const gen_uint64_t hash = cio_internal_hash(callable->identifier, callable->identifier_length);
 
-                // Doing this here because otherwise clang thinks all cases have been covered
+        cio_symbol_t* symbol = GEN_NULL;
+        error = cio_vm_internal_find_symbol(vm, callable->identifier, callable->identifier_length, hash, &symbol);
+        if(error) return error;
+
+        symbol->hash = hash;
+        // Internal definitions win over pure-external entries, so only the first is kept
+        if(callable->offset != CIO_ROUTINE_EXTERNAL) {
+            if(!symbol->internal) symbol->internal = i + 1;
+        }
+        else symbol->external = i + 1;
+    }
+
+    return GEN_NULL;
+}
+
+gen_error_t* cio_vm_get_identifier(cio_vm_t* const restrict vm, const char* identifier, cio_callable_t* restrict * const restrict out_callable, gen_bool_t vminit) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_get_identifier, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!identifier) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`identifier` was `GEN_NULL`");
+	if(!out_callable) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_callable` was `GEN_NULL`");
+
+    gen_size_t len = 0;
+    error = gen_string_length(identifier, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &len);
+    if(error) return error;
+
+    // TODO: Maybe this should be a warning
+    if(vm->debug_prints) if(!vm->callables_length) gen_log(GEN_LOG_LEVEL_DEBUG, "cionom", "Executable bundle has no callables");
+
+    cio_symbol_t* symbol = GEN_NULL;
+    error = cio_vm_internal_find_symbol(vm, identifier, len, cio_internal_hash(identifier, len), &symbol);
+    if(error) return error;
+
+    cio_callable_t* extref = GEN_NULL;
+    if(symbol) {
+        if(symbol->internal) {
+            *out_callable = &vm->callables[symbol->internal - 1];
+            return GEN_NULL;
+        }
+
+        if(symbol->external) extref = &vm->callables[symbol->external - 1]; // Fallback to pure-external routine
+    }
+
+    if(!vminit) {
+        if(extref) {
+            if(vm->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_WARNING, "cionom", "Resolving identifier %t to purely external callable", identifier);
+
+            *out_callable = extref;
+            return GEN_NULL;
+        }
+    }
+
+    return gen_error_attach_backtrace_formatted(GEN_ERROR_NO_SUCH_OBJECT, GEN_LINE_NUMBER, "Could not find identifier `%t`", identifier);
+}
+
+// Releases the tables of a module decoded by the loader
+static gen_error_t* cio_vm_internal_free_module(cio_bytecode_t* const restrict module) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_free_module, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(module->decoded) {
+        error = gen_memory_free((void**) &module->decoded);
+        if(error) return error;
+    }
+
+    if(module->extensions) {
+        error = gen_memory_free((void**) &module->extensions);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+// Releases a module which the loader failed partway through decoding
+// Modules are only counted in `bytecode_length` once fully decoded, so would otherwise be missed
+static void cio_vm_internal_load_cleanup_module(cio_bytecode_t** module) {
+    if(!*module) return;
+
+    gen_error_t* error = cio_vm_internal_free_module(*module);
+    if(error) {
+        gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+// Loads the program into the program fields of a VM, which are then moved into an image
+// Extlib hooks which have no counterpart in the VM are written into `out_hooks`
+// Execution state is left untouched
+static gen_error_t* cio_vm_internal_load(const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, gen_bool_t resolve_externals, cio_vm_t* const restrict out_instance, cio_image_t* const restrict out_hooks) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_load, GEN_FILE_NAME);
+	if(error) return error;
+
+    // TODO: Verify that modules are actually modules
+
+    static const char external_lib_name[] = "cionom-external";
+	error = gen_dynamic_library_handle_open(external_lib_name, sizeof(external_lib_name) - 1, &out_instance->external_lib);
+    if(error) return error;
+
+    error = gen_dynamic_library_handle_get_symbol(&out_instance->external_lib, "__cionom_extlib_on_load", sizeof("__cionom_extlib_on_load") - 1, (void**) &out_hooks->external_lib_on_load);
+    if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+
+    error = gen_dynamic_library_handle_get_symbol(&out_instance->external_lib, "__cionom_extlib_on_clone", sizeof("__cionom_extlib_on_clone") - 1, (void**) &out_hooks->external_lib_on_clone);
+    if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+
+    error = gen_dynamic_library_handle_get_symbol(&out_instance->external_lib, "__cionom_extlib_on_idle", sizeof("__cionom_extlib_on_idle") - 1, (void**) &out_hooks->external_lib_on_idle);
+    if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+
+    error = gen_dynamic_library_handle_get_symbol(&out_instance->external_lib, "__cionom_extlib_on_free", sizeof("__cionom_extlib_on_free") - 1, (void**) &out_hooks->external_lib_on_free);
+    if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+
+    error = gen_dynamic_library_handle_get_symbol(&out_instance->external_lib, "__cionom_extlib_wrap_call", sizeof("__cionom_extlib_wrap_call") - 1, (void**) &out_instance->external_lib_call_wrapper);
+    if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+
+    for(gen_size_t i = 0; i < bytecode_length; ++i) {
+        if(out_instance->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Began decoding bytecode module %uz at offset %p in bundle", out_instance->bytecode_length, i);
+
+        error = gen_memory_reallocate_zeroed((void**) &out_instance->bytecode, out_instance->bytecode_length, out_instance->bytecode_length + 1, sizeof(cio_bytecode_t));
+        if(error) return error;
+
+        cio_bytecode_t* module = &out_instance->bytecode[out_instance->bytecode_length];
+        GEN_CLEANUP_FUNCTION(cio_vm_internal_load_cleanup_module) cio_bytecode_t* pending = module;
+
+        module->callables_length = bytecode[i] & 0b01111111;
+
+        gen_size_t offset = 1;
+        if(bytecode[i] & 0b10000000) {
+            if(out_instance->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Module %uz contains extension data", out_instance->bytecode_length);
+
+            ++offset;
+
+            do {
+                error = gen_memory_reallocate_zeroed((void**) &module->extensions, module->extensions_length, module->extensions_length + 1, sizeof(cio_extension_data_t));
+                if(error) return error;
+
+                cio_extension_data_t* extension = &module->extensions[module->extensions_length];
+
+                // Doing this here because otherwise clang thinks all cases have been covered
                 switch(bytecode[offset] & 0b01111111) {
                     case CIO_EXTENSION_ID_ELIDE_RESERVE_SPACE: {
                         module->extension_settings.elide_reserve_space = gen_true;
@@ -374,9 +1046,12 @@ gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, con
             } while(bytecode[offset] & 0b10000000);
         }
 
+        // Callables for all modules live in one table - `module->callables` is pointed into it once all modules are read
+        module->callables_offset = out_instance->callables_length;
         if(module->callables_length) {
-            error = gen_memory_allocate_zeroed((void**) &module->callables, module->callables_length, sizeof(cio_callable_t));
+            error = gen_memory_reallocate_zeroed((void**) &out_instance->callables, out_instance->callables_length, out_instance->callables_length + module->callables_length, sizeof(cio_callable_t));
             if(error) return error;
+            out_instance->callables_length += module->callables_length;
         }
 
         for(gen_size_t j = 0; j < module->callables_length; ++j) {
@@ -397,7 +1072,7 @@ gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, con
             if(error) return error;
 #endif
 
-            module->callables[j] = (cio_callable_t) {entry->name, stride, cio_vm_internal_execute_routine, out_instance->bytecode_length, entry->offset, j};
+            out_instance->callables[module->callables_offset + j] = (cio_callable_t) {entry->name, stride, cio_vm_internal_execute_routine, out_instance->bytecode_length, entry->offset, j};
 
             if(out_instance->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Appended routine table entry for %t routine `%tz` in bytecode module %uz at index %uz/%uz", entry->offset == CIO_ROUTINE_EXTERNAL ? "external" : "internal", entry->name, stride, out_instance->bytecode_length, j, module->callables_length);
 
@@ -415,7 +1090,7 @@ gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, con
         i += offset;
 
         // Add on offset of last callable
-        i += module->callables[module->callables_length - 1].offset;
+        i += out_instance->callables[module->callables_offset + module->callables_length - 1].offset;
 
         for(; bytecode[i] != 0xFF; ++i);
 
@@ -423,9 +1098,32 @@ gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, con
 
         if(out_instance->debug_prints) gen_log_formatted(GEN_LOG_LEVEL_DEBUG, "cionom", "Bytecode code block size %uz", module->size);
 
+        error = gen_memory_allocate_zeroed((void**) &module->decoded, module->size, sizeof(cio_decoded_instruction_t));
+        if(error) return error;
+
+        // Calls are decoded to their slot in the VM's callable table
+        // Out-of-range routine indices are decoded past the end of the table
+        for(gen_size_t j = 0; j < module->size; ++j) {
+            const gen_uint8_t operand = module->bytecode[j] & CIO_OPERAND_MAX;
+
+            if(module->bytecode[j] >> 7) {
+                if(operand == CIO_OPERAND_MAX) module->decoded[j] = (cio_decoded_instruction_t) {CIO_DECODED_RET, operand};
+                else module->decoded[j] = (cio_decoded_instruction_t) {CIO_DECODED_CALL, operand < module->callables_length ? (gen_uint32_t) (module->callables_offset + operand) : GEN_UINT32_MAX};
+            }
+            else module->decoded[j] = (cio_decoded_instruction_t) {operand == CIO_OPERAND_MAX ? CIO_DECODED_EXTENSION : CIO_DECODED_PUSH, operand};
+        }
+
+        pending = GEN_NULL;
         ++out_instance->bytecode_length;
     }
 
+    for(gen_size_t i = 0; i < out_instance->bytecode_length; ++i) {
+        if(out_instance->bytecode[i].callables_length) out_instance->bytecode[i].callables = &out_instance->callables[out_instance->bytecode[i].callables_offset];
+    }
+
+    error = cio_vm_internal_build_symbols(out_instance);
+    if(error) return error;
+
     if(resolve_externals) {
         for(gen_size_t i = 0; i < out_instance->bytecode_length; ++i) {
             for(gen_size_t j = 0; j < out_instance->bytecode[i].callables_length; ++j) {
@@ -457,45 +1155,617 @@ gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, con
         }
     }
 
-    if(onload) {
-        error = onload(out_instance);
+    // Resolve each callable to the routine it will dispatch to
+    if(out_instance->callables_length) {
+        error = gen_memory_allocate_zeroed((void**) &out_instance->dispatch, out_instance->callables_length, sizeof(cio_dispatch_t));
+        if(error) return error;
+    }
+
+    for(gen_size_t i = 0; i < out_instance->callables_length; ++i) {
+        const cio_callable_t* const callable = &out_instance->callables[i];
+        const cio_bytecode_t* const module = &out_instance->bytecode[callable->bytecode_index];
+        if(callable->routine_index >= module->callables_length) return gen_error_attach_backtrace(GEN_ERROR_OUT_OF_BOUNDS, GEN_LINE_NUMBER, "The index of the callable in remote module was greater than the remote module's callables length");
+
+        const cio_callable_t* const remote = &module->callables[callable->routine_index];
+        out_instance->dispatch[i] = (cio_dispatch_t) {remote->function, GEN_NULL, remote->offset < module->size ? &module->decoded[remote->offset] : GEN_NULL, (gen_uint32_t) remote->bytecode_index, (gen_uint32_t) remote->offset};
+
+        // Not all external libraries provide the fast calling convention
+        if(resolve_externals && remote->offset == CIO_ROUTINE_EXTERNAL) {
+            error = cio_resolve_external_fast(remote->identifier, &out_instance->dispatch[i].fast, &out_instance->external_lib);
+            if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        }
+    }
+
+    // Well-known routines are recognised by their native implementations
+    // Any which are missing from the external library are left as `GEN_NULL`
+    cio_routine_function_t branch = GEN_NULL;
+    cio_routine_function_t branch_sign = GEN_NULL;
+    cio_routine_function_t call_indirect = GEN_NULL;
+    cio_routine_function_t add = GEN_NULL;
+    cio_routine_function_t subtract = GEN_NULL;
+    cio_routine_function_t copy = GEN_NULL;
+    cio_routine_function_t copy_variable = GEN_NULL;
+    cio_routine_function_t store_char = GEN_NULL;
+    if(resolve_externals && (out_instance->settings.trampoline || out_instance->settings.tail_calls || !out_instance->settings.no_intrinsics)) {
+        error = cio_resolve_external("?", &branch, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        error = cio_resolve_external("?+-", &branch_sign, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        error = cio_resolve_external("callv", &call_indirect, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        error = cio_resolve_external("+", &add, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        error = cio_resolve_external("-", &subtract, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        error = cio_resolve_external("copy=", &copy, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        error = cio_resolve_external("copy=v", &copy_variable, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+        error = cio_resolve_external("copy*[+]=c", &store_char, &out_instance->external_lib);
+        if(error && error->type != GEN_ERROR_NO_SUCH_OBJECT) return error;
+    }
+
+    if(out_instance->settings.tail_calls && resolve_externals) {
+        // Routines which read their caller's frame would see a different one if entered by a tail call
+        // External routines are marked by their library as reading past the frame of the routine calling them
+        gen_bool_t any_reads_caller = gen_false;
+        for(gen_size_t i = 0; i < out_instance->callables_length; ++i) {
+            cio_dispatch_t* const routine = &out_instance->dispatch[i];
+            if(routine->function == cio_vm_internal_execute_routine) continue;
+
+            error = cio_resolve_external_reads_caller(out_instance->callables[i].identifier, &routine->reads_caller, &out_instance->external_lib);
+            if(error) return error;
+
+            any_reads_caller |= routine->reads_caller;
+        }
+
+        for(gen_size_t i = 0; any_reads_caller && i < out_instance->callables_length; ++i) {
+            cio_dispatch_t* const routine = &out_instance->dispatch[i];
+            if(routine->function != cio_vm_internal_execute_routine || !routine->code) continue;
+
+            const cio_bytecode_t* const module = &out_instance->bytecode[routine->bytecode_index];
+            for(gen_size_t j = routine->offset; j < module->size; ++j) {
+                if(!(module->bytecode[j] >> 7)) continue;
+                if((module->bytecode[j] & CIO_OPERAND_MAX) == CIO_OPERAND_MAX) break;
+
+                if(module->decoded[j].operand < out_instance->callables_length && out_instance->dispatch[module->decoded[j].operand].reads_caller) {
+                    routine->observes_caller = gen_true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if(out_instance->settings.tail_calls) {
+        // Calls directly preceding a return are executed in place of the current frame.
+        // The branch routines and `callv` are recognised by their native implementations
+        // So that calls made through them in tail position can also reuse the frame.
+        for(gen_size_t i = 0; i < out_instance->bytecode_length; ++i) {
+            cio_bytecode_t* module = &out_instance->bytecode[i];
+
+            for(gen_size_t j = 0; j + 1 < module->size; ++j) {
+                if(module->decoded[j].opcode != CIO_DECODED_CALL || module->decoded[j + 1].opcode != CIO_DECODED_RET) continue;
+                if(module->decoded[j].operand >= out_instance->callables_length) continue;
+
+                const cio_routine_function_t function = out_instance->dispatch[module->decoded[j].operand].function;
+                if(branch && function == branch) module->decoded[j].opcode = CIO_DECODED_TAIL_BRANCH;
+                else if(branch_sign && function == branch_sign) module->decoded[j].opcode = CIO_DECODED_TAIL_BRANCH_SIGN;
+                else if(call_indirect && function == call_indirect) module->decoded[j].opcode = CIO_DECODED_TAIL_CALLV;
+                else module->decoded[j].opcode = CIO_DECODED_TAIL_CALL;
+            }
+        }
+    }
+
+    if(out_instance->settings.trampoline) {
+        // Routines called through the branch routines and `callv` are entered by the interpreter
+        // So that no configuration recurses natively through them
+        for(gen_size_t i = 0; i < out_instance->bytecode_length; ++i) {
+            cio_bytecode_t* module = &out_instance->bytecode[i];
+
+            for(gen_size_t j = 0; j < module->size; ++j) {
+                if(module->decoded[j].opcode != CIO_DECODED_CALL) continue;
+                if(module->decoded[j].operand >= out_instance->callables_length) continue;
+
+                const cio_routine_function_t function = out_instance->dispatch[module->decoded[j].operand].function;
+                if(branch && function == branch) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_BRANCH;
+                else if(branch_sign && function == branch_sign) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_BRANCH_SIGN;
+                else if(call_indirect && function == call_indirect) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_CALLV;
+            }
+        }
+    }
+
+    // Profiled VMs keep every call visible
+    if(!out_instance->settings.no_intrinsics && !out_instance->settings.profile) {
+        // Calls to small core routines are executed inline by the interpreter rather than through the extlib
+        // A tail call to a native routine is just a call, so those are also candidates
+        for(gen_size_t i = 0; i < out_instance->bytecode_length; ++i) {
+            cio_bytecode_t* module = &out_instance->bytecode[i];
+
+            for(gen_size_t j = 0; j < module->size; ++j) {
+                const gen_bool_t tail = module->decoded[j].opcode == CIO_DECODED_TAIL_CALL;
+                if(module->decoded[j].opcode != CIO_DECODED_CALL && !tail) continue;
+                if(module->decoded[j].operand >= out_instance->callables_length) continue;
+
+                // Calls with unexpected parameter counts are left to the native implementation, as when compiled
+                // Pushes following an extension may have had their reserve space elided, so those calls are left alone too
+                gen_size_t pushes = 0;
+                while(pushes < j && module->decoded[j - pushes - 1].opcode == CIO_DECODED_PUSH) ++pushes;
+                if(!pushes || (pushes < j && module->decoded[j - pushes - 1].opcode == CIO_DECODED_EXTENSION)) continue;
+
+                // Subtract 1 for reserve space
+                const gen_size_t callee_argc = pushes - 1;
+                const cio_routine_function_t function = out_instance->dispatch[module->decoded[j].operand].function;
+                if(callee_argc != (function == store_char ? 3 : 2)) continue;
+
+                if(add && function == add) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_ADD;
+                else if(subtract && function == subtract) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_SUBTRACT;
+                else if(copy && function == copy) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_COPY;
+                else if(copy_variable && function == copy_variable) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_COPY_VARIABLE;
+                else if(store_char && function == store_char) module->decoded[j].opcode = CIO_DECODED_INTRINSIC_STORE_CHAR;
+            }
+        }
+    }
+
+    // Fuse the pushes leading up to each call into a superinstruction which goes on to make the call
+    // This runs last so that the call's opcode already reflects any decoration by the passes above
+    for(gen_size_t i = 0; i < out_instance->bytecode_length; ++i) {
+        cio_bytecode_t* module = &out_instance->bytecode[i];
+
+        for(gen_size_t j = 0; j < module->size; ++j) {
+            const cio_decoded_opcode_t opcode = module->decoded[j].opcode;
+            if(opcode == CIO_DECODED_PUSH || opcode == CIO_DECODED_EXTENSION || opcode == CIO_DECODED_RET) continue;
+
+            gen_size_t run = 0;
+            while(run < 4 && run < j && module->decoded[j - run - 1].opcode == CIO_DECODED_PUSH) ++run;
+            if(run) module->decoded[j - run].opcode = CIO_DECODED_PUSH_CALL_1 + (gen_uint32_t) run - 1;
+        }
+    }
+
+    if(out_instance->settings.jit) {
+        error = cio_vm_internal_jit_compile(out_instance);
         if(error) return error;
     }
 
 	return GEN_NULL;
 }
 
-gen_error_t* cio_vm_free(cio_vm_t* const restrict instance) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_free, GEN_FILE_NAME);
+// Releases an image's program tables and mapping, but not the image itself
+// Also used to discard a partially loaded program, so tolerates tables which were never allocated
+static gen_error_t* cio_image_internal_free_program(cio_image_t* const restrict image) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_image_internal_free_program, GEN_FILE_NAME);
 	if(error) return error;
 
-	if(!instance) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`instance` was `GEN_NULL`");
+    if(image->external_lib) {
+        error = gen_dynamic_library_handle_close(image->external_lib);
+        if(error) return error;
+    }
+
+    if(image->callables) {
+        error = gen_memory_free((void**) &image->callables);
+        if(error) return error;
+    }
+
+    if(image->dispatch) {
+        error = gen_memory_free((void**) &image->dispatch);
+        if(error) return error;
+    }
+
+    if(image->symbols) {
+        error = gen_memory_free((void**) &image->symbols);
+        if(error) return error;
+    }
+
+    if(image->jit_code) {
+        error = cio_vm_internal_jit_free(image);
+        if(error) return error;
+    }
+
+    for(gen_size_t i = 0; i < image->bytecode_length; ++i) {
+        error = cio_vm_internal_free_module(&image->bytecode[i]);
+        if(error) return error;
+    }
+
+    if(image->bytecode) {
+        error = gen_memory_free((void**) &image->bytecode);
+        if(error) return error;
+    }
+
+    if(image->file) {
+        error = cio_vm_internal_file_unmap(image->file, image->file_length);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+// Moves the program loaded into `loader` into an image
+static cio_image_t cio_vm_internal_image_from_loader(const cio_vm_t* const restrict loader, const cio_image_t* const restrict hooks) {
+    return (cio_image_t) {
+        .references = 1,
+        .bytecode = loader->bytecode,
+        .bytecode_length = loader->bytecode_length,
+        .callables = loader->callables,
+        .callables_length = loader->callables_length,
+        .dispatch = loader->dispatch,
+        .symbols = loader->symbols,
+        .symbols_length = loader->symbols_length,
+        .external_lib = loader->external_lib,
+        .external_lib_on_load = hooks->external_lib_on_load,
+        .external_lib_on_clone = hooks->external_lib_on_clone,
+        .external_lib_on_idle = hooks->external_lib_on_idle,
+        .external_lib_on_free = hooks->external_lib_on_free,
+        .external_lib_call_wrapper = loader->external_lib_call_wrapper,
+        .jit_code = loader->jit_code,
+        .jit_code_length = loader->jit_code_length,
+        .debug_prints = loader->debug_prints,
+        .warning_settings = loader->warning_settings,
+        .settings = loader->settings
+    };
+}
+
+// Releases whatever the loader managed to load before failing
+// The load's own error is the one reported, so any from releasing are only printed
+static void cio_vm_internal_discard_loader(const cio_vm_t* const restrict loader, const cio_image_t* const restrict hooks) {
+    cio_image_t program = cio_vm_internal_image_from_loader(loader, hooks);
+    gen_error_t* const error = cio_image_internal_free_program(&program);
+    if(error) gen_error_print("cionom", error, GEN_ERROR_SEVERITY_WARNING);
+}
+
+gen_error_t* cio_image_initialize(const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, gen_bool_t resolve_externals, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings, cio_image_t** const restrict out_image) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_image_initialize, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!bytecode) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`bytecode` was `GEN_NULL`");
+	if(!bytecode_length) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`bytecode_length` was 0");
+	if(!out_image) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_image` was `GEN_NULL`");
+
+    // Loading runs against a VM with no stack, so that the existing lookups can be used while resolving
+    cio_vm_t loader = {0};
+    loader.warning_settings = warning_settings;
+    loader.debug_prints = debug_prints;
+    loader.settings = settings ? *settings : (cio_vm_settings_t) {0};
+
+    const gen_size_t resolution_start = cio_vm_internal_now();
+
+    cio_image_t hooks = {0};
+    error = cio_vm_internal_load(bytecode, bytecode_length, resolve_externals, &loader, &hooks);
+    if(error) {
+        cio_vm_internal_discard_loader(&loader, &hooks);
+        return error;
+    }
+
+    const gen_size_t resolution_time = cio_vm_internal_now() - resolution_start;
+
+    cio_image_t* image = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &image, 1, sizeof(cio_image_t));
+    if(error) {
+        cio_vm_internal_discard_loader(&loader, &hooks);
+        return error;
+    }
+
+    *image = cio_vm_internal_image_from_loader(&loader, &hooks);
+    image->resolution_time = resolution_time;
+
+    *out_image = image;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_image_initialize_from_file(const char* const restrict path, gen_bool_t resolve_externals, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings, cio_image_t** const restrict out_image) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_image_initialize_from_file, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!path) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`path` was `GEN_NULL`");
+	if(!out_image) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_image` was `GEN_NULL`");
+
+    const unsigned char* file = GEN_NULL;
+    gen_size_t file_length = 0;
+    error = cio_vm_internal_file_map(path, &file, &file_length);
+    if(error) return error;
+
+    error = cio_image_initialize(file, file_length, resolve_externals, debug_prints, warning_settings, settings, out_image);
+    if(error) {
+        gen_error_t* const unmap_error = cio_vm_internal_file_unmap(file, file_length);
+        if(unmap_error) gen_error_print("cionom", unmap_error, GEN_ERROR_SEVERITY_WARNING);
+
+        return error;
+    }
+
+    // Module bytecode points into the mapping, so it is released with the image
+    (*out_image)->file = file;
+    (*out_image)->file_length = file_length;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_image_retain(cio_image_t* const restrict image) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_image_retain, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!image) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`image` was `GEN_NULL`");
+
+    __atomic_fetch_add(&image->references, 1, __ATOMIC_RELAXED);
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_image_release(cio_image_t* const restrict image) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_image_release, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!image) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`image` was `GEN_NULL`");
+
+    if(__atomic_sub_fetch(&image->references, 1, __ATOMIC_ACQ_REL)) return GEN_NULL;
+
+    error = cio_image_internal_free_program(image);
+    if(error) return error;
+
+    cio_image_t* freed = image;
+    error = gen_memory_free((void**) &freed);
+    if(error) return error;
+
+	return GEN_NULL;
+}
+
+// Sets up a VM's program fields and an empty stack for an image
+static gen_error_t* cio_vm_internal_attach_image(cio_image_t* const restrict image, const gen_size_t stack_length, cio_vm_t* const restrict out_instance) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_internal_attach_image, GEN_FILE_NAME);
+	if(error) return error;
+
+    error = cio_image_retain(image);
+    if(error) return error;
+
+    out_instance->image = image;
+    out_instance->bytecode = image->bytecode;
+    out_instance->bytecode_length = image->bytecode_length;
+    out_instance->callables = image->callables;
+    out_instance->callables_length = image->callables_length;
+    out_instance->dispatch = image->dispatch;
+    out_instance->symbols = image->symbols;
+    out_instance->symbols_length = image->symbols_length;
+    out_instance->external_lib = image->external_lib;
+    out_instance->external_lib_call_wrapper = image->external_lib_call_wrapper;
+    out_instance->jit_code = image->jit_code;
+    out_instance->jit_code_length = image->jit_code_length;
+    out_instance->debug_prints = image->debug_prints;
+    out_instance->warning_settings = image->warning_settings;
+    out_instance->settings = image->settings;
+
+	out_instance->stack_length = stack_length;
+	error = gen_memory_allocate_zeroed((void**) &out_instance->stack, out_instance->stack_length, sizeof(gen_size_t));
+    if(error) return error;
+	out_instance->frames_length = stack_length;
+	error = gen_memory_allocate_zeroed((void**) &out_instance->frames, out_instance->frames_length, sizeof(cio_frame_t));
+    if(error) return error;
+
+    if(out_instance->settings.profile) {
+        error = cio_vm_internal_profile_initialize(out_instance);
+        if(error) return error;
+    }
+
+	return GEN_NULL;
+}
+
+// Undoes a partial `cio_vm_internal_attach_image` after a failure
+// The attach's own error is the one reported, so any from releasing are only printed
+static void cio_vm_internal_discard_instance(cio_vm_t* const restrict instance) {
+    gen_error_t* error = GEN_NULL;
 
     if(instance->stack) {
         error = gen_memory_free((void**) &instance->stack);
-        if(error) return error;
+        if(error) gen_error_print("cionom", error, GEN_ERROR_SEVERITY_WARNING);
     }
 
     if(instance->frames) {
         error = gen_memory_free((void**) &instance->frames);
+        if(error) gen_error_print("cionom", error, GEN_ERROR_SEVERITY_WARNING);
+    }
+
+    error = cio_vm_internal_profile_free(instance);
+    if(error) gen_error_print("cionom", error, GEN_ERROR_SEVERITY_WARNING);
+
+    if(instance->image) {
+        error = cio_image_release(instance->image);
+        if(error) gen_error_print("cionom", error, GEN_ERROR_SEVERITY_WARNING);
+
+        instance->image = GEN_NULL;
+    }
+}
+
+gen_error_t* cio_vm_initialize_from_image(cio_image_t* const restrict image, const gen_size_t stack_length, cio_vm_t* const restrict out_instance) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_initialize_from_image, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!image) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`image` was `GEN_NULL`");
+	if(!out_instance) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_instance` was `GEN_NULL`");
+
+    error = cio_vm_internal_attach_image(image, stack_length, out_instance);
+    if(error) {
+        cio_vm_internal_discard_instance(out_instance);
+        return error;
+    }
+
+    // Extlib state is per-VM
+    if(image->external_lib_on_load) {
+        error = image->external_lib_on_load(out_instance);
+        if(error) {
+            cio_vm_internal_discard_instance(out_instance);
+            return error;
+        }
+    }
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_vm_clone(const cio_vm_t* const restrict source, cio_vm_t* const restrict out_instance) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_clone, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!source) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`source` was `GEN_NULL`");
+	if(!source->image) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`source` was not initialized");
+	if(!out_instance) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_instance` was `GEN_NULL`");
+
+	// Coroutine stacks hold frames which point back into the VM they were started in
+	if(source->coroutine || source->coroutines || source->coroutines_parked) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "`source` has coroutines which have not finished");
+
+    error = cio_vm_internal_attach_image(source->image, source->stack_length, out_instance);
+    if(error) {
+        cio_vm_internal_discard_instance(out_instance);
+        return error;
+    }
+
+    // Cells above the high-water mark (or the top frame, for frames pushed through the API) are still zero in both stacks
+    gen_size_t used = source->stack_high_water;
+    if(source->frames_used) {
+        const cio_frame_t* const top = &source->frames[source->frames_used - 1];
+        if(top->base + top->height > used) used = top->base + top->height;
+    }
+
+    if(used) {
+        error = gen_memory_copy(out_instance->stack, out_instance->stack_length * sizeof(gen_size_t), source->stack, source->stack_length * sizeof(gen_size_t), used * sizeof(gen_size_t));
+        if(error) {
+            cio_vm_internal_discard_instance(out_instance);
+            return error;
+        }
+    }
+    out_instance->stack_high_water = used;
+
+    if(source->frames_used) {
+        error = gen_memory_copy(out_instance->frames, out_instance->frames_length * sizeof(cio_frame_t), source->frames, source->frames_length * sizeof(cio_frame_t), source->frames_used * sizeof(cio_frame_t));
+        if(error) {
+            cio_vm_internal_discard_instance(out_instance);
+            return error;
+        }
+    }
+    out_instance->frames_used = source->frames_used;
+    out_instance->current_bytecode = source->current_bytecode;
+
+    // The clone carries on counting from where the source was
+    out_instance->stats = source->stats;
+
+    if(source->image->external_lib_on_clone) {
+        error = source->image->external_lib_on_clone(out_instance, source);
+        if(error) {
+            cio_vm_internal_discard_instance(out_instance);
+            return error;
+        }
+    }
+    else if(source->image->external_lib_on_load) {
+        error = source->image->external_lib_on_load(out_instance);
+        if(error) {
+            cio_vm_internal_discard_instance(out_instance);
+            return error;
+        }
+    }
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_vm_initialize(const unsigned char* const restrict bytecode, const gen_size_t bytecode_length, const gen_size_t stack_length, gen_bool_t resolve_externals, cio_vm_t* const restrict out_instance, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_initialize, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!out_instance) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_instance` was `GEN_NULL`");
+
+    cio_image_t* image = GEN_NULL;
+    error = cio_image_initialize(bytecode, bytecode_length, resolve_externals, debug_prints, warning_settings, settings, &image);
+    if(error) return error;
+
+    // The VM holds the only reference to its image
+    error = cio_vm_initialize_from_image(image, stack_length, out_instance);
+    if(error) {
+        gen_error_t* const release_error = cio_image_release(image);
+        if(release_error) gen_error_print("cionom", release_error, GEN_ERROR_SEVERITY_WARNING);
+
+        return error;
+    }
+
+    error = cio_image_release(image);
+    if(error) return error;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_vm_initialize_from_file(const char* const restrict path, const gen_size_t stack_length, gen_bool_t resolve_externals, cio_vm_t* const restrict out_instance, gen_bool_t debug_prints, const cio_warning_settings_t* const restrict warning_settings, const cio_vm_settings_t* const restrict settings) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_initialize_from_file, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!out_instance) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_instance` was `GEN_NULL`");
+
+    cio_image_t* image = GEN_NULL;
+    error = cio_image_initialize_from_file(path, resolve_externals, debug_prints, warning_settings, settings, &image);
+    if(error) return error;
+
+    // The VM holds the only reference to its image, and so to the mapping
+    error = cio_vm_initialize_from_image(image, stack_length, out_instance);
+    if(error) {
+        gen_error_t* const release_error = cio_image_release(image);
+        if(release_error) gen_error_print("cionom", release_error, GEN_ERROR_SEVERITY_WARNING);
+
+        return error;
+    }
+
+    error = cio_image_release(image);
+    if(error) return error;
+
+	return GEN_NULL;
+}
+
+gen_error_t* cio_vm_get_stats(const cio_vm_t* const restrict vm, cio_vm_stats_t* const restrict out_stats) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_get_stats, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	if(!out_stats) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_stats` was `GEN_NULL`");
+
+#if CIO_VM_STATS
+    *out_stats = vm->stats;
+    out_stats->peak_stack_height = vm->stack_high_water;
+    out_stats->resolution_time = vm->image ? vm->image->resolution_time : 0;
+
+	return GEN_NULL;
+#else
+    return gen_error_attach_backtrace(GEN_ERROR_NOT_IMPLEMENTED, GEN_LINE_NUMBER, "Execution statistics were compiled out with `CIO_VM_STATS`");
+#endif
+}
+
+gen_error_t* cio_vm_free(cio_vm_t* const restrict instance) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_vm_free, GEN_FILE_NAME);
+	if(error) return error;
+
+	if(!instance) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`instance` was `GEN_NULL`");
+
+    // Sampling reads the frames asynchronously, so must stop first
+    error = cio_vm_internal_sampler_free(instance);
+    if(error) return error;
+
+    // The extlib hands back coroutines it is holding parked before they are freed
+    if(instance->image && instance->image->external_lib_on_free) {
+        error = instance->image->external_lib_on_free(instance);
         if(error) return error;
     }
 
-    if(instance->external_lib) {
-        error = gen_dynamic_library_handle_close(instance->external_lib);
+    error = cio_vm_internal_coroutines_free(instance);
+    if(error) return error;
+
+    if(instance->stack) {
+        error = gen_memory_free((void**) &instance->stack);
         if(error) return error;
     }
 
-    for(gen_size_t i = 0; i < instance->bytecode_length; ++i) {
-        if(instance->bytecode[i].callables) {
-            error = gen_memory_free((void**) &instance->bytecode[i].callables);
-            if(error) return error;
-        }
+    if(instance->frames) {
+        error = gen_memory_free((void**) &instance->frames);
+        if(error) return error;
     }
 
-    if(instance->bytecode) {
-        error = gen_memory_free((void**) &instance->bytecode);
+    error = cio_vm_internal_profile_free(instance);
+    if(error) return error;
+
+    if(instance->image) {
+        error = cio_image_release(instance->image);
         if(error) return error;
+
+        instance->image = GEN_NULL;
     }
 
 	return GEN_NULL;
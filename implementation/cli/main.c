@@ -33,6 +33,10 @@
 #define CIO_CLI_BUNDLE_FILE_FALLBACK "a.cbe"
 #endif
 
+#ifndef CIO_CLI_C_FILE_FALLBACK
+#define CIO_CLI_C_FILE_FALLBACK "a.c"
+#endif
+
 typedef enum {
     CIO_CLI_OPERATION_NONE,
     CIO_CLI_OPERATION_COMPILE,
@@ -41,6 +45,7 @@ typedef enum {
     CIO_CLI_OPERATION_DISASSEMBLE,
     CIO_CLI_OPERATION_BUNDLE,
     CIO_CLI_OPERATION_DEBUNDLE,
+    CIO_CLI_OPERATION_EMIT_C,
     CIO_CLI_OPERATION_VERSION,
     CIO_CLI_OPERATION_HELP
 } cio_cli_operation_t;
@@ -53,11 +58,16 @@ typedef enum {
     CIO_CLI_SWITCH_DISASSEMBLE,
     CIO_CLI_SWITCH_BUNDLE,
     CIO_CLI_SWITCH_DEBUNDLE,
+    CIO_CLI_SWITCH_EMIT_C,
     CIO_CLI_SWITCH_VERSION,
     CIO_CLI_SWITCH_FATAL_WARNINGS,
     CIO_CLI_SWITCH_WARNING,
     CIO_CLI_SWITCH_HELP,
-    CIO_CLI_SWITCH_DEBUG_VM
+    CIO_CLI_SWITCH_DEBUG_VM,
+    CIO_CLI_SWITCH_PROFILE,
+    CIO_CLI_SWITCH_SAMPLE,
+    CIO_CLI_SWITCH_STATS,
+    CIO_CLI_SWITCH_VM_SETTING
 } cio_cli_switch_t;
 
 static gen_error_t* cio_cli_read_file(const char* path, unsigned char** out_file, gen_size_t* out_size) {
@@ -93,13 +103,14 @@ static gen_error_t* cio_cli_read_file(const char* path, unsigned char** out_file
     return GEN_NULL;
 }
 
-static gen_error_t* cio_cli_recreate_write_file(const char* path, const unsigned char* buffer, gen_size_t size) {
-    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_cli_read_file, GEN_FILE_NAME);
+// Opens a file for writing, replacing it if it exists
+static gen_error_t* cio_cli_recreate_open_file(const char* path, gen_filesystem_handle_t* out_handle) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_cli_recreate_open_file, GEN_FILE_NAME);
     if(error) return error;
 
     if(!path) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`path` was `GEN_NULL`");
-    if(!buffer) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`buffer` was `GEN_NULL`");
-    
+    if(!out_handle) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`out_handle` was `GEN_NULL`");
+
     gen_bool_t exists = gen_false;
     error = gen_filesystem_path_exists(path, GEN_STRING_NO_BOUNDS, &exists);
     if(error) return error;
@@ -116,11 +127,24 @@ static gen_error_t* cio_cli_recreate_write_file(const char* path, const unsigned
         if(error) return error;
     }
 
-    gen_filesystem_handle_t handle = {0};
-    error = gen_filesystem_handle_open(path, GEN_STRING_NO_BOUNDS, &handle);
+    error = gen_filesystem_handle_open(path, GEN_STRING_NO_BOUNDS, out_handle);
     if(error) return error;
 
-    error = gen_filesystem_handle_lock(&handle);
+    error = gen_filesystem_handle_lock(out_handle);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_cli_recreate_write_file(const char* path, const unsigned char* buffer, gen_size_t size) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_cli_read_file, GEN_FILE_NAME);
+    if(error) return error;
+
+    if(!path) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`path` was `GEN_NULL`");
+    if(!buffer) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`buffer` was `GEN_NULL`");
+    
+    gen_filesystem_handle_t handle = {0};
+    error = cio_cli_recreate_open_file(path, &handle);
     if(error) return error;
 
     error = gen_filesystem_handle_file_write(&handle, buffer, 0, size);
@@ -135,6 +159,75 @@ static gen_error_t* cio_cli_recreate_write_file(const char* path, const unsigned
     return GEN_NULL;
 }
 
+// A file being streamed through by the compiler
+typedef struct {
+    gen_filesystem_handle_t handle;
+    // The size of the file being read, or the number of bytes written so far
+    gen_size_t size;
+    // Whether `handle` is open and locked, so must be released before returning
+    gen_bool_t open;
+    gen_bool_t locked;
+} cio_cli_stream_file_t;
+
+static gen_error_t* cio_cli_stream_file_close(cio_cli_stream_file_t* const restrict file) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_cli_stream_file_close, GEN_FILE_NAME);
+    if(error) return error;
+
+    if(file->locked) {
+        file->locked = gen_false;
+
+        error = gen_filesystem_handle_unlock(&file->handle);
+        if(error) return error;
+    }
+
+    if(file->open) {
+        file->open = gen_false;
+
+        error = gen_filesystem_handle_close(&file->handle);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+// Releases a file left open by an early return, which already carries the error to report
+static void cio_cli_stream_file_cleanup(cio_cli_stream_file_t* file) {
+    gen_error_t* error = cio_cli_stream_file_close(file);
+    if(error) gen_error_print("cionom-cli", error, GEN_ERROR_SEVERITY_WARNING);
+}
+
+static gen_error_t* cio_cli_stream_read(void* const restrict user_data, const gen_size_t offset, char* const restrict out_buffer, const gen_size_t length, gen_size_t* const restrict out_length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_cli_stream_read, GEN_FILE_NAME);
+    if(error) return error;
+
+    cio_cli_stream_file_t* const file = user_data;
+
+    *out_length = 0;
+    if(offset >= file->size) return GEN_NULL;
+
+    const gen_size_t end = file->size - offset < length ? file->size : offset + length;
+    error = gen_filesystem_handle_file_read(&file->handle, offset, end, (unsigned char*) out_buffer);
+    if(error) return error;
+
+    *out_length = end - offset;
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_cli_stream_write(void* const restrict user_data, const unsigned char* const restrict buffer, const gen_size_t length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_cli_stream_write, GEN_FILE_NAME);
+    if(error) return error;
+
+    cio_cli_stream_file_t* const file = user_data;
+
+    error = gen_filesystem_handle_file_write(&file->handle, buffer, file->size, length);
+    if(error) return error;
+
+    file->size += length;
+
+    return GEN_NULL;
+}
+
 // TODO: Separate out main
 
 static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict* const restrict argv) {
@@ -195,11 +288,16 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
         [CIO_CLI_SWITCH_DISASSEMBLE] = "disassemble",
         [CIO_CLI_SWITCH_BUNDLE] = "bundle",
         [CIO_CLI_SWITCH_DEBUNDLE] = "debundle",
+        [CIO_CLI_SWITCH_EMIT_C] = "emit-c",
         [CIO_CLI_SWITCH_VERSION] = "version",
         [CIO_CLI_SWITCH_FATAL_WARNINGS] = "fatal-warnings",
         [CIO_CLI_SWITCH_WARNING] = "warning",
         [CIO_CLI_SWITCH_HELP] = "help",
-        [CIO_CLI_SWITCH_DEBUG_VM] = "debug-vm"
+        [CIO_CLI_SWITCH_DEBUG_VM] = "debug-vm",
+        [CIO_CLI_SWITCH_PROFILE] = "profile",
+        [CIO_CLI_SWITCH_SAMPLE] = "sample",
+        [CIO_CLI_SWITCH_STATS] = "stats",
+        [CIO_CLI_SWITCH_VM_SETTING] = "vm-setting"
     };
 
     static const gen_size_t switches_lengths[] = {
@@ -210,11 +308,16 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
         [CIO_CLI_SWITCH_DISASSEMBLE] = sizeof("disassemble") - 1,
         [CIO_CLI_SWITCH_BUNDLE] = sizeof("bundle") - 1,
         [CIO_CLI_SWITCH_DEBUNDLE] = sizeof("debundle") - 1,
+        [CIO_CLI_SWITCH_EMIT_C] = sizeof("emit-c") - 1,
         [CIO_CLI_SWITCH_VERSION] = sizeof("version") - 1,
         [CIO_CLI_SWITCH_FATAL_WARNINGS] = sizeof("fatal-warnings") - 1,
         [CIO_CLI_SWITCH_WARNING] = sizeof("warning") - 1,
         [CIO_CLI_SWITCH_HELP] = sizeof("help") - 1,
-        [CIO_CLI_SWITCH_DEBUG_VM] = sizeof("debug-vm") - 1
+        [CIO_CLI_SWITCH_DEBUG_VM] = sizeof("debug-vm") - 1,
+        [CIO_CLI_SWITCH_PROFILE] = sizeof("profile") - 1,
+        [CIO_CLI_SWITCH_SAMPLE] = sizeof("sample") - 1,
+        [CIO_CLI_SWITCH_STATS] = sizeof("stats") - 1,
+        [CIO_CLI_SWITCH_VM_SETTING] = sizeof("vm-setting") - 1
     };
 
     gen_arguments_parsed_t parsed = {0};
@@ -230,6 +333,10 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
     gen_bool_t warn_implicit_file = gen_false;
     cio_warning_settings_t warning_settings = {0};
     gen_bool_t debug_vm = gen_false;
+    const char* profile_file = GEN_NULL;
+    const char* sample_file = GEN_NULL;
+    gen_bool_t stats = gen_false;
+    cio_vm_settings_t vm_settings = {0};
 
     cio_cli_operation_t operation = CIO_CLI_OPERATION_NONE;
 
@@ -499,6 +606,30 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
                 break;
             }
 
+            case CIO_CLI_SWITCH_EMIT_C: {
+                if(operation) {
+                    error = gen_log(GEN_LOG_LEVEL_FATAL, "cionom-cli", "Multiple operations specified");
+                    if(error) return error;
+
+                    return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "Multiple operations specified");
+                }
+
+                if(!parsed.long_argument_parameters[i] && warn_implicit_switch_parameter) {
+                    error = gen_log_formatted(warning_settings.fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom-cli", "`--%t` parameter not specified, defaulting to `%t` [%twarn_implicit_switch_parameter]", switches[parsed.long_argument_indices[i]], CIO_CLI_C_FILE_FALLBACK, warning_settings.fatal_warnings ? "fatal_warnings, " : "");
+                    if(error) return error;
+
+                    if(warning_settings.fatal_warnings) {
+                        return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` parameter not specified, defaulting to `%t` [%twarn_implicit_switch_parameter]", switches[parsed.long_argument_indices[i]], CIO_CLI_C_FILE_FALLBACK, warning_settings.fatal_warnings ? "fatal_warnings, " : "");
+                    }
+                }
+
+                file = parsed.long_argument_parameters[i] ?: CIO_CLI_C_FILE_FALLBACK;
+
+                operation = CIO_CLI_OPERATION_EMIT_C;
+
+                break;
+            }
+
             case CIO_CLI_SWITCH_VERSION: {
                 if(operation) {
                     error = gen_log(GEN_LOG_LEVEL_FATAL, "cionom-cli", "Multiple operations specified");
@@ -555,6 +686,122 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
                 break;
             }
 
+            case CIO_CLI_SWITCH_PROFILE: {
+                if(!parsed.long_argument_parameters[i]) {
+                    error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "`--%t` expected a parameter", switches[parsed.long_argument_indices[i]]);
+                    if(error) return error;
+
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` expected a parameter", switches[parsed.long_argument_indices[i]]);
+                }
+                if(profile_file) {
+                    error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "`--%t` specified multiple times", switches[parsed.long_argument_indices[i]]);
+                    if(error) return error;
+
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` specified multiple times", switches[parsed.long_argument_indices[i]]);
+                }
+
+                profile_file = parsed.long_argument_parameters[i];
+                vm_settings.profile = gen_true;
+
+                break;
+            }
+
+            case CIO_CLI_SWITCH_SAMPLE: {
+                if(!parsed.long_argument_parameters[i]) {
+                    error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "`--%t` expected a parameter", switches[parsed.long_argument_indices[i]]);
+                    if(error) return error;
+
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` expected a parameter", switches[parsed.long_argument_indices[i]]);
+                }
+                if(sample_file) {
+                    error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "`--%t` specified multiple times", switches[parsed.long_argument_indices[i]]);
+                    if(error) return error;
+
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` specified multiple times", switches[parsed.long_argument_indices[i]]);
+                }
+
+                sample_file = parsed.long_argument_parameters[i];
+
+                break;
+            }
+
+            case CIO_CLI_SWITCH_STATS: {
+                if(parsed.long_argument_parameters[i]) {
+                    error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "`--%t` does not take a parameter", switches[parsed.long_argument_indices[i]]);
+                    if(error) return error;
+
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` does not take a parameter", switches[parsed.long_argument_indices[i]]);
+                }
+#if !CIO_VM_STATS
+                error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "`--%t` requires a build with `CIONOM_STATS=1`", switches[parsed.long_argument_indices[i]]);
+                if(error) return error;
+
+                return gen_error_attach_backtrace_formatted(GEN_ERROR_NOT_IMPLEMENTED, GEN_LINE_NUMBER, "`--%t` requires a build with `CIONOM_STATS=1`", switches[parsed.long_argument_indices[i]]);
+#endif
+
+                stats = gen_true;
+
+                break;
+            }
+
+            case CIO_CLI_SWITCH_VM_SETTING: {
+                if(!parsed.long_argument_parameters[i]) {
+                    error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "`--%t` expected a parameter", switches[parsed.long_argument_indices[i]]);
+                    if(error) return error;
+
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` expected a parameter", switches[parsed.long_argument_indices[i]]);
+                }
+
+                gen_bool_t equal = gen_false;
+                error = gen_string_compare("trampoline", sizeof("trampoline"), parsed.long_argument_parameters[i], parsed.long_argument_parameter_lengths[i] + 1, GEN_STRING_NO_BOUNDS, &equal);
+                if(error) return error;
+                if(equal && vm_settings.trampoline) return gen_error_attach_backtrace(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "`--vm-setting=trampoline` specified multiple times");
+                if(equal) {
+                    vm_settings.trampoline = gen_true;
+                    break;
+                }
+                error = gen_string_compare("tail_calls", sizeof("tail_calls"), parsed.long_argument_parameters[i], parsed.long_argument_parameter_lengths[i] + 1, GEN_STRING_NO_BOUNDS, &equal);
+                if(error) return error;
+                if(equal && vm_settings.tail_calls) return gen_error_attach_backtrace(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "`--vm-setting=tail_calls` specified multiple times");
+                if(equal) {
+                    vm_settings.tail_calls = gen_true;
+                    break;
+                }
+                error = gen_string_compare("scrub_stack", sizeof("scrub_stack"), parsed.long_argument_parameters[i], parsed.long_argument_parameter_lengths[i] + 1, GEN_STRING_NO_BOUNDS, &equal);
+                if(error) return error;
+                if(equal && vm_settings.scrub_stack) return gen_error_attach_backtrace(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "`--vm-setting=scrub_stack` specified multiple times");
+                if(equal) {
+                    vm_settings.scrub_stack = gen_true;
+                    break;
+                }
+                error = gen_string_compare("no_intrinsics", sizeof("no_intrinsics"), parsed.long_argument_parameters[i], parsed.long_argument_parameter_lengths[i] + 1, GEN_STRING_NO_BOUNDS, &equal);
+                if(error) return error;
+                if(equal && vm_settings.no_intrinsics) return gen_error_attach_backtrace(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "`--vm-setting=no_intrinsics` specified multiple times");
+                if(equal) {
+                    vm_settings.no_intrinsics = gen_true;
+                    break;
+                }
+                error = gen_string_compare("jit", sizeof("jit"), parsed.long_argument_parameters[i], parsed.long_argument_parameter_lengths[i] + 1, GEN_STRING_NO_BOUNDS, &equal);
+                if(error) return error;
+                if(equal && vm_settings.jit) return gen_error_attach_backtrace(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "`--vm-setting=jit` specified multiple times");
+                if(equal) {
+                    vm_settings.jit = gen_true;
+                    break;
+                }
+                error = gen_string_compare("jit_perf_map", sizeof("jit_perf_map"), parsed.long_argument_parameters[i], parsed.long_argument_parameter_lengths[i] + 1, GEN_STRING_NO_BOUNDS, &equal);
+                if(error) return error;
+                if(equal && vm_settings.jit_perf_map) return gen_error_attach_backtrace(GEN_ERROR_TOO_LONG, GEN_LINE_NUMBER, "`--vm-setting=jit_perf_map` specified multiple times");
+                if(equal) {
+                    vm_settings.jit_perf_map = gen_true;
+                    break;
+                }
+
+                error = gen_log_formatted(GEN_LOG_LEVEL_FATAL, "cionom-cli", "Unknown VM setting `%tz`", parsed.long_argument_parameters[i], parsed.long_argument_parameter_lengths[i]);
+                if(error) return error;
+
+                return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "Unknown VM setting");
+            }
+
             default: return gen_error_attach_backtrace(GEN_ERROR_UNKNOWN, GEN_LINE_NUMBER, "Something went wrong while parsing arguments");
         }
     }
@@ -586,27 +833,41 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
             error = gen_string_length(source_file, GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &filename_length);
             if(error) return error;
 
-            gen_size_t source_length = 0;
-            char* source = GEN_NULL;
-            error = cio_cli_read_file(source_file, (unsigned char**) &source, &source_length);
+            // The source is streamed through rather than read in whole, so memory use doesn't grow with its length
+            // `cio_module_emit_stream` reads the source twice, so it must be a regular file rather than a pipe
+            GEN_CLEANUP_FUNCTION(cio_cli_stream_file_cleanup) cio_cli_stream_file_t source = {0};
+            error = gen_filesystem_handle_open(source_file, GEN_STRING_NO_BOUNDS, &source.handle);
             if(error) return error;
+            source.open = gen_true;
 
-			cio_token_t* tokens = GEN_NULL;
-			gen_size_t tokens_length = 0;
-			error = cio_tokenize(source, source_length, &tokens, &tokens_length);
-			if(error) return error;
+            error = gen_filesystem_handle_lock(&source.handle);
+            if(error) return error;
+            source.locked = gen_true;
 
-			cio_program_t program = {0};
-			error = cio_parse(tokens, tokens_length, &program, source, source_length, source_file, filename_length, &warning_settings);
-			if(error) return error;
+            error = gen_filesystem_handle_file_size(&source.handle, &source.size);
+            if(error) return error;
 
-			unsigned char* bytecode = GEN_NULL;
-			gen_size_t bytecode_length = 0;
-			error = cio_module_emit(&program, &bytecode, &bytecode_length, source, source_length, source_file, filename_length, &warning_settings);
-			if(error) return error;
+            GEN_CLEANUP_FUNCTION(cio_cli_stream_file_cleanup) cio_cli_stream_file_t output = {0};
+            error = cio_cli_recreate_open_file(file, &output.handle);
+            if(error) return error;
+            output.open = gen_true;
+            output.locked = gen_true;
 
-            error = cio_cli_recreate_write_file(file, bytecode, bytecode_length);
-			if(error) return error;
+            error = cio_module_emit_stream(cio_cli_stream_read, &source, cio_cli_stream_write, &output, source_file, filename_length, &warning_settings);
+            if(error) {
+                // Don't leave partially emitted bytecode behind
+                gen_error_t* delete_error = cio_cli_stream_file_close(&output);
+                if(!delete_error) delete_error = gen_filesystem_path_delete(file, GEN_STRING_NO_BOUNDS);
+                if(delete_error) gen_error_print("cionom-cli", delete_error, GEN_ERROR_SEVERITY_WARNING);
+
+                return error;
+            }
+
+            error = cio_cli_stream_file_close(&output);
+            if(error) return error;
+
+            error = cio_cli_stream_file_close(&source);
+            if(error) return error;
 
             break;
         }
@@ -642,13 +903,9 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
             }
             stack_length = stack_length != GEN_SIZE_MAX ? stack_length : CIO_CLI_STACK_LENGTH_FALLBACK;
 
-            gen_size_t bytecode_length = 0;
-            unsigned char* bytecode = GEN_NULL;
-            error = cio_cli_read_file(bytecode_file, (unsigned char**) &bytecode, &bytecode_length);
-            if(error) return error;
-
+            // The bundle is executed directly from its mapping rather than a copy
 			cio_vm_t vm = {0};
-			error = cio_vm_initialize((unsigned char*) bytecode, bytecode_length, stack_length, gen_true, &vm, debug_vm, &warning_settings);
+			error = cio_vm_initialize_from_file(bytecode_file, stack_length, gen_true, &vm, debug_vm, &warning_settings, &vm_settings);
 			if(error) return error;
 
 			error = cio_vm_push_frame(&vm);
@@ -660,10 +917,93 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
             error = cio_vm_get_identifier(&vm, entry_routine, &callable, gen_false);
 			if(error) return error;
 
+            if(sample_file) {
+                error = cio_vm_start_sampling(&vm, CIO_SAMPLE_FREQUENCY_DEFAULT, CIO_SAMPLE_CAPACITY_DEFAULT);
+                if(error) return error;
+            }
+
             vm.current_bytecode = callable->bytecode_index;
 			error = cio_vm_dispatch_call(&vm, callable->routine_index, 0);
 			if(error) return error;
 
+            // Coroutines started by the program run to completion before exiting
+            error = cio_vm_run_coroutines(&vm);
+			if(error) return error;
+
+            if(sample_file) {
+                error = cio_vm_stop_sampling(&vm);
+                if(error) return error;
+
+                char* folded = GEN_NULL;
+                gen_size_t folded_length = 0;
+                gen_size_t dropped = 0;
+                error = cio_vm_emit_samples(&vm, &folded, &folded_length, &dropped);
+                if(error) return error;
+
+                if(dropped) {
+                    error = gen_log_formatted(GEN_LOG_LEVEL_WARNING, "cionom-cli", "%uz samples were dropped", dropped);
+                    if(error) return error;
+                }
+
+                // Short runs may not have been sampled at all
+                error = cio_cli_recreate_write_file(sample_file, (unsigned char*) (folded ?: ""), folded_length);
+                if(error) return error;
+
+                if(folded) {
+                    error = gen_memory_free((void**) &folded);
+                    if(error) return error;
+                }
+            }
+
+            if(profile_file) {
+                char* summary = GEN_NULL;
+                gen_size_t summary_length = 0;
+                char* folded = GEN_NULL;
+                gen_size_t folded_length = 0;
+                error = cio_vm_emit_profile(&vm, &summary, &summary_length, &folded, &folded_length);
+                if(error) return error;
+
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Profile:\n%t", summary);
+                if(error) return error;
+
+                // Nothing may have run long enough to be measured
+                error = cio_cli_recreate_write_file(profile_file, (unsigned char*) (folded ?: ""), folded_length);
+                if(error) return error;
+
+                error = gen_memory_free((void**) &summary);
+                if(error) return error;
+
+                if(folded) {
+                    error = gen_memory_free((void**) &folded);
+                    if(error) return error;
+                }
+            }
+
+            if(stats) {
+                cio_vm_stats_t vm_stats = {0};
+                error = cio_vm_get_stats(&vm, &vm_stats);
+                if(error) return error;
+
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Instructions executed: %uz", vm_stats.instructions);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Pushes: %uz", vm_stats.pushes);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Cíonom calls: %uz", vm_stats.cionom_calls);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "External calls: %uz", vm_stats.external_calls);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Cross-module calls: %uz", vm_stats.cross_module_calls);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Extension markers: %uz", vm_stats.extension_markers);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Peak frame depth: %uz", vm_stats.peak_frame_depth);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Peak stack height: %uz of %uz", vm_stats.peak_stack_height, stack_length);
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "Resolution time: %uz ns", vm_stats.resolution_time);
+                if(error) return error;
+            }
+
             break;
         }
         case CIO_CLI_OPERATION_MANGLE: {
@@ -710,13 +1050,8 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
 
             bytecode_file = parsed.raw_argument_count ? (argv + 1)[parsed.raw_argument_indices[0]] : CIO_CLI_BYTECODE_FILE_FALLBACK;
 
-            gen_size_t bytecode_length = 0;
-            unsigned char* bytecode = GEN_NULL;
-            error = cio_cli_read_file(bytecode_file, (unsigned char**) &bytecode, &bytecode_length);
-            if(error) return error;
-
             cio_vm_t vm = {0};
-            error = cio_vm_initialize(bytecode, bytecode_length, 1, gen_false, &vm, gen_false, &warning_settings);
+            error = cio_vm_initialize_from_file(bytecode_file, 1, gen_false, &vm, gen_false, &warning_settings, GEN_NULL);
             if(error) return error;
 
             if(vm.bytecode_length != 1) {
@@ -915,6 +1250,52 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
             break;
         }
 
+        case CIO_CLI_OPERATION_EMIT_C: {
+            if(parsed.raw_argument_count > 1) {
+                error = gen_log(GEN_LOG_LEVEL_FATAL, "cionom-cli", "Multiple files specified");
+                if(error) return error;
+
+                return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "Multiple files specified");
+            }
+
+            const char* bytecode_file = GEN_NULL;
+
+            if(!parsed.raw_argument_count && warn_implicit_file) {
+                error = gen_log_formatted(warning_settings.fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom-cli", "Bytecode bundle not specified, defaulting to `%t` [%twarn_implicit_file]", CIO_CLI_BUNDLE_FILE_FALLBACK, warning_settings.fatal_warnings ? "fatal_warnings, " : "");
+                if(error) return error;
+
+                if(warning_settings.fatal_warnings) {
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "Bytecode file not specified, defaulting to `%t` [%twarn_implicit_file]", CIO_CLI_BUNDLE_FILE_FALLBACK, warning_settings.fatal_warnings ? "fatal_warnings, " : "");
+                }
+            }
+
+            bytecode_file = parsed.raw_argument_count ? (argv + 1)[parsed.raw_argument_indices[0]] : CIO_CLI_BUNDLE_FILE_FALLBACK;
+
+            if(stack_length == GEN_SIZE_MAX && warn_implicit_switch) {
+                error = gen_log_formatted(warning_settings.fatal_warnings ? GEN_LOG_LEVEL_FATAL : GEN_LOG_LEVEL_WARNING, "cionom-cli", "`--%t` not specified, defaulting to %uz [%twarn_implicit_switch]", switches[CIO_CLI_SWITCH_STACK_LENGTH], (gen_size_t) CIO_CLI_STACK_LENGTH_FALLBACK, warning_settings.fatal_warnings ? "fatal_warnings, " : "");
+                if(error) return error;
+
+                if(warning_settings.fatal_warnings) {
+                    return gen_error_attach_backtrace_formatted(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`--%t` not specified, defaulting to %uz [%twarn_implicit_switch]", switches[CIO_CLI_SWITCH_STACK_LENGTH], (gen_size_t) CIO_CLI_STACK_LENGTH_FALLBACK, warning_settings.fatal_warnings ? "fatal_warnings, " : "");
+                }
+            }
+            stack_length = stack_length != GEN_SIZE_MAX ? stack_length : CIO_CLI_STACK_LENGTH_FALLBACK;
+
+            // Externals are resolved so that calls between modules are translated to their targets
+            cio_vm_t vm = {0};
+            error = cio_vm_initialize_from_file(bytecode_file, 1, gen_true, &vm, gen_false, &warning_settings, GEN_NULL);
+            if(error) return error;
+
+            char* source = GEN_NULL;
+            gen_size_t source_length = 0;
+            error = cio_vm_emit_c(&vm, vm.image->file, vm.image->file_length, stack_length, CIO_CLI_ENTRY_ROUTINE_FALLBACK, &source, &source_length);
+            if(error) return error;
+
+            error = cio_cli_recreate_write_file(file, (unsigned char*) source, source_length);
+            if(error) return error;
+
+            break;
+        }
         case CIO_CLI_OPERATION_HELP: {
             const gen_size_t option_pad = 35;
             const gen_size_t suboption_pad = 30;
@@ -936,6 +1317,8 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
             if(error) return error;
             error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t BUNDLE%czExtracts bytecode files from the bundled executable `BUNDLE` - otherwise %t\n%czPlaces output into `N.ibc` where `N` was the index of the module in the bundle", switches[CIO_CLI_SWITCH_DEBUNDLE], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_DEBUNDLE] + sizeof(" BUNDLE") - 1), CIO_CLI_BUNDLE_FILE_FALLBACK, ' ', GEN_LOG_RISING_EDGE_LENGTH + option_pad);
             if(error) return error;
+            error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t[=FILE] BUNDLE%czTranslates the bundled executable `BUNDLE` to C - otherwise %t\n%czPlaces output into `FILE` - otherwise %t", switches[CIO_CLI_SWITCH_EMIT_C], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_EMIT_C] + sizeof("[=FILE] BUNDLE") - 1), CIO_CLI_BUNDLE_FILE_FALLBACK, ' ', GEN_LOG_RISING_EDGE_LENGTH + option_pad, CIO_CLI_C_FILE_FALLBACK);
+            if(error) return error;
             error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t%czPrints version information", switches[CIO_CLI_SWITCH_VERSION], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_VERSION]));
             if(error) return error;
             error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t%czTreats all warnings as fatal", switches[CIO_CLI_SWITCH_FATAL_WARNINGS], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_FATAL_WARNINGS]));
@@ -962,6 +1345,28 @@ static gen_error_t* gen_main(const gen_size_t argc, const char* const restrict*
                 error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "\tconsume_reserved_encoding%czWarn on consumption of reserved bytecode encodings", ' ', suboption_pad - (sizeof("consume_reserved_encoding") - 1));
                 if(error) return error;
             }
+            error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t=SETTING%czEnables the VM setting `SETTING` when executing bundled executables. Available settings are listed below:", switches[CIO_CLI_SWITCH_VM_SETTING], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_VM_SETTING] + sizeof("=SETTING") - 1));
+            if(error) return error;
+            {
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "\ttrampoline%czDispatch calls between Cíonom routines without recursing natively", ' ', suboption_pad - (sizeof("trampoline") - 1));
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "\ttail_calls%czReuse the current frame for calls directly preceding a return", ' ', suboption_pad - (sizeof("tail_calls") - 1));
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "\tscrub_stack%czZero stack frames as they are popped (for debugging)", ' ', suboption_pad - (sizeof("scrub_stack") - 1));
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "\tno_intrinsics%czAlways call the native implementations of core routines", ' ', suboption_pad - (sizeof("no_intrinsics") - 1));
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "\tjit%czCompile routines to native code where supported", ' ', suboption_pad - (sizeof("jit") - 1));
+                if(error) return error;
+                error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "\tjit_perf_map%czWrite a perf map for compiled routines", ' ', suboption_pad - (sizeof("jit_perf_map") - 1));
+                if(error) return error;
+            }
+            error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t=FILE%czProfiles calls when executing bundled executables\n%czPrints a summary and places folded call stacks into `FILE`", switches[CIO_CLI_SWITCH_PROFILE], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_PROFILE] + sizeof("=FILE") - 1), ' ', GEN_LOG_RISING_EDGE_LENGTH + option_pad);
+            if(error) return error;
+            error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t=FILE%czSamples the call stack %ui times per second of CPU time when executing bundled executables\n%czPlaces the number of samples of each call stack into `FILE` as folded call stacks", switches[CIO_CLI_SWITCH_SAMPLE], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_SAMPLE] + sizeof("=FILE") - 1), CIO_SAMPLE_FREQUENCY_DEFAULT, ' ', GEN_LOG_RISING_EDGE_LENGTH + option_pad);
+            if(error) return error;
+            error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t%czPrints execution statistics after executing bundled executables\n%czOnly available in builds made with `CIONOM_STATS=1`", switches[CIO_CLI_SWITCH_STATS], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_STATS]), ' ', GEN_LOG_RISING_EDGE_LENGTH + option_pad);
+            if(error) return error;
             error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom-cli", "--%t%czShow this menu", switches[CIO_CLI_SWITCH_HELP], ' ', option_pad - (2 + switches_lengths[CIO_CLI_SWITCH_HELP]));
             if(error) return error;
 
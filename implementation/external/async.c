@@ -0,0 +1,405 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include "include/extlib_detail.h"
+
+#include <cioextlib.h>
+#include <cionom.h>
+
+#include <genmemory.h>
+
+#if defined(__linux__)
+
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+typedef enum {
+    CIO_EXTLIB_IO_READ,
+    CIO_EXTLIB_IO_WRITE,
+    CIO_EXTLIB_IO_SLEEP
+} cio_extlib_io_operation_t;
+
+// An I/O operation, which is attempted without blocking and otherwise waited on in the event loop
+typedef struct cio_extlib_io_t {
+    cio_extlib_io_operation_t operation;
+    int fd;
+    unsigned char* buffer;
+    gen_size_t length;
+
+    // The cell to store the result in - parked coroutines' stack segments do not move
+    gen_size_t* reserve;
+    cio_coroutine_t* coroutine;
+
+    // Timers are read into here rather than the caller's stack
+    gen_uint64_t expirations;
+
+    // Whether `fd` is a duplicate made to wait on a descriptor another operation is already waiting on
+    gen_bool_t duplicate;
+
+    // Operations waiting in the event loop are listed so those left when the VM is freed can be released
+    struct cio_extlib_io_t* previous;
+    struct cio_extlib_io_t* next;
+} cio_extlib_io_t;
+
+// The number of events handled per wait
+#define CIO_EXTLIB_EVENTS_LENGTH 64
+
+static gen_error_t* cio_extlib_internal_io_attempt(cio_extlib_io_t* const restrict io, gen_bool_t* const restrict out_complete) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_io_attempt, GEN_FILE_NAME);
+	if(error) return error;
+
+    *out_complete = gen_false;
+
+    // Descriptors may be shared with other users, so are only made non-blocking for the duration of the operation
+    const int flags = fcntl(io->fd, F_GETFL);
+    if(flags == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not get descriptor flags: %t", gen_error_description_from_errno());
+    if(!(flags & O_NONBLOCK) && fcntl(io->fd, F_SETFL, flags | O_NONBLOCK) == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not set descriptor flags: %t", gen_error_description_from_errno());
+
+    ssize_t result = 0;
+    switch(io->operation) {
+        case CIO_EXTLIB_IO_READ: result = read(io->fd, io->buffer, io->length); break;
+        case CIO_EXTLIB_IO_WRITE: result = write(io->fd, io->buffer, io->length); break;
+        case CIO_EXTLIB_IO_SLEEP: result = read(io->fd, &io->expirations, sizeof(io->expirations)); break;
+    }
+    const int result_errno = errno;
+
+    if(!(flags & O_NONBLOCK) && fcntl(io->fd, F_SETFL, flags) == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not restore descriptor flags: %t", gen_error_description_from_errno());
+
+    if(result == -1) {
+        if(result_errno == EAGAIN || result_errno == EWOULDBLOCK || result_errno == EINTR) return GEN_NULL;
+
+        errno = result_errno;
+        return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not %t descriptor %uz: %t", io->operation == CIO_EXTLIB_IO_WRITE ? "write to" : "read from", (gen_size_t) io->fd, gen_error_description_from_errno());
+    }
+
+    if(io->operation != CIO_EXTLIB_IO_SLEEP) *io->reserve = (gen_size_t) result;
+
+    *out_complete = gen_true;
+
+    return GEN_NULL;
+}
+
+// Closes the descriptor an operation owns - its timer, or the duplicate it waited on
+static gen_error_t* cio_extlib_internal_io_close(const cio_extlib_io_t* const restrict io) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_io_close, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(io->operation != CIO_EXTLIB_IO_SLEEP && !io->duplicate) return GEN_NULL;
+
+    if(close(io->fd) == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not close descriptor %uz: %t", (gen_size_t) io->fd, gen_error_description_from_errno());
+
+    return GEN_NULL;
+}
+
+static void cio_extlib_internal_io_unlink(cio_extlib_data_t* const restrict data, cio_extlib_io_t* const restrict io) {
+    if(io->previous) io->previous->next = io->next;
+    else data->io_pending = io->next;
+    if(io->next) io->next->previous = io->previous;
+
+    io->previous = GEN_NULL;
+    io->next = GEN_NULL;
+}
+
+// Blocks until an operation completes, as there is nothing else to run outside of a coroutine
+static gen_error_t* cio_extlib_internal_io_wait(cio_extlib_io_t* const restrict io) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_io_wait, GEN_FILE_NAME);
+	if(error) return error;
+
+    const unsigned events = io->operation == CIO_EXTLIB_IO_WRITE ? EPOLLOUT : EPOLLIN;
+
+    gen_bool_t complete = gen_false;
+    while(!complete) {
+        struct pollfd descriptor = {io->fd, (short) events, 0};
+        if(poll(&descriptor, 1, -1) == -1 && errno != EINTR) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not wait on descriptor: %t", gen_error_description_from_errno());
+
+        error = cio_extlib_internal_io_attempt(io, &complete);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+// Registers an operation with the event loop and parks the running coroutine until it completes
+// On failure nothing is left registered, and any duplicate made is closed
+static gen_error_t* cio_extlib_internal_io_park(cio_vm_t* const restrict vm, const cio_extlib_io_t* const restrict io) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_io_park, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_extlib_data_t* const data = vm->external_lib_storage;
+    if(!data->event_loop_open) {
+        data->event_loop = epoll_create1(EPOLL_CLOEXEC);
+        if(data->event_loop == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not create event loop: %t", gen_error_description_from_errno());
+        data->event_loop_open = gen_true;
+    }
+
+    cio_extlib_io_t* pending = GEN_NULL;
+    error = gen_memory_allocate_zeroed((void**) &pending, 1, sizeof(cio_extlib_io_t));
+    if(error) return error;
+    *pending = *io;
+
+    struct epoll_event event = {0};
+    event.events = (io->operation == CIO_EXTLIB_IO_WRITE ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+    event.data.ptr = pending;
+    int added = epoll_ctl(data->event_loop, EPOLL_CTL_ADD, pending->fd, &event);
+
+    // A descriptor can only be registered once, but a duplicate of it is registered separately
+    // This lets several coroutines wait on the same descriptor, e.g. one reading and one writing a socket
+    if(added == -1 && errno == EEXIST) {
+        const int duplicate = fcntl(pending->fd, F_DUPFD_CLOEXEC, 0);
+        if(duplicate != -1) {
+            pending->fd = duplicate;
+            pending->duplicate = gen_true;
+            added = epoll_ctl(data->event_loop, EPOLL_CTL_ADD, pending->fd, &event);
+        }
+    }
+
+    if(added == -1) {
+        error = gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not wait on descriptor %uz: %t", (gen_size_t) io->fd, gen_error_description_from_errno());
+
+        gen_error_t* const close_error = pending->duplicate ? cio_extlib_internal_io_close(pending) : GEN_NULL;
+        if(close_error) gen_error_print("cionom-external", close_error, GEN_ERROR_SEVERITY_WARNING);
+
+        gen_error_t* const free_error = gen_memory_free((void**) &pending);
+        if(free_error) gen_error_print("cionom-external", free_error, GEN_ERROR_SEVERITY_WARNING);
+
+        return error;
+    }
+
+    pending->next = data->io_pending;
+    if(data->io_pending) data->io_pending->previous = pending;
+    data->io_pending = pending;
+
+    error = cio_vm_park_coroutine(vm, &pending->coroutine);
+    if(error) {
+        if(epoll_ctl(data->event_loop, EPOLL_CTL_DEL, pending->fd, GEN_NULL) == -1) {
+            gen_error_t* const delete_error = gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not stop waiting on descriptor %uz: %t", (gen_size_t) pending->fd, gen_error_description_from_errno());
+            gen_error_print("cionom-external", delete_error, GEN_ERROR_SEVERITY_WARNING);
+        }
+
+        cio_extlib_internal_io_unlink(data, pending);
+
+        gen_error_t* const close_error = pending->duplicate ? cio_extlib_internal_io_close(pending) : GEN_NULL;
+        if(close_error) gen_error_print("cionom-external", close_error, GEN_ERROR_SEVERITY_WARNING);
+
+        gen_error_t* const free_error = gen_memory_free((void**) &pending);
+        if(free_error) gen_error_print("cionom-external", free_error, GEN_ERROR_SEVERITY_WARNING);
+
+        return error;
+    }
+
+    return GEN_NULL;
+}
+
+// Performs an operation, parking the running coroutine until it can complete if it would block
+// Timers belong to the operation, so are closed however it ends
+static gen_error_t* cio_extlib_internal_io_submit(cio_vm_t* const restrict vm, const cio_extlib_io_t* const restrict io) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_io_submit, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_extlib_io_t attempt = *io;
+    gen_bool_t complete = gen_false;
+    error = cio_extlib_internal_io_attempt(&attempt, &complete);
+
+    if(!error && !complete) {
+        if(vm->coroutine) {
+            // The timer is closed by the event loop once it expires
+            error = cio_extlib_internal_io_park(vm, &attempt);
+            if(!error) return GEN_NULL;
+        }
+        else error = cio_extlib_internal_io_wait(&attempt);
+    }
+
+    gen_error_t* const close_error = cio_extlib_internal_io_close(&attempt);
+    if(error) {
+        if(close_error) gen_error_print("cionom-external", close_error, GEN_ERROR_SEVERITY_WARNING);
+        return error;
+    }
+
+    return close_error;
+}
+
+// Releases the operations still waiting in the event loop and closes it, if open
+// The coroutines waiting on them are woken so that they are freed with the VM's others
+gen_error_t* cio_extlib_internal_event_loop_free(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_event_loop_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_extlib_data_t* const data = vm->external_lib_storage;
+    if(!data->event_loop_open) return GEN_NULL;
+
+    while(data->io_pending) {
+        cio_extlib_io_t* io = data->io_pending;
+        cio_extlib_internal_io_unlink(data, io);
+
+        if(io->coroutine && io->coroutine->parked) {
+            error = cio_vm_wake_coroutine(vm, io->coroutine);
+            if(error) return error;
+        }
+
+        error = cio_extlib_internal_io_close(io);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &io);
+        if(error) return error;
+    }
+
+    if(close(data->event_loop) == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not close event loop: %t", gen_error_description_from_errno());
+    data->event_loop_open = gen_false;
+
+    return GEN_NULL;
+}
+
+CIO_EXTLIB_BEGIN_DEFS
+
+// Completes operations as their descriptors become ready and wakes the coroutines waiting on them
+gen_error_t* __cionom_extlib_on_idle(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) __cionom_extlib_on_idle, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_extlib_data_t* const data = vm->external_lib_storage;
+    if(!data->event_loop_open) return gen_error_attach_backtrace(GEN_ERROR_BAD_OPERATION, GEN_LINE_NUMBER, "Coroutines are parked with no I/O to wait on");
+
+    struct epoll_event events[CIO_EXTLIB_EVENTS_LENGTH] = {0};
+    const int ready = epoll_wait(data->event_loop, events, CIO_EXTLIB_EVENTS_LENGTH, -1);
+    if(ready == -1) {
+        if(errno == EINTR) return GEN_NULL;
+        return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not wait on event loop: %t", gen_error_description_from_errno());
+    }
+
+    for(gen_size_t i = 0; i < (gen_size_t) ready; ++i) {
+        cio_extlib_io_t* io = events[i].data.ptr;
+
+        gen_bool_t complete = gen_false;
+        error = cio_extlib_internal_io_attempt(io, &complete);
+        if(error) return error;
+
+        // Readiness can be spurious, in which case the descriptor is rearmed
+        if(!complete) {
+            struct epoll_event event = {0};
+            event.events = (io->operation == CIO_EXTLIB_IO_WRITE ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+            event.data.ptr = io;
+            if(epoll_ctl(data->event_loop, EPOLL_CTL_MOD, io->fd, &event) == -1) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not wait on descriptor %uz: %t", (gen_size_t) io->fd, gen_error_description_from_errno());
+
+            continue;
+        }
+
+        // Timers are closed on completion, which also removes them from the event loop
+        // Duplicates must be removed first, as the descriptor they duplicate keeps their registration alive
+        if(io->operation != CIO_EXTLIB_IO_SLEEP && epoll_ctl(data->event_loop, EPOLL_CTL_DEL, io->fd, GEN_NULL) == -1) {
+            return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not stop waiting on descriptor %uz: %t", (gen_size_t) io->fd, gen_error_description_from_errno());
+        }
+
+        cio_extlib_internal_io_unlink(data, io);
+
+        error = cio_extlib_internal_io_close(io);
+        if(error) return error;
+
+        error = cio_vm_wake_coroutine(vm, io->coroutine);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &io);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+//* `fdread*` - Read from a file descriptor into a buffer. Suspends the calling coroutine until data is available.
+//* @param [0] The stack index of the file descriptor.
+//* @param [1] The stack index of a pointer to the buffer to read into.
+//* @param [2] The stack index of the number of bytes to read at most.
+//* @reserve The number of bytes read, or 0 at the end of the file.
+CIO_EXTLIB_ROUTINE(fdread__cionom_mangled_grapheme_asterisk) {
+    const cio_extlib_io_t io = {CIO_EXTLIB_IO_READ, (int) caller[current[0]], (unsigned char*) caller[current[1]], caller[current[2]], &caller[caller_frame->height - 1], GEN_NULL, 0};
+	gen_error_t* error = cio_extlib_internal_io_submit(vm, &io);
+	CIO_EXTLIB_PROPAGATE(vm, error);
+
+	return CIO_STATUS_OK;
+}
+
+//* `fdwrite*` - Write from a buffer to a file descriptor. Suspends the calling coroutine until the descriptor can be written to.
+//* @param [0] The stack index of the file descriptor.
+//* @param [1] The stack index of a pointer to the buffer to write from.
+//* @param [2] The stack index of the number of bytes to write at most.
+//* @reserve The number of bytes written.
+CIO_EXTLIB_ROUTINE(fdwrite__cionom_mangled_grapheme_asterisk) {
+    const cio_extlib_io_t io = {CIO_EXTLIB_IO_WRITE, (int) caller[current[0]], (unsigned char*) caller[current[1]], caller[current[2]], &caller[caller_frame->height - 1], GEN_NULL, 0};
+	gen_error_t* error = cio_extlib_internal_io_submit(vm, &io);
+	CIO_EXTLIB_PROPAGATE(vm, error);
+
+	return CIO_STATUS_OK;
+}
+
+//* `sleepms` - Wait for a number of milliseconds. Suspends the calling coroutine until the time has passed.
+//* @param [0] The stack index of the number of milliseconds to wait.
+//* @reserve Empty.
+CIO_EXTLIB_ROUTINE(sleepms) {
+    const int timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(timer == -1) CIO_EXTLIB_PROPAGATE(vm, gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not create timer: %t", gen_error_description_from_errno()));
+
+    // A zeroed expiry would disarm the timer
+    const gen_size_t milliseconds = caller[current[0]] ? caller[current[0]] : 1;
+    struct itimerspec expiry = {0};
+    expiry.it_value.tv_sec = (time_t) (milliseconds / 1000);
+    expiry.it_value.tv_nsec = (long) (milliseconds % 1000) * 1000000;
+    if(timerfd_settime(timer, 0, &expiry, GEN_NULL) == -1) {
+        gen_error_t* const error = gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not arm timer: %t", gen_error_description_from_errno());
+        if(close(timer) == -1) {
+            gen_error_t* const close_error = gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not close timer: %t", gen_error_description_from_errno());
+            gen_error_print("cionom-external", close_error, GEN_ERROR_SEVERITY_WARNING);
+        }
+        CIO_EXTLIB_PROPAGATE(vm, error);
+    }
+
+    const cio_extlib_io_t io = {CIO_EXTLIB_IO_SLEEP, timer, GEN_NULL, 0, GEN_NULL, GEN_NULL, 0};
+	gen_error_t* error = cio_extlib_internal_io_submit(vm, &io);
+	CIO_EXTLIB_PROPAGATE(vm, error);
+
+	return CIO_STATUS_OK;
+}
+
+//* `fdpipe` - Create a pipe.
+//* @param [0] The stack index in which to store the file descriptor of the read end.
+//* @param [1] The stack index in which to store the file descriptor of the write end.
+//* @reserve Empty.
+CIO_EXTLIB_ROUTINE(fdpipe) {
+    int fds[2] = {0};
+    if(pipe(fds) == -1) CIO_EXTLIB_PROPAGATE(vm, gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not create pipe: %t", gen_error_description_from_errno()));
+
+    caller[current[0]] = (gen_size_t) fds[0];
+    caller[current[1]] = (gen_size_t) fds[1];
+
+	return CIO_STATUS_OK;
+}
+
+//* `fdclose` - Close a file descriptor.
+//* @param [0] The stack index of the file descriptor.
+//* @reserve Empty.
+CIO_EXTLIB_ROUTINE(fdclose) {
+    if(close((int) caller[current[0]]) == -1) CIO_EXTLIB_PROPAGATE(vm, gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not close descriptor: %t", gen_error_description_from_errno()));
+
+	return CIO_STATUS_OK;
+}
+
+CIO_EXTLIB_END_DEFS
+
+#else
+
+// Asynchronous I/O is only provided on platforms with epoll
+gen_error_t* cio_extlib_internal_event_loop_free(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_event_loop_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    (void) vm;
+
+    return GEN_NULL;
+}
+
+#endif
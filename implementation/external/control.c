@@ -4,6 +4,8 @@
 #include <cioextlib.h>
 #include <cionom.h>
 
+static const cio_fault_t cio_extlib_no_routine = {GEN_ERROR_INVALID_PARAMETER, "No routine index was passed"};
+
 CIO_EXTLIB_BEGIN_DEFS
 
 //* `?` - Branches control flow to a routine based on a condition.
@@ -11,22 +13,14 @@ CIO_EXTLIB_BEGIN_DEFS
 //* @param [1] The index of the routine to branch to if the condition is gen_false.
 //* @param [2] The stack index of the condition.
 //* @reserve Empty.
-gen_error_t* __cionom_mangled_grapheme_question_mark(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) __cionom_mangled_grapheme_question_mark, GEN_FILE_NAME);
-	if(error) return error;
-
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-
-	CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0);
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
-
+CIO_EXTLIB_ROUTINE(__cionom_mangled_grapheme_question_mark) {
 #ifdef __ANALYZER
 #else
-	error = cio_vm_dispatch_call(vm, caller[current[2]] ? current[0] : current[1], 0);
-	if(error) return error;
+	gen_error_t* error = cio_vm_dispatch_call(vm, caller[current[2]] ? current[0] : current[1], 0);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 #endif
 
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 //* `?+-` - Branches control flow to a routine based on a condition.
@@ -34,19 +28,34 @@ gen_error_t* __cionom_mangled_grapheme_question_mark(cio_vm_t* const restrict vm
 //* @param [1] The index of the routine to branch to if the condition is less than zero.
 //* @param [2] The stack index of the condition.
 //* @reserve Empty.
-gen_error_t* __cionom_mangled_grapheme_question_mark__cionom_mangled_grapheme_plus__cionom_mangled_grapheme_minus(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) __cionom_mangled_grapheme_question_mark__cionom_mangled_grapheme_plus__cionom_mangled_grapheme_minus, GEN_FILE_NAME);
-	if(error) return error;
+CIO_EXTLIB_ROUTINE(__cionom_mangled_grapheme_question_mark__cionom_mangled_grapheme_plus__cionom_mangled_grapheme_minus) {
+	gen_error_t* error = cio_vm_dispatch_call(vm, (gen_ssize_t) caller[current[2]] >= 0 ? current[0] : current[1], 0);
+	CIO_EXTLIB_PROPAGATE(vm, error);
+
+	return CIO_STATUS_OK;
+}
+
+//* `go` - Start a routine at an index as a coroutine. The routine executes on its own stack segment, interleaved with other coroutines as they yield.
+//* Requires the `trampoline` VM setting.
+//* @param [0] The stack index of the routine index to start.
+//* @param [...] The parameters to the routine, which are copied.
+//* @reserve Empty.
+CIO_EXTLIB_ROUTINE(go) {
+    if(!vm->frames[vm->frames_used - 1].height) return &cio_extlib_no_routine;
 
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
+	gen_error_t* error = cio_vm_start_coroutine(vm, caller[current[0]], &current[1], vm->frames[vm->frames_used - 1].height - 1);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 
-	CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0);
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
+	return CIO_STATUS_OK;
+}
 
-	error = cio_vm_dispatch_call(vm, (gen_ssize_t) caller[current[2]] >= 0 ? current[0] : current[1], 0);
-	if(error) return error;
+//* `yield` - Suspend the current coroutine to let others run, or run each waiting coroutine once if called outside of one.
+//* @reserve Empty.
+CIO_EXTLIB_ROUTINE(yield) {
+	gen_error_t* error = cio_vm_yield(vm);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 CIO_EXTLIB_END_DEFS
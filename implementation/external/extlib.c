@@ -25,6 +25,37 @@ gen_error_t* __cionom_extlib_on_load(cio_vm_t* const restrict vm) {
     return GEN_NULL;
 }
 
+gen_error_t* __cionom_extlib_on_clone(cio_vm_t* const restrict vm, const cio_vm_t* const restrict source) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) __cionom_extlib_on_clone, GEN_FILE_NAME);
+	if(error) return error;
+
+    error = gen_memory_allocate_zeroed((void**) &vm->external_lib_storage, 1, sizeof(cio_extlib_data_t));
+	if(error) return error;
+
+    // Callables belong to the shared image so remain valid in the clone
+    *(cio_extlib_data_t*) vm->external_lib_storage = *(const cio_extlib_data_t*) source->external_lib_storage;
+
+    // Nothing is waiting in the clone's event loop yet
+    ((cio_extlib_data_t*) vm->external_lib_storage)->event_loop_open = gen_false;
+
+    return GEN_NULL;
+}
+
+gen_error_t* __cionom_extlib_on_free(cio_vm_t* const restrict vm) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) __cionom_extlib_on_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(!vm->external_lib_storage) return GEN_NULL;
+
+    error = cio_extlib_internal_event_loop_free(vm);
+	if(error) return error;
+
+    error = gen_memory_free((void**) &vm->external_lib_storage);
+	if(error) return error;
+
+    return GEN_NULL;
+}
+
 gen_error_t* __cionom_extlib_wrap_call(cio_vm_t* const restrict vm, const cio_routine_function_t call) {
 	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) __cionom_extlib_wrap_call, GEN_FILE_NAME);
 	if(error) return error;
@@ -8,6 +8,16 @@
 
 typedef struct {
     cio_callable_t* exception_callable;
+
+    // The epoll instance coroutines parked in asynchronous I/O wait on, created on first use
+    int event_loop;
+    gen_bool_t event_loop_open;
+
+    // The operations waiting in the event loop
+    struct cio_extlib_io_t* io_pending;
 } cio_extlib_data_t;
 
+// Releases the operations waiting in the event loop of a VM and closes it, if open
+extern gen_error_t* cio_extlib_internal_event_loop_free(cio_vm_t* const restrict vm);
+
 #endif
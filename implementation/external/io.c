@@ -18,89 +18,50 @@ CIO_EXTLIB_BEGIN_DEFS
 //* `printc*` - Print pointer.
 //* @param [0] The stack index containing the pointer to the first character of a GEN_NULL-terminated string.
 //* @reserve Empty.
-gen_error_t* printc__cionom_mangled_grapheme_asterisk(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) printc__cionom_mangled_grapheme_asterisk, GEN_FILE_NAME);
-	if(error) return error;
+CIO_EXTLIB_ROUTINE(printc__cionom_mangled_grapheme_asterisk) {
+	gen_error_t* error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%t", (char*) caller[current[0]]);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-
-	CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0);
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
-
-	error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%t", (char*) caller[current[0]]);
-	if(error) return error;
-
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 //* `printn` - Print value.
 //* @param [0] The value to print.
 //* @reserve Empty.
-gen_error_t* printn(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) printn, GEN_FILE_NAME);
-	if(error) return error;
-
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-
-	CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0);
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
+CIO_EXTLIB_ROUTINE(printn) {
+	gen_error_t* error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%uz", (gen_size_t) current[0]);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 
-	error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%uz", (gen_size_t) current[0]);
-	if(error) return error;
-
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 //* `printnv` - Print value from stack.
 //* @param [0] The stack index containing the value to print.
 //* @reserve Empty.
-gen_error_t* printnv(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) printnv, GEN_FILE_NAME);
-	if(error) return error;
-
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-
-	CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0);
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
-
-	error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%uz", (gen_size_t) caller[current[0]]);
-	if(error) return error;
+CIO_EXTLIB_ROUTINE(printnv) {
+	gen_error_t* error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%uz", (gen_size_t) caller[current[0]]);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 //* `printc` - Print value from stack as a character.
 //* @param [0] The stack index containing the value to print.
 //* @reserve Empty.
-gen_error_t* printc(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) printc, GEN_FILE_NAME);
-	if(error) return error;
+CIO_EXTLIB_ROUTINE(printc) {
+	gen_error_t* error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%c", (char) caller[current[0]]);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-
-	CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0);
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
-
-	error = gen_log_formatted(GEN_LOG_LEVEL_INFO, "cionom", "%c", (char) caller[current[0]]);
-	if(error) return error;
-
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 //* `readn` - Read number from console input.
 //* @reserve The read value.
-gen_error_t* readn(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) readn, GEN_FILE_NAME);
-	if(error) return error;
-
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
-
+CIO_EXTLIB_ROUTINE(readn) {
     char buffer[32 + 1] = {0};
 
-    error = gen_filesystem_handle_file_read(&GEN_FILESYSTEM_HANDLE_STDIN, 0, sizeof(buffer) - 1, (unsigned char*) buffer);
-    if(error) return error;
+    gen_error_t* error = gen_filesystem_handle_file_read(&GEN_FILESYSTEM_HANDLE_STDIN, 0, sizeof(buffer) - 1, (unsigned char*) buffer);
+    CIO_EXTLIB_PROPAGATE(vm, error);
 
     for(gen_size_t i = sizeof(buffer) - 1; i != GEN_SIZE_MAX; --i) {
         char c = buffer[i];
@@ -108,36 +69,28 @@ gen_error_t* readn(cio_vm_t* const restrict vm) {
     }
 
     error = gen_string_number(buffer, sizeof(buffer), GEN_STRING_NO_BOUNDS, &caller[caller_frame->height - 1]);
-    if(error) return error;
+    CIO_EXTLIB_PROPAGATE(vm, error);
 
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 //* `readc*` - Read null terminated string of characters.
 //* @param [0] The stack index of a pointer to a buffer in which to store read characters.
 //* @param [1] The number of characters to read.
 //* @reserve Empty.
-gen_error_t* readc__cionom_mangled_grapheme_asterisk(cio_vm_t* const restrict vm) {
-	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) readc__cionom_mangled_grapheme_asterisk, GEN_FILE_NAME);
-	if(error) return error;
-
-	if(!vm) return gen_error_attach_backtrace(GEN_ERROR_INVALID_PARAMETER, GEN_LINE_NUMBER, "`vm` was `GEN_NULL`");
-
-	CIO_EXTLIB_GET_FRAME_EHD(vm, current, 0);
-	CIO_EXTLIB_GET_FRAME_EHD(vm, caller, 1);
-
+CIO_EXTLIB_ROUTINE(readc__cionom_mangled_grapheme_asterisk) {
 	char* buff = (char*) caller[current[0]];
 
 	char* result = fgets(buff, (int) current[1], stdin);
-    if(!result) return gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not read string from console: %t", gen_error_description_from_errno());
+    if(!result) CIO_EXTLIB_PROPAGATE(vm, gen_error_attach_backtrace_formatted(gen_error_type_from_errno(), GEN_LINE_NUMBER, "Could not read string from console: %t", gen_error_description_from_errno()));
 
 	gen_size_t length = 0;
-	error = gen_string_length(buff, GEN_STRING_NO_BOUNDS, current[1], &length);
-	if(error) return error;
+	gen_error_t* error = gen_string_length(buff, GEN_STRING_NO_BOUNDS, current[1], &length);
+	CIO_EXTLIB_PROPAGATE(vm, error);
 
 	if(buff[length - 1] == '\n') buff[length - 1] = '\0';
 
-	return GEN_NULL;
+	return CIO_STATUS_OK;
 }
 
 CIO_EXTLIB_END_DEFS
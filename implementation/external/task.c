@@ -0,0 +1,468 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2022 Emily "TTG" Banerjee <prs.ttg+cionom@pm.me>
+
+#include <cioextlib.h>
+#include <cionom.h>
+
+#include <genmemory.h>
+
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+
+typedef enum {
+    CIO_EXTLIB_TASK_PENDING,
+    CIO_EXTLIB_TASK_RUNNING,
+    CIO_EXTLIB_TASK_DONE
+} cio_extlib_task_state_t;
+
+typedef struct {
+    // Held by the queue the task is in and by the handle returned from `spawn`
+    gen_size_t references;
+    cio_extlib_task_state_t state;
+
+    cio_image_t* image;
+    gen_size_t stack_length;
+    gen_size_t bytecode_index;
+    gen_size_t routine;
+    gen_size_t* arguments;
+    gen_size_t arguments_length;
+
+    gen_size_t result;
+    gen_bool_t failed;
+    gen_error_t error;
+
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+} cio_extlib_task_t;
+
+// Owners push and pop at the end, thieves take from the beginning
+typedef struct {
+    pthread_mutex_t lock;
+    cio_extlib_task_t** tasks;
+    gen_size_t begin;
+    gen_size_t end;
+    gen_size_t capacity;
+} cio_extlib_deque_t;
+
+typedef struct {
+    pthread_t thread;
+    cio_extlib_deque_t deque;
+
+    // Workers execute tasks on a VM of their own over the task's image
+    cio_vm_t vm;
+    cio_image_t* image;
+} cio_extlib_worker_t;
+
+typedef struct {
+    cio_extlib_worker_t* workers;
+    gen_size_t workers_length;
+
+    // Tasks spawned from threads outside the pool
+    cio_extlib_deque_t injected;
+
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle;
+    gen_size_t queued;
+} cio_extlib_pool_t;
+
+static cio_extlib_pool_t cio_extlib_internal_pool = {0};
+static gen_dynamic_library_handle_t cio_extlib_internal_pool_library = GEN_NULL;
+static pthread_once_t cio_extlib_internal_pool_once = PTHREAD_ONCE_INIT;
+static gen_error_t* cio_extlib_internal_pool_error = GEN_NULL;
+static _Thread_local cio_extlib_worker_t* cio_extlib_internal_current_worker = GEN_NULL;
+static const cio_fault_t cio_extlib_no_routine = {GEN_ERROR_INVALID_PARAMETER, "No routine index was passed"};
+
+static gen_error_t* cio_extlib_internal_deque_push(cio_extlib_deque_t* const restrict deque, cio_extlib_task_t* const restrict task) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_deque_push, GEN_FILE_NAME);
+	if(error) return error;
+
+    pthread_mutex_lock(&deque->lock);
+
+    if(deque->begin == deque->end) deque->begin = deque->end = 0;
+
+    if(deque->end == deque->capacity) {
+        const gen_size_t capacity = deque->capacity ? deque->capacity * 2 : 16;
+        error = gen_memory_reallocate_zeroed((void**) &deque->tasks, deque->capacity, capacity, sizeof(cio_extlib_task_t*));
+        if(error) {
+            pthread_mutex_unlock(&deque->lock);
+            return error;
+        }
+        deque->capacity = capacity;
+    }
+
+    deque->tasks[deque->end++] = task;
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return GEN_NULL;
+}
+
+static cio_extlib_task_t* cio_extlib_internal_deque_take(cio_extlib_deque_t* const restrict deque, const gen_bool_t steal) {
+    pthread_mutex_lock(&deque->lock);
+
+    cio_extlib_task_t* task = GEN_NULL;
+    if(deque->begin != deque->end) task = steal ? deque->tasks[deque->begin++] : deque->tasks[--deque->end];
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return task;
+}
+
+// Frees a task along with anything it holds, which may be partially set up
+static gen_error_t* cio_extlib_internal_task_free(cio_extlib_task_t* task) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_task_free, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(task->image) {
+        error = cio_image_release(task->image);
+        if(error) return error;
+    }
+
+    pthread_mutex_destroy(&task->lock);
+    pthread_cond_destroy(&task->done);
+
+    if(task->arguments) {
+        error = gen_memory_free((void**) &task->arguments);
+        if(error) return error;
+    }
+
+    error = gen_memory_free((void**) &task);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
+// A task is released on the way out of `spawn` if anything fails before it is queued
+static void cio_extlib_internal_task_cleanup(cio_extlib_task_t** task) {
+    if(!*task) return;
+
+    gen_error_t* error = cio_extlib_internal_task_free(*task);
+    if(error) {
+        gen_error_print("cionom-external", error, GEN_ERROR_SEVERITY_FATAL);
+        gen_error_abort();
+    }
+}
+
+static gen_error_t* cio_extlib_internal_task_release(cio_extlib_task_t* task) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_task_release, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(__atomic_sub_fetch(&task->references, 1, __ATOMIC_ACQ_REL)) return GEN_NULL;
+
+    return cio_extlib_internal_task_free(task);
+}
+
+// Looks for queued work - the current worker's own tasks first, then tasks spawned outside the pool, then other workers' tasks
+static cio_extlib_task_t* cio_extlib_internal_find_task(void) {
+    cio_extlib_pool_t* const pool = &cio_extlib_internal_pool;
+    cio_extlib_worker_t* const self = cio_extlib_internal_current_worker;
+
+    cio_extlib_task_t* task = GEN_NULL;
+    if(self) task = cio_extlib_internal_deque_take(&self->deque, gen_false);
+    if(!task) task = cio_extlib_internal_deque_take(&pool->injected, gen_true);
+
+    const gen_size_t start = self ? (gen_size_t) (self - pool->workers) + 1 : 0;
+    for(gen_size_t i = 0; !task && i < pool->workers_length; ++i) {
+        cio_extlib_worker_t* const victim = &pool->workers[(start + i) % pool->workers_length];
+        if(victim != self) task = cio_extlib_internal_deque_take(&victim->deque, gen_true);
+    }
+
+    if(task) __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_RELAXED);
+
+    return task;
+}
+
+// Runs a claimed task to completion on a VM over the task's image
+static gen_error_t* cio_extlib_internal_task_execute(cio_vm_t* const restrict vm, cio_extlib_task_t* const restrict task) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_task_execute, GEN_FILE_NAME);
+	if(error) return error;
+
+    const gen_size_t bytecode = vm->current_bytecode;
+    gen_error_t* result = GEN_NULL;
+
+    // Arguments are pushed above the reserve value then orphaned for the callee, as the interpreter does for a call
+    error = cio_vm_push_frame(vm);
+    if(error) return error;
+
+    CIO_EXTLIB_GET_FRAME_EHD(vm, holder, 0);
+
+    result = cio_vm_push(vm);
+    for(gen_size_t i = 0; !result && i < task->arguments_length; ++i) {
+        result = cio_vm_push(vm);
+        if(!result) holder[holder_frame->height - 1] = task->arguments[i];
+    }
+
+    if(!result) {
+        holder_frame->height -= task->arguments_length;
+        vm->current_bytecode = task->bytecode_index;
+        result = cio_vm_dispatch_call(vm, task->routine, task->arguments_length);
+    }
+
+    if(result) {
+        task->failed = gen_true;
+        task->error = *result;
+    }
+    else task->result = holder[0];
+
+    // A failed call may have left its frames behind
+    while(&vm->frames[vm->frames_used - 1] != holder_frame) {
+        error = cio_vm_pop_frame(vm);
+        if(error) return error;
+    }
+    error = cio_vm_pop_frame(vm);
+    if(error) return error;
+    vm->current_bytecode = bytecode;
+
+    pthread_mutex_lock(&task->lock);
+    __atomic_store_n(&task->state, CIO_EXTLIB_TASK_DONE, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&task->done);
+    pthread_mutex_unlock(&task->lock);
+
+    return GEN_NULL;
+}
+
+static gen_bool_t cio_extlib_internal_task_claim(cio_extlib_task_t* const restrict task) {
+    cio_extlib_task_state_t expected = CIO_EXTLIB_TASK_PENDING;
+    return __atomic_compare_exchange_n(&task->state, &expected, CIO_EXTLIB_TASK_RUNNING, gen_false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+// Frees the worker's VM, releasing its hold on the image it was running
+static gen_error_t* cio_extlib_internal_worker_discard(cio_extlib_worker_t* const restrict worker) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_worker_discard, GEN_FILE_NAME);
+	if(error) return error;
+
+    if(!worker->image) return GEN_NULL;
+
+    error = cio_vm_free(&worker->vm);
+    if(error) return error;
+
+    worker->vm = (cio_vm_t) {0};
+    worker->image = GEN_NULL;
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_extlib_internal_worker_execute(cio_extlib_worker_t* const restrict worker, cio_extlib_task_t* const restrict task) {
+	GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_extlib_internal_worker_execute, GEN_FILE_NAME);
+	if(error) return error;
+
+    // The worker's VM is only replaced when tasks arrive from a different program
+    if(worker->image != task->image || worker->vm.stack_length != task->stack_length) {
+        error = cio_extlib_internal_worker_discard(worker);
+        if(error) return error;
+
+        error = cio_vm_initialize_from_image(task->image, task->stack_length, &worker->vm);
+        if(error) return error;
+        worker->image = task->image;
+    }
+
+    return cio_extlib_internal_task_execute(&worker->vm, task);
+}
+
+static void* cio_extlib_internal_worker_main(void* const restrict argument) {
+    cio_extlib_pool_t* const pool = &cio_extlib_internal_pool;
+    cio_extlib_worker_t* const worker = argument;
+    cio_extlib_internal_current_worker = worker;
+
+    while(gen_true) {
+        // Idle workers keep no VM, so a program's image is not held past its last task
+        if(!__atomic_load_n(&pool->queued, __ATOMIC_RELAXED)) {
+            gen_error_t* const error = cio_extlib_internal_worker_discard(worker);
+            if(error) {
+                gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+                gen_error_abort();
+            }
+        }
+
+        pthread_mutex_lock(&pool->idle_lock);
+        while(!__atomic_load_n(&pool->queued, __ATOMIC_RELAXED)) pthread_cond_wait(&pool->idle, &pool->idle_lock);
+        pthread_mutex_unlock(&pool->idle_lock);
+
+        cio_extlib_task_t* const task = cio_extlib_internal_find_task();
+        if(!task) continue;
+
+        // Tasks may already have been taken inline by a joiner
+        gen_error_t* error = GEN_NULL;
+        if(cio_extlib_internal_task_claim(task)) error = cio_extlib_internal_worker_execute(worker, task);
+        if(!error) error = cio_extlib_internal_task_release(task);
+
+        if(error) {
+            gen_error_print("cionom", error, GEN_ERROR_SEVERITY_FATAL);
+            gen_error_abort();
+        }
+    }
+
+    return GEN_NULL;
+}
+
+static void cio_extlib_internal_pool_initialize(void) {
+    cio_extlib_pool_t* const pool = &cio_extlib_internal_pool;
+
+    // Workers run this library's code for the rest of the process, so it is kept loaded once the images using it are released
+    static const char external_lib_name[] = "cionom-external";
+    gen_error_t* error = gen_dynamic_library_handle_open(external_lib_name, sizeof(external_lib_name) - 1, &cio_extlib_internal_pool_library);
+    if(error) {
+        cio_extlib_internal_pool_error = error;
+        return;
+    }
+
+    pthread_mutex_init(&pool->injected.lock, GEN_NULL);
+    pthread_mutex_init(&pool->idle_lock, GEN_NULL);
+    pthread_cond_init(&pool->idle, GEN_NULL);
+
+    const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    pool->workers_length = processors > 0 ? (gen_size_t) processors : 1;
+
+    error = gen_memory_allocate_zeroed((void**) &pool->workers, pool->workers_length, sizeof(cio_extlib_worker_t));
+    if(error) {
+        cio_extlib_internal_pool_error = error;
+        return;
+    }
+
+    for(gen_size_t i = 0; i < pool->workers_length; ++i) pthread_mutex_init(&pool->workers[i].deque.lock, GEN_NULL);
+
+    // Workers start with `SIGPROF` blocked so that sampling signals are delivered to the thread being sampled
+    // The signal mask is inherited, so it is only blocked on this thread while they are created
+    sigset_t sampling = {0};
+    sigemptyset(&sampling);
+    sigaddset(&sampling, SIGPROF);
+    sigset_t previous = {0};
+    pthread_sigmask(SIG_BLOCK, &sampling, &previous);
+
+    for(gen_size_t i = 0; i < pool->workers_length; ++i) {
+        if(pthread_create(&pool->workers[i].thread, GEN_NULL, cio_extlib_internal_worker_main, &pool->workers[i])) {
+            cio_extlib_internal_pool_error = gen_error_attach_backtrace(GEN_ERROR_OUT_OF_MEMORY, GEN_LINE_NUMBER, "Failed to start task pool worker");
+            break;
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, GEN_NULL);
+}
+
+CIO_EXTLIB_BEGIN_DEFS
+
+//* `spawn` - Run a routine at an index in parallel. The routine executes on a separate stack over the same program.
+//* @param [0] The stack index of the routine index to spawn.
+//* @param [...] The parameters to the spawned routine, which are copied.
+//* @reserve A handle to the spawned task, which must be passed to `join`.
+CIO_EXTLIB_ROUTINE(spawn) {
+    pthread_once(&cio_extlib_internal_pool_once, cio_extlib_internal_pool_initialize);
+    CIO_EXTLIB_PROPAGATE(vm, cio_extlib_internal_pool_error);
+
+    cio_extlib_pool_t* const pool = &cio_extlib_internal_pool;
+
+    if(!vm->frames[vm->frames_used - 1].height) return &cio_extlib_no_routine;
+    if(caller[current[0]] >= vm->bytecode[vm->current_bytecode].callables_length) {
+        CIO_EXTLIB_PROPAGATE(vm, gen_error_attach_backtrace(GEN_ERROR_OUT_OF_BOUNDS, GEN_LINE_NUMBER, "`callable` was greater than the current module's callables length"));
+    }
+
+    GEN_CLEANUP_FUNCTION(cio_extlib_internal_task_cleanup) cio_extlib_task_t* task = GEN_NULL;
+    gen_error_t* error = gen_memory_allocate_zeroed((void**) &task, 1, sizeof(cio_extlib_task_t));
+    CIO_EXTLIB_PROPAGATE(vm, error);
+
+    pthread_mutex_init(&task->lock, GEN_NULL);
+    pthread_cond_init(&task->done, GEN_NULL);
+
+    task->references = 2;
+    task->state = CIO_EXTLIB_TASK_PENDING;
+    task->stack_length = vm->stack_length;
+    task->bytecode_index = vm->current_bytecode;
+    task->routine = caller[current[0]];
+    task->arguments_length = vm->frames[vm->frames_used - 1].height - 1;
+
+    error = cio_image_retain(vm->image);
+    CIO_EXTLIB_PROPAGATE(vm, error);
+    task->image = vm->image;
+
+    if(task->arguments_length) {
+        error = gen_memory_allocate_zeroed((void**) &task->arguments, task->arguments_length, sizeof(gen_size_t));
+        CIO_EXTLIB_PROPAGATE(vm, error);
+
+        const gen_size_t arguments_size = task->arguments_length * sizeof(gen_size_t);
+        error = gen_memory_copy(task->arguments, arguments_size, &current[1], arguments_size, arguments_size);
+        CIO_EXTLIB_PROPAGATE(vm, error);
+    }
+
+    cio_extlib_worker_t* const self = cio_extlib_internal_current_worker;
+    error = cio_extlib_internal_deque_push(self ? &self->deque : &pool->injected, task);
+    CIO_EXTLIB_PROPAGATE(vm, error);
+
+    // The queue and the handle now own the task
+    cio_extlib_task_t* const handle = task;
+    task = GEN_NULL;
+
+    pthread_mutex_lock(&pool->idle_lock);
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&pool->idle);
+    pthread_mutex_unlock(&pool->idle_lock);
+
+    caller[caller_frame->height - 1] = (gen_size_t) handle;
+
+    return CIO_STATUS_OK;
+}
+
+//* `join` - Wait for a spawned task to finish. Queued tasks are executed by the joining thread while it waits.
+//* @param [0] The stack index of the handle to the task.
+//* @reserve The reserve value of the spawned routine.
+CIO_EXTLIB_ROUTINE(join) {
+    cio_extlib_task_t* const task = (cio_extlib_task_t*) caller[current[0]];
+    gen_error_t* error = GEN_NULL;
+
+    while(__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) != CIO_EXTLIB_TASK_DONE) {
+        // Taking the task inline avoids a round trip through the pool
+        if(cio_extlib_internal_task_claim(task)) {
+            error = cio_extlib_internal_task_execute(vm, task);
+            CIO_EXTLIB_PROPAGATE(vm, error);
+            continue;
+        }
+
+        // Otherwise help with outstanding work rather than blocking a thread the task may depend on
+        cio_extlib_task_t* const other = cio_extlib_internal_find_task();
+        if(other) {
+            if(other->image == vm->image) {
+                if(cio_extlib_internal_task_claim(other)) {
+                    error = cio_extlib_internal_task_execute(vm, other);
+                    CIO_EXTLIB_PROPAGATE(vm, error);
+                }
+
+                error = cio_extlib_internal_task_release(other);
+                CIO_EXTLIB_PROPAGATE(vm, error);
+            }
+            else {
+                // Tasks for other programs cannot run on this VM so are handed back to the pool
+                error = cio_extlib_internal_deque_push(&cio_extlib_internal_pool.injected, other);
+                CIO_EXTLIB_PROPAGATE(vm, error);
+
+                pthread_mutex_lock(&cio_extlib_internal_pool.idle_lock);
+                __atomic_add_fetch(&cio_extlib_internal_pool.queued, 1, __ATOMIC_RELAXED);
+                pthread_cond_signal(&cio_extlib_internal_pool.idle);
+                pthread_mutex_unlock(&cio_extlib_internal_pool.idle_lock);
+            }
+
+            continue;
+        }
+
+        pthread_mutex_lock(&task->lock);
+        while(__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) != CIO_EXTLIB_TASK_DONE) pthread_cond_wait(&task->done, &task->lock);
+        pthread_mutex_unlock(&task->lock);
+    }
+
+    const gen_bool_t failed = task->failed;
+    const gen_size_t result = task->result;
+    gen_error_t task_error = task->error;
+
+    error = cio_extlib_internal_task_release(task);
+    CIO_EXTLIB_PROPAGATE(vm, error);
+
+    if(failed) CIO_EXTLIB_PROPAGATE(vm, gen_error_attach_backtrace_formatted(task_error.type, GEN_LINE_NUMBER, "Spawned task failed: %t", task_error.context));
+
+    caller[caller_frame->height - 1] = result;
+
+    return CIO_STATUS_OK;
+}
+
+CIO_EXTLIB_END_DEFS
@@ -4,8 +4,136 @@
 #define GEN_TESTS_UNIT "bytecode"
 #include <gentests.h>
 #include <genmemory.h>
+#include <genstring.h>
 #include <cionom.h>
 
+typedef struct {
+    const char* source;
+    gen_size_t source_length;
+
+    unsigned char* bytecode;
+    gen_size_t bytecode_length;
+} cio_test_stream_t;
+
+// Reads a single byte at a time, so every window is filled through retried short reads
+static gen_error_t* cio_test_stream_read(void* const restrict user_data, const gen_size_t offset, char* const restrict out_buffer, const gen_size_t length, gen_size_t* const restrict out_length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_stream_read, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_test_stream_t* const stream = user_data;
+
+    *out_length = offset < stream->source_length && length ? 1 : 0;
+    if(*out_length) out_buffer[0] = stream->source[offset];
+
+    return GEN_NULL;
+}
+
+static gen_error_t* cio_test_stream_write(void* const restrict user_data, const unsigned char* const restrict buffer, const gen_size_t length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_stream_write, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_test_stream_t* const stream = user_data;
+
+    error = gen_memory_reallocate_zeroed((void**) &stream->bytecode, stream->bytecode_length, stream->bytecode_length + length, sizeof(unsigned char));
+    if(error) return error;
+
+    error = gen_memory_copy(&stream->bytecode[stream->bytecode_length], length, buffer, length, length);
+    if(error) return error;
+
+    stream->bytecode_length += length;
+
+    return GEN_NULL;
+}
+
+// Appends a routine which calls an earlier one, so that the emitted code depends on the routine table
+static gen_error_t* cio_test_append_routine(char* const restrict source, const gen_size_t source_capacity, gen_size_t* const restrict source_length, const char* const restrict padding, const gen_size_t routine) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_append_routine, GEN_FILE_NAME);
+	if(error) return error;
+
+    static const char format[] = "%troutine_%uz 1\n:\n    routine_%uz %uz\n:\n";
+
+    gen_size_t formatted_length = 0;
+    error = gen_string_format(GEN_STRING_NO_BOUNDS, GEN_NULL, &formatted_length, format, sizeof(format) - 1, padding, routine, routine / 2, routine % 64);
+    if(error) return error;
+
+    error = GEN_TESTS_EXPECT(gen_true, *source_length + formatted_length < source_capacity);
+    if(error) return error;
+
+    error = gen_string_format(formatted_length + 1, &source[*source_length], GEN_NULL, format, sizeof(format) - 1, padding, routine, routine / 2, routine % 64);
+    if(error) return error;
+
+    *source_length += formatted_length;
+
+    return GEN_NULL;
+}
+
+// Emits `source` both from a parsed program and as a stream, and gets the routine called by its only call
+static gen_error_t* cio_test_emit_callee(const char* const restrict source, const gen_size_t source_length, const cio_warning_settings_t* const restrict warning_settings, gen_size_t* const restrict out_callee) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_emit_callee, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_token_t* tokens = GEN_NULL;
+    gen_size_t tokens_length = 0;
+    error = cio_tokenize(source, source_length, &tokens, &tokens_length);
+    if(error) return error;
+
+    cio_program_t program = {0};
+    error = cio_parse(tokens, tokens_length, &program, source, source_length, "", 0, warning_settings);
+    if(error) return error;
+
+    unsigned char* bytecode = GEN_NULL;
+    gen_size_t length = 0;
+    error = cio_module_emit(&program, &bytecode, &length, source, source_length, "", 0, warning_settings);
+    if(error) return error;
+
+    cio_test_stream_t stream = {source, source_length, GEN_NULL, 0};
+    error = cio_module_emit_stream(cio_test_stream_read, &stream, cio_test_stream_write, &stream, "", 0, warning_settings);
+    if(error) return error;
+
+    error = GEN_TESTS_EXPECT(length, stream.bytecode_length);
+    if(error) return error;
+
+    gen_bool_t equal = gen_false;
+    error = gen_memory_compare(bytecode, length, stream.bytecode, stream.bytecode_length, length, &equal);
+    if(error) return error;
+
+    error = GEN_TESTS_EXPECT(gen_true, equal);
+    if(error) return error;
+
+    // Skip the routine table's offsets and identifiers to the code
+    gen_size_t offset = 1;
+    for(gen_size_t i = 0; i < bytecode[0]; ++i) {
+        offset += 4;
+        while(bytecode[offset]) ++offset;
+        ++offset;
+    }
+
+    gen_size_t calls = 0;
+    for(; offset < length; ++offset) {
+        if(!(bytecode[offset] >> 7) || bytecode[offset] == 0xFF) continue;
+
+        *out_callee = bytecode[offset] & 0x7F;
+        ++calls;
+    }
+
+    error = GEN_TESTS_EXPECT(1, calls);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &stream.bytecode);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &bytecode);
+    if(error) return error;
+
+    error = cio_program_free(&program);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &tokens);
+    if(error) return error;
+
+    return GEN_NULL;
+}
+
 static gen_error_t* gen_main(void) {
     GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) gen_main, GEN_FILE_NAME);
 	if(error) return error;
@@ -60,5 +188,157 @@ static gen_error_t* gen_main(void) {
     error = gen_memory_free((void**) &bytecode);    
     if(error) return error;
 
+    static const char source[] = "foo 0\n:\n    bar 1\n:\nbar 1\n";
+    cio_test_stream_t stream = {source, sizeof(source) - 1, GEN_NULL, 0};
+
+    error = cio_module_emit_stream(cio_test_stream_read, &stream, cio_test_stream_write, &stream, "", 0, &warning_settings);
+    if(error) return error;
+
+    unsigned char expected_stream[] = {
+        // Header
+        2, // Routine Table Length
+            // `foo:`
+            0, 0, 0, 0, // Offset
+            'f', 'o', 'o', '\0', // Identifier
+            // `bar`
+            0xFF, 0xFF, 0xFF, 0xFF, // Offset
+            'b', 'a', 'r', '\0', // Identifier
+
+        // Code
+            // `foo:`
+            0x00, // `push 0x0`
+            0x01, // `push 0x1`
+            0x81, // `call 0x1`
+            0xFF  // `ret`
+    };
+
+    error = GEN_TESTS_EXPECT(sizeof(expected_stream), stream.bytecode_length);
+    if(error) return error;
+
+    error = gen_memory_compare(expected_stream, sizeof(expected_stream), stream.bytecode, stream.bytecode_length, stream.bytecode_length, &equal);
+    if(error) return error;
+
+    error = GEN_TESTS_EXPECT(gen_true, equal);
+    if(error) return error;
+
+    error = gen_memory_free((void**) &stream.bytecode);    
+    if(error) return error;
+
+    {
+        // A source spanning several windows, with an identifier straddling the end of the first
+        const gen_size_t large_capacity = CIO_STREAM_BUFFER_LENGTH * 3;
+        char* large = GEN_NULL;
+        error = gen_memory_allocate_zeroed((void**) &large, large_capacity, sizeof(char));
+        if(error) return error;
+
+        // `routine_0` is left external for the first routine to call
+        static const char external[] = "routine_0 1\n";
+        error = gen_memory_copy(large, large_capacity, external, sizeof(external) - 1, sizeof(external) - 1);
+        if(error) return error;
+
+        gen_size_t large_length = sizeof(external) - 1;
+        gen_size_t routine = 1;
+        while(large_length < CIO_STREAM_BUFFER_LENGTH - 64) {
+            error = cio_test_append_routine(large, large_capacity, &large_length, "", routine++);
+            if(error) return error;
+        }
+
+        while(large_length < CIO_STREAM_BUFFER_LENGTH - 4) large[large_length++] = ' ';
+
+        error = cio_test_append_routine(large, large_capacity, &large_length, "straddling_", routine++);
+        if(error) return error;
+
+        while(large_length < CIO_STREAM_BUFFER_LENGTH * 2 + 256) {
+            error = cio_test_append_routine(large, large_capacity, &large_length, "", routine++);
+            if(error) return error;
+        }
+
+        cio_token_t* tokens = GEN_NULL;
+        gen_size_t tokens_length = 0;
+        error = cio_tokenize(large, large_length, &tokens, &tokens_length);
+        if(error) return error;
+
+        cio_program_t large_program = {0};
+        error = cio_parse(tokens, tokens_length, &large_program, large, large_length, "", 0, &warning_settings);
+        if(error) return error;
+
+        error = cio_module_emit(&large_program, &bytecode, &length, large, large_length, "", 0, &warning_settings);
+        if(error) return error;
+
+        cio_test_stream_t large_stream = {large, large_length, GEN_NULL, 0};
+        error = cio_module_emit_stream(cio_test_stream_read, &large_stream, cio_test_stream_write, &large_stream, "", 0, &warning_settings);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(length, large_stream.bytecode_length);
+        if(error) return error;
+
+        error = gen_memory_compare(bytecode, length, large_stream.bytecode, large_stream.bytecode_length, length, &equal);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(gen_true, equal);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &large_stream.bytecode);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+
+        error = cio_program_free(&large_program);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &tokens);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &large);
+        if(error) return error;
+    }
+
+    {
+        // Calls resolve to the first definition of a routine, or to the last declaration where there is none
+        static const char duplicate_internal[] =
+            "foo 0\n"
+            ":\n"
+            ":\n"
+            "foo 0\n"
+            ":\n"
+            ":\n"
+            "bar 0\n"
+            ":\n"
+            "    foo\n"
+            ":\n";
+
+        static const char duplicate_external[] =
+            "foo 0\n"
+            "foo 0\n"
+            "bar 0\n"
+            ":\n"
+            "    foo\n"
+            ":\n";
+
+        static const char shadowed_external[] =
+            "foo 0\n"
+            "bar 0\n"
+            ":\n"
+            "    foo\n"
+            ":\n"
+            "foo 0\n"
+            ":\n"
+            ":\n"
+            "foo 0\n";
+
+        const char* const sources[] = {duplicate_internal, duplicate_external, shadowed_external};
+        const gen_size_t sources_lengths[] = {sizeof(duplicate_internal) - 1, sizeof(duplicate_external) - 1, sizeof(shadowed_external) - 1};
+        static const gen_size_t callees[] = {0, 1, 2};
+        for(gen_size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+            gen_size_t callee = GEN_SIZE_MAX;
+            error = cio_test_emit_callee(sources[i], sources_lengths[i], &warning_settings, &callee);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(callees[i], callee);
+            if(error) return error;
+        }
+    }
+
     return GEN_NULL;
 }
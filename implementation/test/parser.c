@@ -120,5 +120,30 @@ static gen_error_t* gen_main(void) {
     error = cio_program_free(&program);
     if(error) return error;
 
+    cio_program_t arena_program = {.arena = gen_true};
+    error = cio_parse(tokens, sizeof(tokens) / sizeof(tokens[0]), &arena_program, source, sizeof(source) - 1, "", 0, &warning_settings);
+    if(error) return error;
+
+    {
+        error = GEN_TESTS_EXPECT(program_expected.routines_length, arena_program.routines_length);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(program_expected.routines[1].identifier, arena_program.routines[1].identifier);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(program_expected.routines[1].calls_length, arena_program.routines[1].calls_length);
+        if(error) return error;
+
+        // Interned identifiers share storage
+        error = GEN_TESTS_EXPECT((void*) arena_program.routines[0].identifier, (void*) arena_program.routines[1].calls[0].identifier);
+        if(error) return error;
+    }
+
+    error = cio_program_free(&arena_program);
+    if(error) return error;
+
+    error = GEN_TESTS_EXPECT((void*) GEN_NULL, (void*) arena_program.arena_blocks);
+    if(error) return error;
+
     return GEN_NULL;
 }
@@ -6,37 +6,118 @@
 #include <genmemory.h>
 #include <cionom.h>
 
-static gen_error_t* gen_main(void) {
-    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) gen_main, GEN_FILE_NAME);
+static gen_error_t* cio_test_tokenize(const char* const restrict source, const gen_size_t source_length, const cio_token_t* const restrict expected, const gen_size_t expected_length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_tokenize, GEN_FILE_NAME);
 	if(error) return error;
 
-    const char source[] = "x 1 $cio::__foobar 0 :c1 11 c11:";
     cio_token_t* tokens = GEN_NULL;
     gen_size_t length = 0;
-    error = cio_tokenize(source, sizeof(source) - 1, &tokens, &length);
+    error = cio_tokenize(source, source_length, &tokens, &length);
 	if(error) return error;
 
-    cio_token_t expected[] = {
-        {CIO_TOKEN_IDENTIFIER, 0, 1},
-        {CIO_TOKEN_NUMBER, 2, 1},
-        {CIO_TOKEN_IDENTIFIER, 4, 14},
-        {CIO_TOKEN_NUMBER, 19, 1},
-        {CIO_TOKEN_BLOCK, 21, 1},
-        {CIO_TOKEN_IDENTIFIER, 22, 2},
-        {CIO_TOKEN_NUMBER, 25, 2},
-        {CIO_TOKEN_IDENTIFIER, 28, 3},
-        {CIO_TOKEN_BLOCK, 31, 1}
-    };
-
-    error = GEN_TESTS_EXPECT(sizeof(expected) / sizeof(expected[0]), length);
+    error = GEN_TESTS_EXPECT(expected_length, length);
     if(error) return error;
 
-    gen_bool_t equal = gen_false;
-    error = gen_memory_compare(expected, sizeof(expected), tokens, sizeof(expected), sizeof(expected), &equal);
-    if(error) return error;
+    // Tokens are compared field by field as the padding after `type` is unspecified
+    for(gen_size_t i = 0; i < length; ++i) {
+        error = GEN_TESTS_EXPECT((gen_size_t) expected[i].type, (gen_size_t) tokens[i].type);
+        if(error) return error;
 
-    error = GEN_TESTS_EXPECT(gen_true, equal);
-    if(error) return error;
+        error = GEN_TESTS_EXPECT(expected[i].offset, tokens[i].offset);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(expected[i].length, tokens[i].length);
+        if(error) return error;
+    }
+
+    if(tokens) {
+        error = gen_memory_free((void**) &tokens);
+        if(error) return error;
+    }
+
+    return GEN_NULL;
+}
+
+static gen_error_t* gen_main(void) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) gen_main, GEN_FILE_NAME);
+	if(error) return error;
+
+    {
+        const char source[] = "x 1 $cio::__foobar 0 :c1 11 c11:";
+        const cio_token_t expected[] = {
+            {CIO_TOKEN_IDENTIFIER, 0, 1},
+            {CIO_TOKEN_NUMBER, 2, 1},
+            {CIO_TOKEN_IDENTIFIER, 4, 14},
+            {CIO_TOKEN_NUMBER, 19, 1},
+            {CIO_TOKEN_BLOCK, 21, 1},
+            {CIO_TOKEN_IDENTIFIER, 22, 2},
+            {CIO_TOKEN_NUMBER, 25, 2},
+            {CIO_TOKEN_IDENTIFIER, 28, 4}
+        };
+
+        error = cio_test_tokenize(source, sizeof(source) - 1, expected, sizeof(expected) / sizeof(expected[0]));
+        if(error) return error;
+
+        // A trailing `:` belongs to the identifier whether or not it ends the source
+        const char trailing[] = "c11: c11:";
+        const cio_token_t trailing_expected[] = {
+            {CIO_TOKEN_IDENTIFIER, 0, 4},
+            {CIO_TOKEN_IDENTIFIER, 5, 4}
+        };
+
+        error = cio_test_tokenize(trailing, sizeof(trailing) - 1, trailing_expected, sizeof(trailing_expected) / sizeof(trailing_expected[0]));
+        if(error) return error;
+    }
+
+    {
+        // A block marker as the final byte closes the last token
+        const char source[] = "x 1:";
+        const cio_token_t expected[] = {
+            {CIO_TOKEN_IDENTIFIER, 0, 1},
+            {CIO_TOKEN_NUMBER, 2, 1},
+            {CIO_TOKEN_BLOCK, 3, 1}
+        };
+
+        error = cio_test_tokenize(source, sizeof(source) - 1, expected, sizeof(expected) / sizeof(expected[0]));
+        if(error) return error;
+    }
+
+    {
+        // Trailing whitespace does not produce an empty token
+        const char source[] = "x 1 \n\t  ";
+        const cio_token_t expected[] = {
+            {CIO_TOKEN_IDENTIFIER, 0, 1},
+            {CIO_TOKEN_NUMBER, 2, 1}
+        };
+
+        error = cio_test_tokenize(source, sizeof(source) - 1, expected, sizeof(expected) / sizeof(expected[0]));
+        if(error) return error;
+    }
+
+    {
+        // Identifiers spanning several classification blocks, one running to the end of the source
+        char source[2 + 200 + 1 + 2 + 1 + 150] = {0};
+        gen_size_t offset = 0;
+        source[offset++] = 'b';
+        source[offset++] = ' ';
+        for(gen_size_t i = 0; i < 200; ++i) source[offset++] = (char) ('a' + i % 26);
+        source[offset++] = ' ';
+        source[offset++] = '4';
+        source[offset++] = '2';
+        source[offset++] = ':';
+        for(gen_size_t i = 0; i < 150; ++i) source[offset++] = i % 7 ? 'z' : '_';
+
+        const cio_token_t expected[] = {
+            {CIO_TOKEN_IDENTIFIER, 0, 1},
+            {CIO_TOKEN_IDENTIFIER, 2, 200},
+            {CIO_TOKEN_NUMBER, 203, 2},
+            {CIO_TOKEN_BLOCK, 205, 1},
+            {CIO_TOKEN_IDENTIFIER, 206, 150}
+        };
+
+        error = cio_test_tokenize(source, sizeof(source), expected, sizeof(expected) / sizeof(expected[0]));
+        if(error) return error;
+    }
 
     return GEN_NULL;
 }
@@ -4,10 +4,122 @@
 #define GEN_TESTS_UNIT "vm"
 #include <gentests.h>
 #include <genmemory.h>
+#include <genfilesystem.h>
+#include <genstring.h>
 #include <cionom.h>
 
 extern gen_error_t* printn(cio_vm_t* const restrict vm);
 extern gen_error_t* cio_vm_internal_execute_routine(cio_vm_t* const restrict vm);
+extern gen_size_t cio_vm_internal_now(void);
+
+#if defined(__linux__)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_BEGIN)
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_IGNORE("-Weverything"))
+#include <signal.h>
+#include <unistd.h>
+GEN_PRAGMA(GEN_PRAGMA_DIAGNOSTIC_REGION_END)
+#endif
+
+static const cio_warning_settings_t cio_test_warning_settings = {0};
+
+static gen_error_t* cio_test_compile(const char* const restrict source, const gen_size_t source_length, unsigned char** const restrict out_bytecode, gen_size_t* const restrict out_bytecode_length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_compile, GEN_FILE_NAME);
+	if(error) return error;
+
+    cio_token_t* tokens = GEN_NULL;
+    gen_size_t tokens_length = 0;
+    error = cio_tokenize(source, source_length, &tokens, &tokens_length);
+	if(error) return error;
+
+    cio_program_t program = {0};
+    error = cio_parse(tokens, tokens_length, &program, source, source_length, "", 0, &cio_test_warning_settings);
+	if(error) return error;
+
+    error = cio_module_emit(&program, out_bytecode, out_bytecode_length, source, source_length, "", 0, &cio_test_warning_settings);
+	if(error) return error;
+
+    error = cio_program_free(&program);
+	if(error) return error;
+
+    error = gen_memory_free((void**) &tokens);
+	if(error) return error;
+
+    return GEN_NULL;
+}
+
+// Compiles `source` and loads it into a VM with the external library
+// Modules point into their bytecode, so `out_bytecode` must outlive the VM
+static gen_error_t* cio_test_initialize(const char* const restrict source, const gen_size_t source_length, const gen_size_t stack_length, const cio_vm_settings_t* const restrict settings, unsigned char** const restrict out_bytecode, cio_vm_t* const restrict out_vm) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_initialize, GEN_FILE_NAME);
+	if(error) return error;
+
+    gen_size_t bytecode_length = 0;
+    error = cio_test_compile(source, source_length, out_bytecode, &bytecode_length);
+	if(error) return error;
+
+    error = cio_vm_initialize(*out_bytecode, bytecode_length, stack_length, gen_true, out_vm, gen_false, &cio_test_warning_settings, settings);
+	if(error) return error;
+
+    return GEN_NULL;
+}
+
+// Calls `__cionom_entrypoint` from a frame holding only its reserve space, as the CLI does
+// The entrypoint's frame begins at stack cell 1
+static gen_error_t* cio_test_run(cio_vm_t* const restrict vm) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_run, GEN_FILE_NAME);
+	if(error) return error;
+
+    error = cio_vm_push_frame(vm);
+	if(error) return error;
+
+    error = cio_vm_push(vm);
+	if(error) return error;
+
+    cio_callable_t* callable = GEN_NULL;
+    error = cio_vm_get_identifier(vm, "__cionom_entrypoint", &callable, gen_false);
+	if(error) return error;
+
+    vm->current_bytecode = callable->bytecode_index;
+    return cio_vm_dispatch_call(vm, callable->routine_index, 0);
+}
+
+// Replaces the file at `path` with `length` bytes of `buffer`
+static gen_error_t* cio_test_write_file(const char* const restrict path, const unsigned char* const restrict buffer, const gen_size_t length) {
+    GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) cio_test_write_file, GEN_FILE_NAME);
+	if(error) return error;
+
+    gen_bool_t exists = gen_false;
+    error = gen_filesystem_path_exists(path, GEN_STRING_NO_BOUNDS, &exists);
+    if(error) return error;
+
+    if(exists) {
+        error = gen_filesystem_path_delete(path, GEN_STRING_NO_BOUNDS);
+        if(error) return error;
+    }
+
+    error = gen_filesystem_path_create_file(path, GEN_STRING_NO_BOUNDS);
+    if(error) return error;
+
+    if(!length) return GEN_NULL;
+
+    gen_filesystem_handle_t handle = {0};
+    error = gen_filesystem_handle_open(path, GEN_STRING_NO_BOUNDS, &handle);
+    if(error) return error;
+
+    error = gen_filesystem_handle_lock(&handle);
+    if(error) return error;
+
+    error = gen_filesystem_handle_file_write(&handle, buffer, 0, length);
+    if(error) return error;
+
+    error = gen_filesystem_handle_unlock(&handle);
+    if(error) return error;
+
+    error = gen_filesystem_handle_close(&handle);
+    if(error) return error;
+
+    return GEN_NULL;
+}
 
 static gen_error_t* gen_main(void) {
     GEN_TOOLING_AUTO gen_error_t* error = gen_tooling_push(GEN_FUNCTION_NAME, (void*) gen_main, GEN_FILE_NAME);
@@ -43,7 +155,7 @@ static gen_error_t* gen_main(void) {
     error = gen_memory_set(&warning_settings, sizeof(warning_settings), gen_true);
 	if(error) return error;
 
-    error = cio_vm_initialize(bytecode, sizeof(bytecode) / sizeof(bytecode[0]), 1024, gen_true, &vm, gen_false, &warning_settings);
+    error = cio_vm_initialize(bytecode, sizeof(bytecode) / sizeof(bytecode[0]), 1024, gen_true, &vm, gen_false, &warning_settings, GEN_NULL);
 	if(error) return error;
 
     cio_callable_t* printn_callable = GEN_NULL;
@@ -156,5 +268,1469 @@ static gen_error_t* gen_main(void) {
     error = cio_vm_free(&vm);
     if(error) return error;
 
+    {
+        // Popped cells are only zeroed with `scrub_stack`, but are always zeroed when pushed over again
+        const cio_vm_settings_t settings[] = {{0}, {.scrub_stack = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            cio_vm_t reused = {0};
+            error = cio_vm_initialize(bytecode, sizeof(bytecode) / sizeof(bytecode[0]), 1024, gen_true, &reused, gen_false, &warning_settings, &settings[i]);
+            if(error) return error;
+
+            error = cio_vm_push_frame(&reused);
+            if(error) return error;
+            error = cio_vm_push(&reused);
+            if(error) return error;
+
+            error = cio_vm_push_frame(&reused);
+            if(error) return error;
+            error = cio_vm_push(&reused);
+            if(error) return error;
+
+            reused.stack[1] = 5;
+
+            error = cio_vm_pop_frame(&reused);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(settings[i].scrub_stack ? 0 : 5, reused.stack[1]);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(2, reused.stack_high_water);
+            if(error) return error;
+
+            error = cio_vm_push(&reused);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(0, reused.stack[1]);
+            if(error) return error;
+
+            error = cio_vm_pop_frame(&reused);
+            if(error) return error;
+
+            error = cio_vm_free(&reused);
+            if(error) return error;
+        }
+    }
+
+    {
+        // A fault in a routine with the fast calling convention which the exception handler deals with resumes the caller
+        static const char source[] =
+            "/ 2\n"
+            "copy= 2\n"
+            "__cionom_extlib_default_exception_handler 2\n"
+            ":\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 0\n"
+            "    / 0 0\n"
+            "    copy= 0 7\n"
+            ":\n";
+
+        const cio_vm_settings_t settings[] = {{0}, {.trampoline = gen_true}, {.jit = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            unsigned char* bytecode = GEN_NULL;
+            cio_vm_t handled = {0};
+            error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings[i], &bytecode, &handled);
+            if(error) return error;
+
+            error = cio_test_run(&handled);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(1, handled.frames_used);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(7, handled.stack[1]);
+            if(error) return error;
+
+            error = cio_vm_free(&handled);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &bytecode);
+            if(error) return error;
+        }
+    }
+
+    {
+        // Calls are fused with the 1-4 pushes before them whichever opcode the call was decorated with
+        // Each `mark` routine writes its parameters into the entrypoint's buffer, so a misplaced push shows up in the buffer or the stack
+        static const char source[] =
+            "alloc 1\n"
+            "copy= 2\n"
+            "copy=v 2\n"
+            "copy=cvv 2\n"
+            "copy*[+]=c 3\n"
+            "copy*[+v]=c 3\n"
+            "copy=*[+]c 3\n"
+            "+ 2\n"
+            "- 2\n"
+            "mark0 0\n"
+            ":\n"
+            "    copy= 0 0\n"
+            "    copy=cvv 0 0\n"
+            "    copy*[+]=c 0 0 9\n"
+            ":\n"
+            "mark1 1\n"
+            ":\n"
+            "    copy= 1 0\n"
+            "    copy=cvv 1 1\n"
+            "    copy*[+v]=c 1 0 10\n"
+            ":\n"
+            "mark2 2\n"
+            ":\n"
+            "    copy= 2 0\n"
+            "    copy=cvv 2 2\n"
+            "    copy*[+v]=c 2 0 20\n"
+            "    copy*[+v]=c 2 1 21\n"
+            ":\n"
+            "mark3 3\n"
+            ":\n"
+            "    copy= 3 0\n"
+            "    copy=cvv 3 3\n"
+            "    copy*[+v]=c 3 0 30\n"
+            "    copy*[+v]=c 3 1 31\n"
+            "    copy*[+v]=c 3 2 32\n"
+            ":\n"
+            "last 0\n"
+            ":\n"
+            "    copy= 0 0\n"
+            "    copy=cvv 0 0\n"
+            "    mark1 12\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    alloc 16\n"
+            "    mark0\n"
+            "    mark1 1\n"
+            "    mark2 2 3\n"
+            "    mark3 4 5 6\n"
+            "    copy= 1 6\n"
+            "    copy= 2 7\n"
+            "    + 1 2\n"
+            "    - 2 1\n"
+            "    copy=v 3 7\n"
+            "    copy*[+]=c 0 7 8\n"
+            "    copy=*[+]c 4 0 7\n"
+            "    last\n"
+            ":\n";
+
+        static const char expected_buffer[16] = {9, 10, 20, 21, 30, 31, 32, 8, 0, 0, 0, 0, 10};
+        static const gen_size_t expected_stack[] = {6, 7, 13, 8, 0, 0, 13, 1};
+
+        const cio_vm_settings_t settings[] = {{0}, {.tail_calls = gen_true}, {.trampoline = gen_true}, {.tail_calls = gen_true, .trampoline = gen_true}, {.no_intrinsics = gen_true}, {.jit = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            unsigned char* bytecode = GEN_NULL;
+            cio_vm_t fused = {0};
+            error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings[i], &bytecode, &fused);
+            if(error) return error;
+
+            // Every run length is fused, as are runs ending in intrinsics and tail calls where those are decoded
+            gen_size_t runs[4] = {0};
+            gen_size_t decorated = 0;
+            const cio_bytecode_t* const module = &fused.bytecode[0];
+            for(gen_size_t j = 0; j < module->size; ++j) {
+                const cio_decoded_opcode_t opcode = module->decoded[j].opcode;
+                if(opcode < CIO_DECODED_PUSH_CALL_1 || opcode > CIO_DECODED_PUSH_CALL_4) continue;
+
+                const gen_size_t run = (gen_size_t) (opcode - CIO_DECODED_PUSH_CALL_1) + 1;
+                ++runs[run - 1];
+                if(module->decoded[j + run].opcode != CIO_DECODED_CALL) ++decorated;
+            }
+
+            for(gen_size_t j = 0; j < sizeof(runs) / sizeof(runs[0]); ++j) {
+                error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (runs[j] != 0));
+                if(error) return error;
+            }
+
+            error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) ((decorated != 0) == (!settings[i].no_intrinsics || settings[i].tail_calls)));
+            if(error) return error;
+
+            error = cio_test_run(&fused);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(1, fused.frames_used);
+            if(error) return error;
+
+            for(gen_size_t j = 0; j < sizeof(expected_stack) / sizeof(expected_stack[0]); ++j) {
+                error = GEN_TESTS_EXPECT(expected_stack[j], fused.stack[2 + j]);
+                if(error) return error;
+            }
+
+            gen_bool_t equal = gen_false;
+            error = gen_memory_compare((const void*) fused.stack[1], sizeof(expected_buffer), expected_buffer, sizeof(expected_buffer), sizeof(expected_buffer), &equal);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(gen_true, equal);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &fused.stack[1]);
+            if(error) return error;
+
+            error = cio_vm_free(&fused);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &bytecode);
+            if(error) return error;
+        }
+    }
+
+    {
+        // Intrinsics give the same results as the native routines they replace
+        // Calls with the wrong number of parameters are left to the native routine
+        static const char source[] =
+            "alloc 1\n"
+            "copy= 2\n"
+            "copy=v 2\n"
+            "copy*[+]=c 3\n"
+            "+ 2\n"
+            "- 2\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    alloc 16\n"
+            "    copy= 1 30\n"
+            "    copy= 2 12\n"
+            "    + 1 2\n"
+            "    - 1 2\n"
+            "    copy=v 5 3\n"
+            "    copy*[+]=c 0 2 65\n"
+            "    + 1 2 3\n"
+            "    copy=v 8 4 9\n"
+            ":\n";
+
+        static const gen_size_t expected_stack[] = {30, 12, 42, 18, 42, 0, 42, 18};
+
+        const cio_vm_settings_t settings[] = {{0}, {.no_intrinsics = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            unsigned char* bytecode = GEN_NULL;
+            cio_vm_t intrinsic = {0};
+            error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings[i], &bytecode, &intrinsic);
+            if(error) return error;
+
+            gen_size_t inlined = 0;
+            const cio_bytecode_t* const module = &intrinsic.bytecode[0];
+            for(gen_size_t j = 0; j < module->size; ++j) {
+                if(module->decoded[j].opcode >= CIO_DECODED_INTRINSIC_ADD && module->decoded[j].opcode <= CIO_DECODED_INTRINSIC_STORE_CHAR) ++inlined;
+            }
+
+            error = GEN_TESTS_EXPECT(settings[i].no_intrinsics ? 0 : 6, inlined);
+            if(error) return error;
+
+            error = cio_test_run(&intrinsic);
+            if(error) return error;
+
+            for(gen_size_t j = 0; j < sizeof(expected_stack) / sizeof(expected_stack[0]); ++j) {
+                error = GEN_TESTS_EXPECT(expected_stack[j], intrinsic.stack[2 + j]);
+                if(error) return error;
+            }
+
+            error = GEN_TESTS_EXPECT(65, ((const char*) intrinsic.stack[1])[2]);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &intrinsic.stack[1]);
+            if(error) return error;
+
+            error = cio_vm_free(&intrinsic);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &bytecode);
+            if(error) return error;
+        }
+    }
+
+    {
+        // Profiles fold the calling context tree into one line per call stack, weighted by the time spent in it
+        static const char source[] =
+            "+ 2\n"
+            "leaf 0\n"
+            ":\n"
+            "    + 0 0\n"
+            ":\n"
+            "branch 0\n"
+            ":\n"
+            "    leaf\n"
+            "    leaf\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    branch\n"
+            "    leaf\n"
+            ":\n";
+
+        static const char* const stacks[] = {
+            "__cionom_entrypoint@0",
+            "__cionom_entrypoint@0;branch@0",
+            "__cionom_entrypoint@0;branch@0;leaf@0",
+            "__cionom_entrypoint@0;branch@0;leaf@0;+@0",
+            "__cionom_entrypoint@0;leaf@0",
+            "__cionom_entrypoint@0;leaf@0;+@0"
+        };
+
+        const cio_vm_settings_t settings = {.profile = gen_true};
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t profiled = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings, &bytecode, &profiled);
+        if(error) return error;
+
+        error = cio_test_run(&profiled);
+        if(error) return error;
+
+        char* summary = GEN_NULL;
+        gen_size_t summary_length = 0;
+        char* folded = GEN_NULL;
+        gen_size_t folded_length = 0;
+        error = cio_vm_emit_profile(&profiled, &summary, &summary_length, &folded, &folded_length);
+        if(error) return error;
+
+        // Each line is a known stack followed by its exclusive time
+        gen_size_t times[sizeof(stacks) / sizeof(stacks[0])] = {0};
+        gen_size_t total = 0;
+        for(gen_size_t begin = 0; begin < folded_length;) {
+            gen_size_t end = begin;
+            while(folded[end] != '\n') ++end;
+            gen_size_t space = end;
+            while(folded[space] != ' ') --space;
+
+            gen_size_t time = 0;
+            for(gen_size_t i = space + 1; i < end; ++i) time = time * 10 + (gen_size_t) (folded[i] - '0');
+
+            gen_bool_t matched = gen_false;
+            for(gen_size_t i = 0; !matched && i < sizeof(stacks) / sizeof(stacks[0]); ++i) {
+                gen_size_t length = 0;
+                error = gen_string_length(stacks[i], GEN_STRING_NO_BOUNDS, GEN_STRING_NO_BOUNDS, &length);
+                if(error) return error;
+                if(length != space - begin) continue;
+
+                error = gen_string_compare(stacks[i], length + 1, &folded[begin], folded_length - begin, length, &matched);
+                if(error) return error;
+                if(matched) times[i] = time;
+            }
+
+            error = GEN_TESTS_EXPECT(gen_true, matched);
+            if(error) return error;
+
+            total += time;
+            begin = end + 1;
+        }
+
+        for(gen_size_t i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+            error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (times[i] != 0));
+            if(error) return error;
+        }
+
+        static const char* const identifiers[] = {"__cionom_entrypoint", "branch", "leaf", "+"};
+        static const gen_size_t calls[] = {1, 1, 3, 3};
+        for(gen_size_t i = 0; i < sizeof(identifiers) / sizeof(identifiers[0]); ++i) {
+            cio_callable_t* callable = GEN_NULL;
+            error = cio_vm_get_identifier(&profiled, identifiers[i], &callable, gen_false);
+            if(error) return error;
+
+            const cio_profile_callable_t* const totals = &profiled.profile->callables[callable - profiled.callables];
+            error = GEN_TESTS_EXPECT(calls[i], totals->calls);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (totals->inclusive >= totals->exclusive));
+            if(error) return error;
+        }
+
+        // Nothing recurses, so inclusive times are exactly the sum of the stacks beneath
+        cio_callable_t* entrypoint = GEN_NULL;
+        error = cio_vm_get_identifier(&profiled, "__cionom_entrypoint", &entrypoint, gen_false);
+        if(error) return error;
+        error = GEN_TESTS_EXPECT(total, profiled.profile->callables[entrypoint - profiled.callables].inclusive);
+        if(error) return error;
+
+        cio_callable_t* leaf = GEN_NULL;
+        error = cio_vm_get_identifier(&profiled, "leaf", &leaf, gen_false);
+        if(error) return error;
+        error = GEN_TESTS_EXPECT(times[2] + times[3] + times[4] + times[5], profiled.profile->callables[leaf - profiled.callables].inclusive);
+        if(error) return error;
+        error = GEN_TESTS_EXPECT(times[2] + times[4], profiled.profile->callables[leaf - profiled.callables].exclusive);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &summary);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &folded);
+        if(error) return error;
+
+        error = cio_vm_free(&profiled);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+    {
+        // Compiled routines leave the same stack and output as interpreted ones
+        // `leaf` is declared ahead of `middle` and defined after it, so `middle`'s call to it is patched forward
+        // Each routine writes into the entrypoint's buffer through the pointer passed down by index, which serves as the program's output
+        static const char source[] =
+            "alloc 1\n"
+            "copy= 2\n"
+            "copy=v 2\n"
+            "copy=cvv 2\n"
+            "copy*[+]=c 3\n"
+            "copy*[+v]=c 3\n"
+            "+ 2\n"
+            "- 2\n"
+            "leaf 3\n"
+            "middle 2\n"
+            ":\n"
+            "    copy=cvv 0 0\n"
+            "    copy*[+v]=c 0 1 9\n"
+            "    leaf 0 3 4\n"
+            "    leaf 0 5 6\n"
+            ":\n"
+            "leaf 3\n"
+            ":\n"
+            "    copy=cvv 0 0\n"
+            "    + 1 2\n"
+            "    - 2 1\n"
+            "    copy*[+v]=c 0 1 7\n"
+            "    copy*[+v]=c 0 2 8\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    alloc 32\n"
+            "    middle 0 1\n"
+            "    copy= 1 20\n"
+            "    copy= 2 22\n"
+            "    + 1 2\n"
+            "    - 2 1\n"
+            "    copy=v 3 4\n"
+            "    copy*[+]=c 0 12 5\n"
+            "    leaf 0 10 11\n"
+            ":\n";
+
+        const cio_vm_settings_t settings[] = {{0}, {.jit = gen_true}};
+        cio_vm_t parity[2] = {0};
+        unsigned char* bytecode[2] = {0};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings[i], &bytecode[i], &parity[i]);
+            if(error) return error;
+
+            error = cio_test_run(&parity[i]);
+            if(error) return error;
+        }
+
+        // Every Cíonom routine is compiled, so calls between them are made directly
+        for(gen_size_t i = 0; i < parity[1].callables_length; ++i) {
+            const cio_callable_t* const callable = &parity[1].callables[i];
+            if(callable->offset == CIO_ROUTINE_EXTERNAL) continue;
+
+            error = GEN_TESTS_EXPECT(gen_false, (gen_bool_t) ((void*) parity[1].dispatch[i].function == (void*) cio_vm_internal_execute_routine));
+            if(error) return error;
+        }
+
+        error = GEN_TESTS_EXPECT(parity[0].frames_used, parity[1].frames_used);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(parity[0].stack_high_water, parity[1].stack_high_water);
+        if(error) return error;
+
+        // Only the buffer pointer differs between runs, wherever it was copied to
+        for(gen_size_t i = 0; i < parity[0].stack_high_water; ++i) {
+            const gen_size_t expected = parity[0].stack[i] == parity[0].stack[1] ? parity[1].stack[1] : parity[0].stack[i];
+            error = GEN_TESTS_EXPECT(expected, parity[1].stack[i]);
+            if(error) return error;
+        }
+
+        gen_bool_t equal = gen_false;
+        error = gen_memory_compare((const void*) parity[0].stack[1], 32, (const void*) parity[1].stack[1], 32, 32, &equal);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(gen_true, equal);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(7, ((const char*) parity[1].stack[1])[10]);
+        if(error) return error;
+
+        // Runs of pushes are bounds checked as a whole, so both overflow at the same stack length
+        const gen_size_t needed = parity[0].stack_high_water;
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            error = gen_memory_free((void**) &parity[i].stack[1]);
+            if(error) return error;
+
+            error = cio_vm_free(&parity[i]);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &bytecode[i]);
+            if(error) return error;
+
+            for(gen_size_t j = 0; j < 2; ++j) {
+                unsigned char* bounded_bytecode = GEN_NULL;
+                cio_vm_t bounded = {0};
+                error = cio_test_initialize(source, sizeof(source) - 1, needed - j, &settings[i], &bounded_bytecode, &bounded);
+                if(error) return error;
+
+                gen_error_t* const overflow = cio_test_run(&bounded);
+                error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (j ? overflow && overflow->type == GEN_ERROR_OUT_OF_SPACE : !overflow));
+                if(error) return error;
+
+                if(bounded.stack[1]) {
+                    error = gen_memory_free((void**) &bounded.stack[1]);
+                    if(error) return error;
+                }
+
+                error = cio_vm_free(&bounded);
+                if(error) return error;
+
+                error = gen_memory_free((void**) &bounded_bytecode);
+                if(error) return error;
+            }
+        }
+
+        // Settings which need the interpreter leave everything interpreted
+        const cio_vm_settings_t interpreted_settings = {.jit = gen_true, .trampoline = gen_true};
+        unsigned char* interpreted_bytecode = GEN_NULL;
+        cio_vm_t interpreted = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, &interpreted_settings, &interpreted_bytecode, &interpreted);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) !interpreted.jit_code);
+        if(error) return error;
+
+        error = cio_vm_free(&interpreted);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &interpreted_bytecode);
+        if(error) return error;
+    }
+
+    {
+        // Unbounded recursion through `?` and `callv` runs out of frames rather than native stack when trampolining
+        static const char branch_source[] =
+            "? 3\n"
+            "copy= 2\n"
+            "loop 0\n"
+            ":\n"
+            "    copy= 0 1\n"
+            "    ? 2 2 0\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    loop\n"
+            ":\n";
+
+        static const char callv_source[] =
+            "callv 1\n"
+            "copy= 2\n"
+            "loop 0\n"
+            ":\n"
+            "    copy= 0 2\n"
+            "    callv 0\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    loop\n"
+            ":\n";
+
+        const char* const sources[] = {branch_source, callv_source};
+        const gen_size_t sources_lengths[] = {sizeof(branch_source) - 1, sizeof(callv_source) - 1};
+        const cio_vm_settings_t settings[] = {{.trampoline = gen_true}, {.trampoline = gen_true, .no_intrinsics = gen_true}, {.trampoline = gen_true, .profile = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+            for(gen_size_t j = 0; j < sizeof(settings) / sizeof(settings[0]); ++j) {
+                unsigned char* bytecode = GEN_NULL;
+                cio_vm_t deep = {0};
+                error = cio_test_initialize(sources[i], sources_lengths[i], 1 << 18, &settings[j], &bytecode, &deep);
+                if(error) return error;
+
+                gen_error_t* const overflow = cio_test_run(&deep);
+                error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (overflow && overflow->type == GEN_ERROR_OUT_OF_SPACE));
+                if(error) return error;
+
+                error = cio_vm_free(&deep);
+                if(error) return error;
+
+                error = gen_memory_free((void**) &bytecode);
+                if(error) return error;
+            }
+        }
+    }
+
+    {
+        // A routine reading its caller's frame through `copy=cvv` sees the same frame whether or not it is reached by a tail call
+        // `reader` calls whichever routine index it finds, and `bad` fails, so reading the entrypoint's frame in place of `middle`'s is an error
+        static const char call_source[] =
+            "! 0\n"
+            "copy= 2\n"
+            "copy=cvv 2\n"
+            "callv 1\n"
+            "ok 0\n"
+            ":\n"
+            ":\n"
+            "bad 0\n"
+            ":\n"
+            "    !\n"
+            ":\n"
+            "reader 1\n"
+            ":\n"
+            "    copy=cvv 0 0\n"
+            "    callv 0\n"
+            ":\n"
+            "middle 0\n"
+            ":\n"
+            "    copy= 0 4\n"
+            "    reader 0\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 5\n"
+            "    middle\n"
+            ":\n";
+
+        // The routine branched to reads the parameters of `?`, the second of which is `ok`
+        static const char branch_source[] =
+            "! 0\n"
+            "copy= 2\n"
+            "copy=cvv 2\n"
+            "callv 1\n"
+            "? 3\n"
+            "ok 0\n"
+            ":\n"
+            ":\n"
+            "bad 0\n"
+            ":\n"
+            "    !\n"
+            ":\n"
+            "reader 0\n"
+            ":\n"
+            "    copy= 0 1\n"
+            "    copy=cvv 0 0\n"
+            "    callv 0\n"
+            ":\n"
+            "middle 0\n"
+            ":\n"
+            "    copy= 0 1\n"
+            "    ? 7 5 0\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 0\n"
+            "    copy= 1 6\n"
+            "    middle\n"
+            ":\n";
+
+        // `callv` is transparent, so the routine it calls reads the frame of `callv`'s caller
+        static const char callv_source[] =
+            "! 0\n"
+            "copy= 2\n"
+            "copy=cvv 2\n"
+            "callv 1\n"
+            "ok 0\n"
+            ":\n"
+            ":\n"
+            "bad 0\n"
+            ":\n"
+            "    !\n"
+            ":\n"
+            "reader 1\n"
+            ":\n"
+            "    copy=cvv 0 0\n"
+            "    callv 0\n"
+            ":\n"
+            "middle 0\n"
+            ":\n"
+            "    copy= 0 4\n"
+            "    copy= 1 6\n"
+            "    callv 1 0\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 5\n"
+            "    middle\n"
+            ":\n";
+
+        const char* const sources[] = {call_source, branch_source, callv_source};
+        const gen_size_t sources_lengths[] = {sizeof(call_source) - 1, sizeof(branch_source) - 1, sizeof(callv_source) - 1};
+        const cio_vm_settings_t settings[] = {{0}, {.tail_calls = gen_true}, {.tail_calls = gen_true, .trampoline = gen_true}, {.tail_calls = gen_true, .trampoline = gen_true, .no_intrinsics = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+            for(gen_size_t j = 0; j < sizeof(settings) / sizeof(settings[0]); ++j) {
+                unsigned char* bytecode = GEN_NULL;
+                cio_vm_t observed = {0};
+                error = cio_test_initialize(sources[i], sources_lengths[i], 1024, &settings[j], &bytecode, &observed);
+                if(error) return error;
+
+                error = cio_test_run(&observed);
+                if(error) return error;
+
+                error = GEN_TESTS_EXPECT(1, observed.frames_used);
+                if(error) return error;
+
+                error = cio_vm_free(&observed);
+                if(error) return error;
+
+                error = gen_memory_free((void**) &bytecode);
+                if(error) return error;
+            }
+        }
+    }
+
+    {
+        // Any external routine marked as reading its caller's caller's frame keeps its callers from being entered by tail calls
+        // `copy=cv` reads the cell of `middle`'s frame holding `ok`, where the entrypoint's frame holds `bad`
+        static const char source[] =
+            "! 0\n"
+            "copy= 2\n"
+            "copy=cv 2\n"
+            "callv 1\n"
+            "copy=v 2\n"
+            "ok 0\n"
+            ":\n"
+            ":\n"
+            "bad 0\n"
+            ":\n"
+            "    !\n"
+            ":\n"
+            "reader 1\n"
+            ":\n"
+            "    copy=cv 0 0\n"
+            "    callv 0\n"
+            ":\n"
+            "middle 0\n"
+            ":\n"
+            "    copy= 0 5\n"
+            "    copy=v 1 0\n"
+            "    reader 0\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 6\n"
+            "    middle\n"
+            ":\n";
+
+        const cio_vm_settings_t settings[] = {{0}, {.tail_calls = gen_true}, {.tail_calls = gen_true, .trampoline = gen_true}, {.tail_calls = gen_true, .trampoline = gen_true, .no_intrinsics = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            unsigned char* bytecode = GEN_NULL;
+            cio_vm_t observed = {0};
+            error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings[i], &bytecode, &observed);
+            if(error) return error;
+
+            error = cio_test_run(&observed);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(1, observed.frames_used);
+            if(error) return error;
+
+            // Only routines marked by the external library are taken to read past their caller, and only routines calling them observe their own caller
+            static const char* const identifiers[] = {"copy=cv", "copy=v", "copy=", "callv", "reader", "middle"};
+            static const gen_bool_t reads_caller[] = {gen_true, gen_false, gen_false, gen_false, gen_false, gen_false};
+            static const gen_bool_t observes_caller[] = {gen_false, gen_false, gen_false, gen_false, gen_true, gen_false};
+            for(gen_size_t j = 0; j < sizeof(identifiers) / sizeof(identifiers[0]); ++j) {
+                cio_callable_t* callable = GEN_NULL;
+                error = cio_vm_get_identifier(&observed, identifiers[j], &callable, gen_false);
+                if(error) return error;
+
+                const cio_dispatch_t* const dispatch = &observed.dispatch[callable - observed.callables];
+                error = GEN_TESTS_EXPECT(settings[i].tail_calls && reads_caller[j], dispatch->reads_caller);
+                if(error) return error;
+
+                error = GEN_TESTS_EXPECT(settings[i].tail_calls && observes_caller[j], dispatch->observes_caller);
+                if(error) return error;
+            }
+
+            error = cio_vm_free(&observed);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &bytecode);
+            if(error) return error;
+        }
+    }
+
+    {
+        // A program which fails to load is released rather than leaked
+        static const char source[] =
+            "__cionom_test_no_such_routine 0\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    __cionom_test_no_such_routine\n"
+            ":\n";
+
+        unsigned char* unresolved_bytecode = GEN_NULL;
+        cio_vm_t unresolved = {0};
+        gen_error_t* const unresolved_error = cio_test_initialize(source, sizeof(source) - 1, 1024, GEN_NULL, &unresolved_bytecode, &unresolved);
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (unresolved_error && unresolved_error->type == GEN_ERROR_NO_SUCH_OBJECT));
+        if(error) return error;
+
+        error = gen_memory_free((void**) &unresolved_bytecode);
+        if(error) return error;
+    }
+
+    {
+        // A coroutine yielding from a routine entered through `callv` or `?` is suspended, whichever passes are enabled
+        static const char source[] =
+            "yield 0\n"
+            "? 3\n"
+            "callv 1\n"
+            "copy= 2\n"
+            "step 0\n"
+            ":\n"
+            "    yield\n"
+            ":\n"
+            "worker 0\n"
+            ":\n"
+            "    copy= 0 4\n"
+            "    callv 0\n"
+            "    copy= 1 1\n"
+            "    ? 4 4 1\n"
+            "    copy= 2 7\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            ":\n";
+
+        const cio_vm_settings_t settings[] = {{.trampoline = gen_true}, {.trampoline = gen_true, .no_intrinsics = gen_true}, {.trampoline = gen_true, .profile = gen_true}, {.trampoline = gen_true, .tail_calls = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            unsigned char* bytecode = GEN_NULL;
+            cio_vm_t scheduled = {0};
+            error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings[i], &bytecode, &scheduled);
+            if(error) return error;
+
+            cio_callable_t* worker = GEN_NULL;
+            error = cio_vm_get_identifier(&scheduled, "worker", &worker, gen_false);
+            if(error) return error;
+
+            error = cio_vm_start_coroutine(&scheduled, worker->routine_index, GEN_NULL, 0);
+            if(error) return error;
+
+            // Once for each yield, then once more to finish
+            gen_size_t rounds = 0;
+            while(scheduled.coroutines) {
+                error = cio_vm_yield(&scheduled);
+                if(error) return error;
+                ++rounds;
+            }
+
+            error = GEN_TESTS_EXPECT(3, rounds);
+            if(error) return error;
+
+            error = cio_vm_free(&scheduled);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &bytecode);
+            if(error) return error;
+        }
+    }
+
+    {
+        // `go` without a routine index faults rather than reading past its frame
+        static const char source[] =
+            "go 1\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    go\n"
+            ":\n";
+
+        const cio_vm_settings_t settings = {.trampoline = gen_true};
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t empty = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings, &bytecode, &empty);
+        if(error) return error;
+
+        gen_error_t* const empty_error = cio_test_run(&empty);
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (empty_error && empty_error->type == GEN_ERROR_INVALID_PARAMETER));
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) !empty.coroutines);
+        if(error) return error;
+
+        error = cio_vm_free(&empty);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+    {
+        // Spawned tasks run in parallel and `join` hands back the reserve value of each
+        // `copy= 0 v` writes `v` into the reserve space of the frame it was called from, which is the task's result
+        static const char source[] =
+            "spawn 3\n"
+            "join 1\n"
+            "copy= 2\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 2\n"
+            "    spawn 0 0 11\n"
+            "    spawn 0 0 22\n"
+            "    spawn 0 0 33\n"
+            "    spawn 0 0 44\n"
+            "    spawn 0 0 55\n"
+            "    spawn 0 0 66\n"
+            "    spawn 0 0 77\n"
+            "    spawn 0 0 88\n"
+            "    join 8\n"
+            "    join 7\n"
+            "    join 6\n"
+            "    join 5\n"
+            "    join 4\n"
+            "    join 3\n"
+            "    join 2\n"
+            "    join 1\n"
+            ":\n";
+
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t spawner = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, GEN_NULL, &bytecode, &spawner);
+        if(error) return error;
+
+        error = cio_test_run(&spawner);
+        if(error) return error;
+
+        for(gen_size_t i = 0; i < 8; ++i) {
+            error = GEN_TESTS_EXPECT(88 - i * 11, spawner.stack[10 + i]);
+            if(error) return error;
+        }
+
+        error = cio_vm_free(&spawner);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+    {
+        // A task which faults fails the `join` waiting on it, while the tasks around it still complete
+        static const char source[] =
+            "spawn 3\n"
+            "join 1\n"
+            "copy= 2\n"
+            "! 0\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 2\n"
+            "    copy= 1 3\n"
+            "    spawn 0 0 11\n"
+            "    spawn 1\n"
+            "    join 2\n"
+            "    join 3\n"
+            ":\n";
+
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t spawner = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, GEN_NULL, &bytecode, &spawner);
+        if(error) return error;
+
+        gen_error_t* const failed = cio_test_run(&spawner);
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (failed && failed->type == GEN_ERROR_UNKNOWN));
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(11, spawner.stack[5]);
+        if(error) return error;
+
+        error = cio_vm_free(&spawner);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+#if defined(__linux__)
+    {
+        // Coroutines parked on asynchronous I/O
+        static const char source[] =
+            "sleepms 1\n"
+            "fdread* 3\n"
+            "napper 1\n"
+            ":\n"
+            "    sleepms 0\n"
+            ":\n"
+            "reader 3\n"
+            ":\n"
+            "    fdread* 0 1 2\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            ":\n";
+
+        const cio_vm_settings_t settings = {.trampoline = gen_true};
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t parked = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings, &bytecode, &parked);
+        if(error) return error;
+
+        cio_callable_t* napper = GEN_NULL;
+        error = cio_vm_get_identifier(&parked, "napper", &napper, gen_false);
+        if(error) return error;
+
+        cio_callable_t* reader = GEN_NULL;
+        error = cio_vm_get_identifier(&parked, "reader", &reader, gen_false);
+        if(error) return error;
+
+        // The duration is read from the stack index passed
+        const gen_size_t duration = 20;
+        const gen_size_t start = cio_vm_internal_now();
+        error = cio_vm_start_coroutine(&parked, napper->routine_index, &duration, 1);
+        if(error) return error;
+
+        error = cio_vm_run_coroutines(&parked);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (cio_vm_internal_now() - start >= duration * 1000000));
+        if(error) return error;
+
+        // Two coroutines can wait to read from the same descriptor
+        int fds[2] = {0};
+        error = GEN_TESTS_EXPECT(0, (gen_size_t) pipe(fds));
+        if(error) return error;
+
+        unsigned char received[2] = {0};
+        const gen_size_t first[] = {(gen_size_t) fds[0], (gen_size_t) &received[0], 1};
+        const gen_size_t second[] = {(gen_size_t) fds[0], (gen_size_t) &received[1], 1};
+        error = cio_vm_start_coroutine(&parked, reader->routine_index, first, 3);
+        if(error) return error;
+        error = cio_vm_start_coroutine(&parked, reader->routine_index, second, 3);
+        if(error) return error;
+
+        error = cio_vm_yield(&parked);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(2, parked.coroutines_parked);
+        if(error) return error;
+
+        const unsigned char sent[] = {'a', 'b'};
+        error = GEN_TESTS_EXPECT(sizeof(sent), (gen_size_t) write(fds[1], sent, sizeof(sent)));
+        if(error) return error;
+
+        error = cio_vm_run_coroutines(&parked);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT((gen_size_t) ('a' + 'b'), (gen_size_t) (received[0] + received[1]));
+        if(error) return error;
+
+        // Operations still waiting when the VM is freed are released with their coroutines
+        const gen_size_t forever = 1000000;
+        error = cio_vm_start_coroutine(&parked, napper->routine_index, &forever, 1);
+        if(error) return error;
+        error = cio_vm_start_coroutine(&parked, reader->routine_index, first, 3);
+        if(error) return error;
+
+        error = cio_vm_yield(&parked);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(2, parked.coroutines_parked);
+        if(error) return error;
+
+        error = cio_vm_free(&parked);
+        if(error) return error;
+
+        close(fds[0]);
+        close(fds[1]);
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+    {
+        // Sampling a busy routine yields well-formed folded stacks which find it
+#define CIO_TEST_BUSY_4 "    + 1 2\n    + 3 4\n    + 5 6\n    + 7 8\n"
+#define CIO_TEST_BUSY_16 CIO_TEST_BUSY_4 CIO_TEST_BUSY_4 CIO_TEST_BUSY_4 CIO_TEST_BUSY_4
+        static const char source[] =
+            "+ 2\n"
+            "busy 0\n"
+            ":\n"
+            CIO_TEST_BUSY_16 CIO_TEST_BUSY_16 CIO_TEST_BUSY_16 CIO_TEST_BUSY_16
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    busy\n"
+            ":\n";
+#undef CIO_TEST_BUSY_16
+#undef CIO_TEST_BUSY_4
+
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t sampled = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, GEN_NULL, &bytecode, &sampled);
+        if(error) return error;
+
+        cio_callable_t* entrypoint = GEN_NULL;
+        error = cio_vm_get_identifier(&sampled, "__cionom_entrypoint", &entrypoint, gen_false);
+        if(error) return error;
+
+        error = cio_vm_start_sampling(&sampled, 10000, 4096);
+        if(error) return error;
+
+        // Samples land wherever the timer fires, so keep calling in until one is taken inside `busy`
+        static const char busy[] = "__cionom_entrypoint@0;busy@0";
+        gen_bool_t found = gen_false;
+        gen_size_t samples = 0;
+        const gen_size_t start = cio_vm_internal_now();
+        while(!found && cio_vm_internal_now() - start < 10000000000) {
+            for(gen_size_t i = 0; i < 1000; ++i) {
+                error = cio_vm_push_frame(&sampled);
+                if(error) return error;
+
+                error = cio_vm_push(&sampled);
+                if(error) return error;
+
+                sampled.current_bytecode = entrypoint->bytecode_index;
+                error = cio_vm_dispatch_call(&sampled, entrypoint->routine_index, 0);
+                if(error) return error;
+
+                error = cio_vm_pop_frame(&sampled);
+                if(error) return error;
+            }
+
+            char* folded = GEN_NULL;
+            gen_size_t folded_length = 0;
+            gen_size_t dropped = 0;
+            error = cio_vm_emit_samples(&sampled, &folded, &folded_length, &dropped);
+            if(error) return error;
+
+            // Each line is a `;`-separated stack of `identifier@module` frames, or `[native]` alone, followed by a nonzero count
+            for(gen_size_t begin = 0; begin < folded_length;) {
+                gen_size_t end = begin;
+                while(folded[end] != '\n') ++end;
+                gen_size_t space = end;
+                while(space > begin && folded[space] != ' ') --space;
+
+                error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (space > begin && space + 1 < end));
+                if(error) return error;
+
+                gen_size_t count = 0;
+                for(gen_size_t i = space + 1; i < end; ++i) {
+                    error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (folded[i] >= '0' && folded[i] <= '9'));
+                    if(error) return error;
+
+                    count = count * 10 + (gen_size_t) (folded[i] - '0');
+                }
+
+                error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (count != 0));
+                if(error) return error;
+                samples += count;
+
+                gen_bool_t native = gen_false;
+                error = gen_string_compare("[native]", sizeof("[native]"), &folded[begin], folded_length - begin, space - begin, &native);
+                if(error) return error;
+
+                if(!native || space - begin != sizeof("[native]") - 1) {
+                    for(gen_size_t frame = begin; frame < space;) {
+                        gen_size_t frame_end = frame;
+                        while(frame_end < space && folded[frame_end] != ';') ++frame_end;
+
+                        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (frame_end - frame > 2 && folded[frame_end - 2] == '@' && folded[frame_end - 1] == '0'));
+                        if(error) return error;
+
+                        frame = frame_end + 1;
+                    }
+                }
+
+                if(space - begin == sizeof(busy) - 1) {
+                    gen_bool_t matched = gen_false;
+                    error = gen_string_compare(busy, sizeof(busy), &folded[begin], folded_length - begin, space - begin, &matched);
+                    if(error) return error;
+                    if(matched) found = gen_true;
+                }
+
+                begin = end + 1;
+            }
+
+            if(folded) {
+                error = gen_memory_free((void**) &folded);
+                if(error) return error;
+            }
+        }
+
+        error = GEN_TESTS_EXPECT(gen_true, found);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (samples != 0));
+        if(error) return error;
+
+        error = cio_vm_stop_sampling(&sampled);
+        if(error) return error;
+
+        error = cio_vm_free(&sampled);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+    {
+        // Coroutine switches leave sampling unpaused, and samples taken while paused are dropped rather than recorded
+        static const char source[] =
+            "yield 0\n"
+            "worker 0\n"
+            ":\n"
+            "    yield\n"
+            "    yield\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            ":\n";
+
+        const cio_vm_settings_t settings = {.trampoline = gen_true};
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t sampled = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings, &bytecode, &sampled);
+        if(error) return error;
+
+        cio_callable_t* worker = GEN_NULL;
+        error = cio_vm_get_identifier(&sampled, "worker", &worker, gen_false);
+        if(error) return error;
+
+        // The timer is slow enough never to fire here, so only the signals raised below are sampled
+        error = cio_vm_start_sampling(&sampled, 1, 16);
+        if(error) return error;
+
+        for(gen_size_t i = 0; i < 2; ++i) {
+            error = cio_vm_start_coroutine(&sampled, worker->routine_index, GEN_NULL, 0);
+            if(error) return error;
+        }
+
+        error = cio_vm_run_coroutines(&sampled);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(gen_false, sampled.sampler->paused);
+        if(error) return error;
+
+        sampled.sampler->paused = gen_true;
+        error = GEN_TESTS_EXPECT(0, (gen_size_t) raise(SIGPROF));
+        if(error) return error;
+        sampled.sampler->paused = gen_false;
+
+        error = GEN_TESTS_EXPECT(0, (gen_size_t) raise(SIGPROF));
+        if(error) return error;
+
+        char* folded = GEN_NULL;
+        gen_size_t folded_length = 0;
+        gen_size_t dropped = 0;
+        error = cio_vm_emit_samples(&sampled, &folded, &folded_length, &dropped);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(1, dropped);
+        if(error) return error;
+
+        static const char expected[] = "[native] 1\n";
+        error = GEN_TESTS_EXPECT(sizeof(expected) - 1, folded_length);
+        if(error) return error;
+
+        gen_bool_t equal = gen_false;
+        error = gen_string_compare(expected, sizeof(expected), folded, folded_length + 1, folded_length, &equal);
+        if(error) return error;
+        error = GEN_TESTS_EXPECT(gen_true, equal);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &folded);
+        if(error) return error;
+
+        error = cio_vm_stop_sampling(&sampled);
+        if(error) return error;
+
+        error = cio_vm_free(&sampled);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+#endif
+
+    {
+        // A VM cannot be cloned while it has coroutines left to run, and its clone carries on its statistics
+        static const char source[] =
+            "idle 0\n"
+            ":\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    idle\n"
+            ":\n";
+
+        const cio_vm_settings_t settings = {.trampoline = gen_true};
+        unsigned char* bytecode = GEN_NULL;
+        cio_vm_t source_vm = {0};
+        error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings, &bytecode, &source_vm);
+        if(error) return error;
+
+        error = cio_test_run(&source_vm);
+        if(error) return error;
+
+        cio_callable_t* idle = GEN_NULL;
+        error = cio_vm_get_identifier(&source_vm, "idle", &idle, gen_false);
+        if(error) return error;
+
+        error = cio_vm_start_coroutine(&source_vm, idle->routine_index, GEN_NULL, 0);
+        if(error) return error;
+
+        cio_vm_t pending = {0};
+        gen_error_t* const pending_error = cio_vm_clone(&source_vm, &pending);
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (pending_error && pending_error->type == GEN_ERROR_BAD_OPERATION));
+        if(error) return error;
+
+        error = cio_vm_run_coroutines(&source_vm);
+        if(error) return error;
+
+        cio_vm_t clone = {0};
+        error = cio_vm_clone(&source_vm, &clone);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(source_vm.frames_used, clone.frames_used);
+        if(error) return error;
+
+#if CIO_VM_STATS
+        error = GEN_TESTS_EXPECT(source_vm.stats.cionom_calls, clone.stats.cionom_calls);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(source_vm.stats.instructions, clone.stats.instructions);
+        if(error) return error;
+#else
+        cio_vm_stats_t stats = {0};
+        gen_error_t* const stats_error = cio_vm_get_stats(&clone, &stats);
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (stats_error && stats_error->type == GEN_ERROR_NOT_IMPLEMENTED));
+        if(error) return error;
+#endif
+
+        error = cio_vm_free(&clone);
+        if(error) return error;
+
+        error = cio_vm_free(&source_vm);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &bytecode);
+        if(error) return error;
+    }
+
+#if CIO_VM_STATS
+    {
+        // Counts of a fixed program are exact, however its calls are made
+        // The entrypoint makes two calls to `leaf` and one to `+`, each `push`ing reserve space and its arguments before a `call`, then a `ret`
+        // Each `leaf` makes one call to `+` in the same way
+        static const char source[] =
+            "+ 2\n"
+            "leaf 0\n"
+            ":\n"
+            "    + 0 0\n"
+            ":\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    leaf\n"
+            "    leaf\n"
+            "    + 0 1\n"
+            ":\n";
+
+        const cio_vm_settings_t settings[] = {{0}, {.no_intrinsics = gen_true}, {.tail_calls = gen_true}, {.trampoline = gen_true}};
+        for(gen_size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+            unsigned char* bytecode = GEN_NULL;
+            cio_vm_t counted = {0};
+            error = cio_test_initialize(source, sizeof(source) - 1, 1024, &settings[i], &bytecode, &counted);
+            if(error) return error;
+
+            error = cio_test_run(&counted);
+            if(error) return error;
+
+            cio_vm_stats_t stats = {0};
+            error = cio_vm_get_stats(&counted, &stats);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(3, stats.cionom_calls);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(3, stats.external_calls);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(0, stats.cross_module_calls);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(11, stats.pushes);
+            if(error) return error;
+
+            error = GEN_TESTS_EXPECT(19, stats.instructions);
+            if(error) return error;
+
+            error = cio_vm_free(&counted);
+            if(error) return error;
+
+            error = gen_memory_free((void**) &bytecode);
+            if(error) return error;
+        }
+    }
+#endif
+
+    {
+        // Images loaded from a file hold its contents for as long as any VM initialized from them
+        static const char source[] =
+            "copy= 2\n"
+            "__cionom_entrypoint 0\n"
+            ":\n"
+            "    copy= 0 42\n"
+            ":\n";
+
+        unsigned char* emitted = GEN_NULL;
+        gen_size_t emitted_length = 0;
+        error = cio_test_compile(source, sizeof(source) - 1, &emitted, &emitted_length);
+        if(error) return error;
+
+        static const char path[] = "cio_test_image.ibc";
+        error = cio_test_write_file(path, emitted, emitted_length);
+        if(error) return error;
+
+        error = gen_memory_free((void**) &emitted);
+        if(error) return error;
+
+        cio_image_t* image = GEN_NULL;
+        error = cio_image_initialize_from_file(path, gen_true, gen_false, &cio_test_warning_settings, GEN_NULL, &image);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(emitted_length, image->file_length);
+        if(error) return error;
+
+        cio_vm_t first = {0};
+        error = cio_vm_initialize_from_image(image, 1024, &first);
+        if(error) return error;
+
+        cio_vm_t second = {0};
+        error = cio_vm_initialize_from_image(image, 1024, &second);
+        if(error) return error;
+
+        error = cio_image_release(image);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT((void*) first.bytecode, (void*) second.bytecode);
+        if(error) return error;
+
+        // The image holds its own reference to the contents, so the file may be deleted while it is in use
+        error = gen_filesystem_path_delete(path, GEN_STRING_NO_BOUNDS);
+        if(error) return error;
+
+        // Each VM has its own stack over the shared image
+        error = cio_test_run(&first);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(42, first.stack[1]);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(0, second.stack[1]);
+        if(error) return error;
+
+        error = cio_vm_free(&first);
+        if(error) return error;
+
+        error = cio_test_run(&second);
+        if(error) return error;
+
+        error = GEN_TESTS_EXPECT(42, second.stack[1]);
+        if(error) return error;
+
+        error = cio_vm_free(&second);
+        if(error) return error;
+
+        // Neither a missing nor an empty file leaves an image behind
+        cio_image_t* missing = GEN_NULL;
+        gen_error_t* const missing_error = cio_image_initialize_from_file(path, gen_true, gen_false, &cio_test_warning_settings, GEN_NULL, &missing);
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (missing_error && !missing));
+        if(error) return error;
+
+        error = cio_test_write_file(path, GEN_NULL, 0);
+        if(error) return error;
+
+        cio_image_t* empty = GEN_NULL;
+        gen_error_t* const empty_error = cio_image_initialize_from_file(path, gen_true, gen_false, &cio_test_warning_settings, GEN_NULL, &empty);
+        error = GEN_TESTS_EXPECT(gen_true, (gen_bool_t) (empty_error && empty_error->type == GEN_ERROR_BAD_CONTENT && !empty));
+        if(error) return error;
+
+        error = gen_filesystem_path_delete(path, GEN_STRING_NO_BOUNDS);
+        if(error) return error;
+    }
+
     return GEN_NULL;
 }